@@ -71,6 +71,27 @@ class FRAMELESSHELPER_CORE_API ChromePalette : public QObject
                NOTIFY closeButtonPressColorChanged FINAL)
 
 public:
+    enum class ChangeFlag : quint16
+    {
+        None = 0,
+        TitleBarActiveBackgroundColor = 1 << 0,
+        TitleBarInactiveBackgroundColor = 1 << 1,
+        TitleBarActiveForegroundColor = 1 << 2,
+        TitleBarInactiveForegroundColor = 1 << 3,
+        ChromeButtonNormalColor = 1 << 4,
+        ChromeButtonHoverColor = 1 << 5,
+        ChromeButtonPressColor = 1 << 6,
+        CloseButtonNormalColor = 1 << 7,
+        CloseButtonHoverColor = 1 << 8,
+        CloseButtonPressColor = 1 << 9,
+        TitleBarColors = 0x000F,
+        ChromeButtonColors = 0x03F0,
+        All = 0x03FF
+    };
+    Q_ENUM(ChangeFlag)
+    Q_DECLARE_FLAGS(Changes, ChangeFlag)
+    Q_FLAG(Changes)
+
     explicit ChromePalette(QObject *parent = nullptr);
     ~ChromePalette() override;
 
@@ -85,6 +106,11 @@ public:
     Q_NODISCARD QColor closeButtonHoverColor() const;
     Q_NODISCARD QColor closeButtonPressColor() const;
 
+    // Changes made between beginUpdate() and endUpdate() are merged and notified only once.
+    // The calls can be nested, the notifications are sent when the outermost one ends.
+    void beginUpdate();
+    void endUpdate();
+
 public Q_SLOTS:
     void setTitleBarActiveBackgroundColor(const QColor &value);
     void resetTitleBarActiveBackgroundColor();
@@ -120,11 +146,14 @@ Q_SIGNALS:
     void closeButtonPressColorChanged();
     void titleBarColorChanged();
     void chromeButtonColorChanged();
+    void changed(const ChromePalette::Changes changes);
 
 private:
     QScopedPointer<ChromePalettePrivate> d_ptr;
 };
 
+Q_DECLARE_OPERATORS_FOR_FLAGS(ChromePalette::Changes)
+
 FRAMELESSHELPER_END_NAMESPACE
 
 #endif
@@ -94,6 +94,27 @@ using xcb_generic_error_t = struct xcb_generic_error_t
     uint32_t full_sequence;
 };
 
+using xcb_generic_event_t = struct xcb_generic_event_t
+{
+    uint8_t response_type;
+    uint8_t pad0;
+    uint16_t sequence;
+    uint32_t pad[7];
+    uint32_t full_sequence;
+};
+
+using xcb_property_notify_event_t = struct xcb_property_notify_event_t
+{
+    uint8_t response_type;
+    uint8_t pad0;
+    uint16_t sequence;
+    xcb_window_t window;
+    xcb_atom_t atom;
+    xcb_timestamp_t time;
+    uint8_t state;
+    uint8_t pad1[3];
+};
+
 using xcb_client_message_data_t = union xcb_client_message_data_t
 {
     uint8_t data8[20];
@@ -193,6 +214,9 @@ using xcb_list_properties_reply_t = struct xcb_list_properties_reply_t
 [[maybe_unused]] inline constexpr const auto XCB_BUTTON_INDEX_2 = 2;
 [[maybe_unused]] inline constexpr const auto XCB_BUTTON_INDEX_3 = 3;
 [[maybe_unused]] inline constexpr const auto XCB_BUTTON_RELEASE = 5;
+[[maybe_unused]] inline constexpr const auto XCB_PROPERTY_NOTIFY = 28;
+[[maybe_unused]] inline constexpr const auto XCB_PROPERTY_NEW_VALUE = 0;
+[[maybe_unused]] inline constexpr const auto XCB_PROPERTY_DELETE = 1;
 [[maybe_unused]] inline constexpr const auto XCB_CLIENT_MESSAGE = 33;
 [[maybe_unused]] inline constexpr const auto XCB_EVENT_MASK_STRUCTURE_NOTIFY = 131072;
 [[maybe_unused]] inline constexpr const auto XCB_EVENT_MASK_SUBSTRUCTURE_REDIRECT = 1048576;
@@ -345,6 +369,12 @@ xcb_get_property_unchecked(
     uint32_t long_length
 );
 
+FRAMELESSHELPER_CORE_API void
+xcb_discard_reply(
+    xcb_connection_t *connection,
+    unsigned int sequence
+);
+
 } // extern "C"
 #endif // FRAMELESSHELPER_HAS_XCB
 
@@ -372,11 +402,13 @@ xcb_get_property_unchecked(
  * GTK+ at ftp://ftp.gtk.org/pub/gtk/.
  */
 
-#if __has_include(<gtk/gtk.h>)
+// Only when asked for explicitly (FRAMELESSHELPER_LINK_GTK), linking to GTK loads it
+// at startup even if nobody needs it.
+#if (defined(FRAMELESSHELPER_LINK_GTK) && __has_include(<gtk/gtk.h>))
 #  undef signals // Workaround a compilation issue caused by GTK.
 #  include <gtk/gtk.h>
 #  define FRAMELESSHELPER_HAS_GTK
-#else // !__has_include(<gtk/gtk.h>)
+#else // (!defined(FRAMELESSHELPER_LINK_GTK) || !__has_include(<gtk/gtk.h>))
 
 #define G_VALUE_INIT  { 0, { { 0 } } }
 #define g_signal_connect(instance, detailed_signal, c_handler, data) \
@@ -432,7 +464,7 @@ struct _GValue
         gpointer v_pointer;
     } data[2];
 };
-#endif // __has_include(<gtk/gtk.h>)
+#endif // (defined(FRAMELESSHELPER_LINK_GTK) && __has_include(<gtk/gtk.h>))
 
 [[maybe_unused]] inline constexpr const char GTK_THEME_NAME_ENV_VAR[] = "GTK_THEME";
 [[maybe_unused]] inline constexpr const char GTK_THEME_NAME_PROP[] = "gtk-theme-name";
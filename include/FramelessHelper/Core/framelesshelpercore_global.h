@@ -32,6 +32,7 @@
 #include <QtCore/qrect.h>
 #include <QtCore/qobject.h>
 #include <QtCore/qpointer.h>
+#include <QtCore/qlist.h>
 #include <QtGui/qcolor.h>
 #include <QtGui/qwindowdefs.h>
 
@@ -313,6 +314,14 @@ Q_NAMESPACE_EXPORT(FRAMELESSHELPER_CORE_API)
 [[maybe_unused]] inline constexpr const char kSysMenuDisableMinimizeVar[] = "FRAMELESSHELPER_SYSTEM_MENU_DISABLE_MINIMIZE";
 [[maybe_unused]] inline constexpr const char kSysMenuDisableMaximizeVar[] = "FRAMELESSHELPER_SYSTEM_MENU_DISABLE_MAXIMIZE";
 [[maybe_unused]] inline constexpr const char kSysMenuDisableRestoreVar[] = "FRAMELESSHELPER_SYSTEM_MENU_DISABLE_RESTORE";
+[[maybe_unused]] inline constexpr const char kResizeBorderThicknessVar[] = "FRAMELESSHELPER_RESIZE_BORDER_THICKNESS";
+[[maybe_unused]] inline constexpr const char kResizeBorderCornerSizeVar[] = "FRAMELESSHELPER_RESIZE_BORDER_CORNER_SIZE";
+[[maybe_unused]] inline constexpr const char kResizableEdgesVar[] = "FRAMELESSHELPER_RESIZABLE_EDGES";
+[[maybe_unused]] inline constexpr const char kHoverCoalesceIntervalVar[] = "FRAMELESSHELPER_HOVER_COALESCE_INTERVAL";
+[[maybe_unused]] inline constexpr const char kSystemChangeDebounceIntervalVar[] = "FRAMELESSHELPER_SYSTEM_CHANGE_DEBOUNCE_INTERVAL";
+[[maybe_unused]] inline constexpr const char kTraceFileVar[] = "FRAMELESSHELPER_TRACE_FILE";
+[[maybe_unused]] inline constexpr const char kFlightRecorderFileVar[] = "FRAMELESSHELPER_FLIGHT_RECORDER_FILE";
+[[maybe_unused]] inline constexpr const char kForceXcbBackendVar[] = "FRAMELESSHELPER_FORCE_XCB_BACKEND";
 
 enum class Option : quint8
 {
@@ -327,7 +336,11 @@ enum class Option : quint8
     DisableLazyInitializationForMicaMaterial,
     ForceNativeBackgroundBlur,
     WindowUseSquareCorners,
-    Last = WindowUseSquareCorners
+    CoalesceHoverMouseMoves,
+    EnableTracing,
+    EnableConfigHotReload,
+    UseGtkThemeDetection,
+    Last = UseGtkThemeDetection
 };
 Q_ENUM_NS(Option)
 
@@ -549,6 +562,49 @@ struct Dpi
     }
 };
 
+struct LatencyHistogram
+{
+    // Bucket N counts the samples in [2^N, 2^(N+1)) microseconds, the first
+    // bucket also takes everything below 1us and the last one everything above.
+    static constexpr const int kBucketCount = 16;
+
+    quint64 count = 0;
+    quint64 totalNanoseconds = 0;
+    quint64 maximumNanoseconds = 0;
+    quint64 buckets[kBucketCount] = {};
+};
+
+struct WindowStatistics
+{
+    WId windowId = 0;
+    quint64 eventsFiltered = 0;
+    quint64 hitTests = 0;
+};
+
+struct Statistics
+{
+    QList<WindowStatistics> windows = {};
+    quint64 eventsFiltered = 0;
+    quint64 hitTests = 0;
+    quint64 paletteRepaints = 0;
+    quint64 micaRepaints = 0;
+    quint64 borderRepaints = 0;
+    quint64 sysApiResolutions = 0;
+    quint64 sysApiCacheHits = 0;
+    quint64 x11RoundTrips = 0;
+    quint64 x11Flushes = 0;
+    quint64 x11RequestsMerged = 0;
+    quint64 systemChangesReceived = 0;
+    quint64 systemChangesDelivered = 0;
+    quint64 systemChangesFolded = 0;
+    LatencyHistogram eventFilterTime = {};
+    LatencyHistogram wallpaperLoadTime = {};
+    LatencyHistogram wallpaperScaleTime = {};
+    LatencyHistogram wallpaperBlurTime = {};
+    LatencyHistogram sysApiResolveTime = {};
+    LatencyHistogram sysApiPrefetchTime = {};
+};
+
 } // namespace Global
 
 FRAMELESSHELPER_CORE_API void FramelessHelperCoreInitialize();
@@ -556,6 +612,8 @@ FRAMELESSHELPER_CORE_API void FramelessHelperCoreUninitialize();
 [[nodiscard]] FRAMELESSHELPER_CORE_API Global::VersionInfo FramelessHelperVersion();
 FRAMELESSHELPER_CORE_API void FramelessHelperEnableThemeAware();
 FRAMELESSHELPER_CORE_API void FramelessHelperPrintLogo();
+FRAMELESSHELPER_CORE_API bool FramelessHelperDumpTrace(const QString &filePath = {});
+FRAMELESSHELPER_CORE_API bool FramelessHelperDumpFlightRecorder(const QString &filePath = {});
 
 namespace FramelessHelper::Core
 {
@@ -564,6 +622,8 @@ inline void uninitialize() { FramelessHelperCoreUninitialize(); }
 [[nodiscard]] inline Global::VersionInfo version() { return FramelessHelperVersion(); }
 inline void setApplicationOSThemeAware() { FramelessHelperEnableThemeAware(); }
 inline void outputLogo() { FramelessHelperPrintLogo(); }
+inline bool dumpTrace(const QString &filePath = {}) { return FramelessHelperDumpTrace(filePath); }
+inline bool dumpFlightRecorder(const QString &filePath = {}) { return FramelessHelperDumpFlightRecorder(filePath); }
 } // namespace FramelessHelper::Core
 
 FRAMELESSHELPER_END_NAMESPACE
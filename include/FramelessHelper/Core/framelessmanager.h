@@ -50,6 +50,9 @@ public:
     Q_NODISCARD QString wallpaper() const;
     Q_NODISCARD Global::WallpaperAspectStyle wallpaperAspectStyle() const;
 
+    // A consistent enough copy of the internal counters, cheap to take at any time.
+    Q_NODISCARD static Global::Statistics statistics();
+
 public Q_SLOTS:
     void addWindow(const SystemParameters *params);
     void removeWindow(const WId windowId);
@@ -58,6 +61,8 @@ public Q_SLOTS:
 Q_SIGNALS:
     void systemThemeChanged();
     void wallpaperChanged();
+    // Only emitted on X11 so far, when the window manager has been restarted or replaced.
+    void windowManagerCapabilitiesChanged();
 
 private:
     explicit FramelessManager(QObject *parent = nullptr);
@@ -24,7 +24,7 @@
 
 #pragma once
 
-#include <FramelessHelper/Core/framelesshelpercore_global.h>
+#include <FramelessHelper/Core/chromepalette.h>
 #include <optional>
 
 #if FRAMELESSHELPER_CONFIG(titlebar)
@@ -49,7 +49,12 @@ public:
 
     Q_SLOT void refresh();
 
+    void markChanged(const ChromePalette::Changes changes);
+    void flushChanges();
+
     ChromePalette *q_ptr = nullptr;
+    int updateDepth = 0;
+    ChromePalette::Changes pendingChanges = {};
     // System-defined ones:
     QColor titleBarActiveBackgroundColor_sys = {};
     QColor titleBarInactiveBackgroundColor_sys = {};
@@ -0,0 +1,76 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021-2023 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <FramelessHelper/Core/framelesshelpercore_global.h>
+
+FRAMELESSHELPER_BEGIN_NAMESPACE
+
+// Always-on flight recorder: a fixed-size ring of compact binary events which
+// keeps the most recent history even in release builds without any debug output.
+// Recording is lock free and wait free, the oldest events are simply overwritten.
+namespace FlightRecorder
+{
+
+enum class Event : quint16
+{
+    Invalid,
+    WindowAdded,
+    WindowRemoved,
+    WindowStateChanged, // arg1: Qt::WindowState
+    HitTestAtPress, // arg1: HitTestResult, arg2: button number (1: left, 2: right, 3: middle, 4+: extra)
+    ThemeChanged, // arg1: ARGB accent color, arg2: SystemTheme
+    WallpaperChanged, // arg1: WallpaperAspectStyle
+    SysApiFailure, // arg1: index of the failed symbol name, see symbolName()
+    Last = SysApiFailure
+};
+
+// 32 bytes per record, written to the file as is by dumpRaw().
+struct Record
+{
+    quint64 sequence = 0;
+    quint64 timestamp = 0; // ns since the recorder was first used
+    quint64 windowId = 0;
+    quint16 event = 0;
+    quint16 arg2 = 0;
+    quint32 arg1 = 0;
+};
+static_assert(sizeof(Record) == 32);
+
+FRAMELESSHELPER_CORE_API void record(const Event event, const WId windowId = 0, const quint32 arg1 = 0, const quint16 arg2 = 0) noexcept;
+
+// For events which need a string, the string is stored once and only its index is recorded.
+[[nodiscard]] FRAMELESSHELPER_CORE_API quint32 internSymbolName(const QString &name);
+[[nodiscard]] FRAMELESSHELPER_CORE_API QString symbolName(const quint32 index);
+
+// Human readable dump, oldest event first.
+FRAMELESSHELPER_CORE_API bool dump(const QString &filePath);
+// Async-signal-safe binary dump, meant to be called from a crash handler: a 16 bytes
+// header ("FHFR", version, record count) followed by the records, oldest first.
+FRAMELESSHELPER_CORE_API bool dumpRaw(const int fd) noexcept;
+
+} // namespace FlightRecorder
+
+FRAMELESSHELPER_END_NAMESPACE
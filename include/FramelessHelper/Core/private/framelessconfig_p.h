@@ -25,6 +25,12 @@
 #pragma once
 
 #include <FramelessHelper/Core/framelesshelpercore_global.h>
+#include <atomic>
+
+QT_BEGIN_NAMESPACE
+class QFileSystemWatcher;
+class QTimer;
+QT_END_NAMESPACE
 
 FRAMELESSHELPER_BEGIN_NAMESPACE
 
@@ -35,6 +41,20 @@ class FRAMELESSHELPER_CORE_API FramelessConfig : public QObject
     Q_DISABLE_COPY_MOVE(FramelessConfig)
 
 public:
+    // All options are published together as one immutable value, reading it is a
+    // single atomic load. The version starts at 1 and increases whenever any option
+    // actually changes, so derived results can be cached and re-validated cheaply.
+    struct Snapshot
+    {
+        quint32 version = 0;
+        quint32 options = 0;
+
+        Q_NODISCARD bool isSet(const Global::Option option) const
+        {
+            return (options & (quint32(1) << static_cast<int>(option)));
+        }
+    };
+
     Q_NODISCARD static FramelessConfig *instance();
 
     void reload(const bool force = false);
@@ -42,12 +62,60 @@ public:
     void set(const Global::Option option, const bool on = true);
     Q_NODISCARD bool isSet(const Global::Option option) const;
 
+    Q_NODISCARD static Snapshot snapshot();
+    Q_NODISCARD static quint32 version();
+    // Whether the options have been loaded already. Unlike the other functions this
+    // never creates the instance, so it's safe to call from any thread.
+    Q_NODISCARD static bool isLoaded();
+
     static void setLoadFromEnvironmentVariablesDisabled(const bool on = true);
     static void setLoadFromConfigurationFileDisabled(const bool on = true);
 
+Q_SIGNALS:
+    void optionsChanged();
+
 private:
     explicit FramelessConfig(QObject *parent = nullptr);
     ~FramelessConfig() override;
+
+    // Watches the configuration file while Option::EnableConfigHotReload is set and
+    // reloads it whenever it changes on disk. Options changed through set() keep
+    // taking precedence over the file.
+    void updateHotReload();
+    void rewatchConfigurationFile();
+
+private:
+    QFileSystemWatcher *m_watcher = nullptr;
+    QTimer *m_reloadTimer = nullptr;
+};
+
+// A boolean derived from the options (and possibly other immutable facts) which
+// is only recomputed after the configuration has changed. Replaces the
+// function-local statics that used to cache such decisions forever.
+class ConfigDerivedFlag
+{
+    Q_DISABLE_COPY_MOVE(ConfigDerivedFlag)
+
+public:
+    ConfigDerivedFlag() = default;
+    ~ConfigDerivedFlag() = default;
+
+    template <typename Compute>
+    Q_NODISCARD bool value(Compute &&compute)
+    {
+        const quint64 version = FramelessConfig::version();
+        const quint64 state = m_state.load(std::memory_order_acquire);
+        if ((state >> 1) == version) {
+            return (state & 1);
+        }
+        // Racing threads compute the same result, whoever stores last wins.
+        const bool result = compute();
+        m_state.store((version << 1) | quint64(result), std::memory_order_release);
+        return result;
+    }
+
+private:
+    std::atomic<quint64> m_state{ 0 };
 };
 
 FRAMELESSHELPER_END_NAMESPACE
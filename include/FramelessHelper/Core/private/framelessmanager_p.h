@@ -25,13 +25,47 @@
 #pragma once
 
 #include <FramelessHelper/Core/framelesshelpercore_global.h>
+#include <FramelessHelper/Core/private/themesnapshot_p.h>
 #include <QtCore/qtimer.h>
 #include <optional>
+#include <future>
+
+QT_BEGIN_NAMESPACE
+class QFileSystemWatcher;
+QT_END_NAMESPACE
 
 FRAMELESSHELPER_BEGIN_NAMESPACE
 
 struct SystemParameters;
 class FramelessManager;
+#if (defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID))
+class SettingsPortal;
+#endif
+
+// The first change is delivered right away, all the following changes arriving
+// within the debounce window are folded into one trailing delivery.
+struct ChangeDebouncer
+{
+    QTimer timer{};
+    bool windowOpen = false;
+    bool pending = false;
+    quint64 rawCount = 0;
+    quint64 deliveredCount = 0;
+
+    Q_NODISCARD quint64 foldedCount() const
+    {
+        return (rawCount - deliveredCount);
+    }
+};
+
+struct SystemState
+{
+    Global::SystemTheme theme = Global::SystemTheme::Unknown;
+    QColor accentColor = {};
+#ifdef Q_OS_WINDOWS
+    Global::DwmColorizationArea colorizationArea = Global::DwmColorizationArea::None;
+#endif
+};
 
 class FRAMELESSHELPER_CORE_API FramelessManagerPrivate : public QObject
 {
@@ -55,11 +89,34 @@ public:
 
     Q_NODISCARD bool isThemeOverrided() const;
 
+    Q_NODISCARD ThemeSnapshotPtr themeSnapshot() const;
+    Q_NODISCARD static ThemeSnapshotPtr currentThemeSnapshot();
+    void invalidateThemeSnapshot();
+
     void initialize();
 
     void doNotifySystemThemeHasChangedOrNot();
     void doNotifyWallpaperHasChangedOrNot();
 
+    Q_NODISCARD static SystemState probeSystemState();
+    void startSystemStateProbe();
+#ifdef Q_OS_WINDOWS
+    Q_NODISCARD static SystemState probeSystemStateInBackground();
+#endif
+    void ensureSystemState();
+    void ensureWallpaper();
+#if (defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID))
+    void watchWallpaper();
+    void rewatchWallpaper();
+    void watchTheme();
+    static void rewatchFiles(QFileSystemWatcher *watcher, const QStringList &files);
+#endif
+    Q_NODISCARD bool applySystemState(const SystemState &state);
+
+    using ChangeHandler = void (FramelessManagerPrivate::*)();
+    void setupDebouncer(ChangeDebouncer &debouncer, const ChangeHandler handler);
+    void debounce(ChangeDebouncer &debouncer, const ChangeHandler handler);
+
     FramelessManager *q_ptr = nullptr;
     Global::SystemTheme systemTheme = Global::SystemTheme::Unknown;
     std::optional<Global::SystemTheme> overrideTheme = std::nullopt;
@@ -69,8 +126,20 @@ public:
 #endif
     QString wallpaper = {};
     Global::WallpaperAspectStyle wallpaperAspectStyle = Global::WallpaperAspectStyle::Fill;
-    QTimer themeTimer{};
-    QTimer wallpaperTimer{};
+#ifdef Q_OS_WINDOWS
+    std::shared_future<SystemState> systemStateProbe = {};
+#endif
+    bool systemStateReady = false;
+    bool wallpaperReady = false;
+    ChangeDebouncer themeDebouncer{};
+    ChangeDebouncer wallpaperDebouncer{};
+#if (defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID))
+    QFileSystemWatcher *wallpaperWatcher = nullptr;
+    QFileSystemWatcher *themeWatcher = nullptr;
+    SettingsPortal *settingsPortal = nullptr;
+#endif
+    mutable ThemeSnapshotPtr cachedThemeSnapshot = nullptr;
+    mutable quint64 themeSnapshotVersion = 0;
 };
 
 FRAMELESSHELPER_END_NAMESPACE
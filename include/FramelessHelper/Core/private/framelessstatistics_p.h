@@ -0,0 +1,122 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021-2023 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <FramelessHelper/Core/framelesshelpercore_global.h>
+#include <QtCore/qelapsedtimer.h>
+#include <atomic>
+#include <memory>
+
+FRAMELESSHELPER_BEGIN_NAMESPACE
+
+// Always-on, lock-free counters for the hot paths. Everything here only uses
+// relaxed atomics, the numbers are meant for telemetry, not for synchronization.
+namespace Stats
+{
+
+enum class Counter : quint8
+{
+    EventsFiltered,
+    HitTests,
+    PaletteRepaints,
+    MicaRepaints,
+    BorderRepaints,
+    SysApiResolutions,
+    SysApiCacheHits,
+    X11RoundTrips,
+    X11Flushes,
+    X11RequestsMerged,
+    SystemChangesReceived, // Raw theme and wallpaper change notifications.
+    SystemChangesDelivered, // The ones left after debouncing.
+    SystemChangesFolded, // The ones superseded by a later one within the debounce window.
+    Last = SystemChangesFolded
+};
+
+enum class Latency : quint8
+{
+    EventFilter,
+    WallpaperLoad,
+    WallpaperScale,
+    WallpaperBlur,
+    SysApiResolve, // A single symbol, including loading its library the first time.
+    SysApiPrefetch, // The whole background batch, see SysApiLoader::prefetch().
+    Last = SysApiPrefetch
+};
+
+struct WindowCounters
+{
+    std::atomic<quint64> eventsFiltered{ 0 };
+    std::atomic<quint64> hitTests{ 0 };
+};
+using WindowCountersPtr = std::shared_ptr<WindowCounters>;
+
+FRAMELESSHELPER_CORE_API void increment(const Counter counter, const quint64 value = 1) noexcept;
+FRAMELESSHELPER_CORE_API void record(const Latency latency, const quint64 nanoseconds) noexcept;
+
+// Both backends of the same window share the same counters.
+[[nodiscard]] FRAMELESSHELPER_CORE_API WindowCountersPtr windowCounters(const WId windowId);
+FRAMELESSHELPER_CORE_API void removeWindow(const WId windowId);
+
+[[nodiscard]] FRAMELESSHELPER_CORE_API Global::Statistics snapshot();
+
+inline void countEvent(const WindowCountersPtr &window) noexcept
+{
+    increment(Counter::EventsFiltered);
+    if (window) {
+        window->eventsFiltered.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+inline void countHitTest(const WindowCountersPtr &window) noexcept
+{
+    increment(Counter::HitTests);
+    if (window) {
+        window->hitTests.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+class ScopedLatency
+{
+    Q_DISABLE_COPY_MOVE(ScopedLatency)
+
+public:
+    explicit ScopedLatency(const Latency latency) noexcept : m_latency(latency)
+    {
+        m_timer.start();
+    }
+
+    ~ScopedLatency()
+    {
+        record(m_latency, quint64(m_timer.nsecsElapsed()));
+    }
+
+private:
+    Latency m_latency = Latency::EventFilter;
+    QElapsedTimer m_timer = {};
+};
+
+} // namespace Stats
+
+FRAMELESSHELPER_END_NAMESPACE
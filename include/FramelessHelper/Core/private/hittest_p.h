@@ -0,0 +1,129 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021-2023 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <FramelessHelper/Core/framelesshelpercore_global.h>
+#include <array>
+
+FRAMELESSHELPER_BEGIN_NAMESPACE
+
+struct SystemParameters;
+
+// Platform neutral non-client hit test decision, shared by the Qt and Win32 backends.
+// Everything here works on plain values only, it never touches the window system
+// and never allocates, so the same code can be exercised anywhere. The only exception
+// is readResizeBorderSettings(), which both backends use to read the window's settings.
+
+enum class HitTestResult : quint8
+{
+    Client,
+    Caption,
+    SystemMenu,
+    Help,
+    Minimize,
+    Maximize,
+    Close,
+    Border,
+    Top,
+    Bottom,
+    Left,
+    Right,
+    TopLeft,
+    TopRight,
+    BottomLeft,
+    BottomRight,
+    Nowhere,
+    // Something the platform reported that has no portable equivalent (HTTRANSPARENT
+    // or HTVSCROLL for example), the backend passes its own value through unchanged.
+    Native
+};
+
+struct ResizeBorderSettings
+{
+    // In logical pixels.
+    int thickness = Global::kDefaultResizeBorderThickness;
+    int cornerSize = Global::kDefaultResizeBorderThickness;
+    Qt::Edges edges = (Qt::TopEdge | Qt::BottomEdge | Qt::LeftEdge | Qt::RightEdge);
+};
+
+// The resize border of one window, split into 5x5 bands along each axis and
+// precomputed in device pixels, so that testing a point is just a table lookup.
+// It needs to be updated whenever the window size or the DPR changes.
+struct FRAMELESSHELPER_CORE_API ResizeBorderBands
+{
+    qreal devicePixelRatio = 1;
+    std::array<int, 4> horizontal = {};
+    std::array<int, 4> vertical = {};
+    std::array<HitTestResult, 25> table = {};
+
+    void update(const ResizeBorderSettings &settings, const QSize &logicalSize, const qreal dpr) noexcept;
+    void updateNative(const ResizeBorderSettings &settings, const QSize &nativeSize, const qreal dpr) noexcept;
+    [[nodiscard]] QPoint mapToNative(const QPointF &logicalPos) const noexcept;
+    [[nodiscard]] HitTestResult lookup(const QPointF &logicalPos) const noexcept;
+    [[nodiscard]] HitTestResult lookupNative(const QPoint &nativePos) const noexcept;
+};
+
+struct HitTestSnapshot
+{
+    // All geometry must be in the same coordinate space as the point being tested.
+    QSize size = {};
+    int resizeBorderThicknessX = 0;
+    int resizeBorderThicknessY = 0;
+    // Widen the left/right resize areas on the top and bottom edges to make the corners easier to grab.
+    qreal cornerScaleFactor = 1;
+    // When set, the resize border comes from these precomputed bands instead of the
+    // thickness and scale factor above, and the point must be in device pixels.
+    const ResizeBorderBands *resizeBorder = nullptr;
+    // Allow resizing from the top and right edges even above the system buttons.
+    int systemButtonResizeBorder = 0;
+    Global::SystemButtonType systemButton = Global::SystemButtonType::Unknown;
+    // What the platform thinks about this point, only used when the native frame border is visible.
+    HitTestResult nativeResult = HitTestResult::Client;
+    bool insideSystemButton = false;
+    bool insideTitleBar = false;
+    bool maximized = false;
+    bool fullScreen = false;
+    bool fixedSize = false;
+    bool dontOverrideCursor = false;
+    bool frameBorderVisible = false;
+};
+
+namespace HitTest
+{
+
+[[nodiscard]] FRAMELESSHELPER_CORE_API HitTestResult evaluate(const HitTestSnapshot &snapshot, const QPoint &pos) noexcept;
+[[nodiscard]] FRAMELESSHELPER_CORE_API Qt::Edges toWindowEdges(const HitTestResult result) noexcept;
+[[nodiscard]] FRAMELESSHELPER_CORE_API Qt::CursorShape toCursorShape(const HitTestResult result) noexcept;
+
+// The window's kResizeBorderThicknessVar, kResizeBorderCornerSizeVar and kResizableEdgesVar
+// properties, the given defaults are used for the ones that are not set.
+[[nodiscard]] FRAMELESSHELPER_CORE_API ResizeBorderSettings readResizeBorderSettings
+    (const SystemParameters &params, const ResizeBorderSettings &defaults = {});
+// Whether changing the given dynamic property affects readResizeBorderSettings().
+[[nodiscard]] FRAMELESSHELPER_CORE_API bool isResizeBorderProperty(const QByteArray &name) noexcept;
+
+} // namespace HitTest
+
+FRAMELESSHELPER_END_NAMESPACE
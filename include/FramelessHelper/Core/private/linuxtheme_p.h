@@ -0,0 +1,102 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021-2023 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <FramelessHelper/Core/framelesshelpercore_global.h>
+
+#if (defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID))
+
+#include <QtCore/qstringlist.h>
+#include <array>
+#include <optional>
+
+FRAMELESSHELPER_BEGIN_NAMESPACE
+
+// Theme detection without loading GTK into the process: the settings files of
+// GTK and KDE are parsed directly, and the freedesktop settings portal is asked
+// when it's around. Loading libgtk just to read two settings costs tens of
+// milliseconds and several megabytes, so the GTK based detection is only used
+// when Option::UseGtkThemeDetection is set.
+namespace LinuxTheme
+{
+
+struct ThemeHints
+{
+    std::optional<bool> dark = std::nullopt;
+    std::optional<QColor> accentColor = std::nullopt;
+    std::optional<bool> titleBarColorized = std::nullopt;
+
+    // Takes the values this instance doesn't know yet from the other one.
+    void fillFrom(const ThemeHints &other)
+    {
+        if (!dark.has_value()) {
+            dark = other.dark;
+        }
+        if (!accentColor.has_value()) {
+            accentColor = other.accentColor;
+        }
+        if (!titleBarColorized.has_value()) {
+            titleBarColorized = other.titleBarColorized;
+        }
+    }
+
+    Q_NODISCARD bool isComplete() const
+    {
+        return (dark.has_value() && accentColor.has_value() && titleBarColorized.has_value());
+    }
+};
+
+// GTK_THEME, such as "Adwaita:dark".
+[[nodiscard]] FRAMELESSHELPER_CORE_API ThemeHints parseGtkThemeEnv(const QString &value);
+// ~/.config/gtk-3.0/settings.ini and ~/.config/gtk-4.0/settings.ini.
+[[nodiscard]] FRAMELESSHELPER_CORE_API ThemeHints parseGtkSettingsIni(const QByteArray &data);
+// ~/.config/kdeglobals.
+[[nodiscard]] FRAMELESSHELPER_CORE_API ThemeHints parseKdeGlobals(const QByteArray &data);
+// ~/.config/dconf/user, the "color-scheme" and "gtk-theme" keys of /org/gnome/desktop/interface/.
+// This is where GNOME keeps them, the GTK settings files are rarely written there.
+[[nodiscard]] FRAMELESSHELPER_CORE_API ThemeHints parseDconfUser(const QByteArray &data);
+// The "org.freedesktop.appearance" namespace of the settings portal: color-scheme is
+// 0 (no preference), 1 (dark) or 2 (light), the accent color components are within
+// [0, 1], anything else means the accent color is not set.
+[[nodiscard]] FRAMELESSHELPER_CORE_API ThemeHints parsePortalAppearance
+    (const std::optional<quint32> &colorScheme, const std::optional<std::array<qreal, 3>> &accentColor);
+
+// The last answer of the settings portal, see SettingsPortal.
+FRAMELESSHELPER_CORE_API void setPortalHints(const ThemeHints &hints);
+[[nodiscard]] FRAMELESSHELPER_CORE_API ThemeHints portalHints();
+
+// The files current() reads, most relevant first. They don't have to exist.
+[[nodiscard]] FRAMELESSHELPER_CORE_API QStringList configFiles();
+
+// GTK_THEME first (it's meant to override everything else), then the portal,
+// then the settings files (kdeglobals first on KDE, dconf and the GTK files first elsewhere).
+// Asking GTK itself is left to the callers, as the last resort.
+[[nodiscard]] FRAMELESSHELPER_CORE_API ThemeHints current();
+
+} // namespace LinuxTheme
+
+FRAMELESSHELPER_END_NAMESPACE
+
+#endif // (defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID))
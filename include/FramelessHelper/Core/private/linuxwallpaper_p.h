@@ -0,0 +1,101 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021-2023 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <FramelessHelper/Core/framelesshelpercore_global.h>
+
+#if (defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID))
+
+#include <QtCore/qhash.h>
+#include <QtCore/qstringlist.h>
+
+FRAMELESSHELPER_BEGIN_NAMESPACE
+
+// Reads the wallpaper settings of the common Linux desktops straight from their
+// configuration files: no D-Bus, no helper processes and no desktop libraries.
+// The parse*() functions only look at the data they are given, so they can be
+// fed with any file, the other functions know where the files live.
+namespace LinuxWallpaper
+{
+
+enum class Source : quint8
+{
+    GSettings, // GNOME, Cinnamon, MATE and friends, stored in dconf.
+    Plasma,
+    Xfce,
+    Sway,
+    Feh
+};
+
+struct Wallpaper
+{
+    bool valid = false;
+    QString filePath = {};
+    Global::WallpaperAspectStyle aspectStyle = Global::WallpaperAspectStyle::Fill;
+};
+
+using StringMap = QHash<QString, QString>;
+
+// The string keys of one dconf directory (for example "/org/gnome/desktop/background/"),
+// read from a binary dconf database (GVDB, such as ~/.config/dconf/user) ...
+[[nodiscard]] FRAMELESSHELPER_CORE_API StringMap parseDconfDatabase(const QByteArray &data, const QString &dir);
+// ... or from a dconf keyfile (such as the ones in /etc/dconf/db/local.d, or the output of "dconf dump /").
+[[nodiscard]] FRAMELESSHELPER_CORE_API StringMap parseDconfKeyfile(const QByteArray &data, const QString &dir);
+
+// The keys the user never changed come from the system: the vendor overrides
+// (/usr/share/glib-2.0/schemas/*.gschema.override, where "[schema:desktop]" groups
+// win over "[schema]" for the given desktops) ...
+[[nodiscard]] FRAMELESSHELPER_CORE_API StringMap parseGSettingsOverride(const QByteArray &data,
+    const QString &schema, const QStringList &desktops = {});
+// ... or the defaults of the schema itself (/usr/share/glib-2.0/schemas/<schema>.gschema.xml).
+[[nodiscard]] FRAMELESSHELPER_CORE_API StringMap parseGSettingsSchema(const QByteArray &data, const QString &schema);
+
+// Turns the keys of a GSettings background schema into a wallpaper.
+[[nodiscard]] FRAMELESSHELPER_CORE_API Wallpaper wallpaperFromGSettings(const StringMap &values, const bool dark);
+
+[[nodiscard]] FRAMELESSHELPER_CORE_API Wallpaper parsePlasmaAppletsrc(const QByteArray &data);
+[[nodiscard]] FRAMELESSHELPER_CORE_API Wallpaper parseXfceDesktopXml(const QByteArray &data);
+[[nodiscard]] FRAMELESSHELPER_CORE_API Wallpaper parseSwayConfig(const QByteArray &data);
+[[nodiscard]] FRAMELESSHELPER_CORE_API Wallpaper parseFehbg(const QByteArray &data);
+
+// The configuration sources of the current desktop session, most relevant first.
+// Sessions without a desktop environment get feh and GSettings.
+[[nodiscard]] FRAMELESSHELPER_CORE_API QList<Source> currentSources();
+
+// The files a source is read from. They don't have to exist. The GSettings
+// defaults shipped with the system are not included: they only change when
+// packages are updated, so there's no point in watching them.
+[[nodiscard]] FRAMELESSHELPER_CORE_API QStringList configFiles(const Source source);
+
+[[nodiscard]] FRAMELESSHELPER_CORE_API Wallpaper read(const Source source);
+
+// The first valid wallpaper of currentSources().
+[[nodiscard]] FRAMELESSHELPER_CORE_API Wallpaper current();
+
+} // namespace LinuxWallpaper
+
+FRAMELESSHELPER_END_NAMESPACE
+
+#endif // (defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID))
@@ -0,0 +1,73 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021-2023 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <FramelessHelper/Core/framelesshelpercore_global.h>
+#include <QtCore/qhash.h>
+#include <QtCore/qpointer.h>
+#include <QtCore/qtimer.h>
+#include <QtCore/qelapsedtimer.h>
+#include <functional>
+
+FRAMELESSHELPER_BEGIN_NAMESPACE
+
+// Collects repaint requests from all windows and runs each of them at most once per
+// frame, so that a burst of changes (for example a system theme change) results in
+// exactly one repaint of every affected target.
+class FRAMELESSHELPER_CORE_API RepaintScheduler : public QObject
+{
+    Q_OBJECT
+    FRAMELESSHELPER_CLASS_INFO
+    Q_DISABLE_COPY_MOVE(RepaintScheduler)
+
+public:
+    using Callback = std::function<void()>;
+
+    explicit RepaintScheduler(QObject *parent = nullptr);
+    ~RepaintScheduler() override;
+
+    Q_NODISCARD static RepaintScheduler *instance();
+
+    void schedule(QObject *target, const Callback &callback);
+    void flush();
+
+    Q_NODISCARD quint64 requestCount() const;
+    Q_NODISCARD quint64 repaintCount() const;
+
+private:
+    struct Entry
+    {
+        QPointer<QObject> target = nullptr;
+        Callback callback = nullptr;
+    };
+
+    QHash<QObject *, Entry> m_pending = {};
+    QTimer m_timer;
+    QElapsedTimer m_lastFlush;
+    quint64 m_requestCount = 0;
+    quint64 m_repaintCount = 0;
+};
+
+FRAMELESSHELPER_END_NAMESPACE
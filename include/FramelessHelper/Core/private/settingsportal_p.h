@@ -0,0 +1,80 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021-2023 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <FramelessHelper/Core/framelesshelpercore_global.h>
+
+#if (defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID))
+
+#include <QtCore/qvariant.h>
+#include <array>
+#include <optional>
+#ifdef FRAMELESSHELPER_HAS_DBUS
+#  include <QtDBus/qdbusmessage.h>
+#endif // FRAMELESSHELPER_HAS_DBUS
+
+FRAMELESSHELPER_BEGIN_NAMESPACE
+
+// Client of the org.freedesktop.portal.Settings D-Bus interface, which exposes
+// the desktop's color scheme and accent color no matter which desktop (or which
+// toolkit) is in use. Nothing here ever blocks: the calls are asynchronous and
+// the results land in LinuxTheme::portalHints(). Does nothing when FramelessHelper
+// has been built without Qt D-Bus, or when there's no portal on the session bus.
+class FRAMELESSHELPER_CORE_API SettingsPortal : public QObject
+{
+    Q_OBJECT
+    FRAMELESSHELPER_CLASS_INFO
+    Q_DISABLE_COPY_MOVE(SettingsPortal)
+
+public:
+    explicit SettingsPortal(QObject *parent = nullptr);
+    ~SettingsPortal() override;
+
+    Q_NODISCARD static bool isSupported();
+
+    // Asks the portal for the appearance settings and subscribes to their changes.
+    // updated() is emitted when the first answer arrives and after every change
+    // of the color scheme or the accent color, no polling involved.
+    void start();
+
+Q_SIGNALS:
+    void updated();
+
+private:
+#ifdef FRAMELESSHELPER_HAS_DBUS
+    // org.freedesktop.portal.Settings.SettingChanged(s namespace, s key, v value)
+    Q_SLOT void handleSettingChanged(const QDBusMessage &message);
+#endif // FRAMELESSHELPER_HAS_DBUS
+    void apply(const QVariantMap &appearance);
+    void publish();
+
+    bool m_started = false;
+    std::optional<quint32> m_colorScheme = std::nullopt;
+    std::optional<std::array<qreal, 3>> m_accentColor = std::nullopt;
+};
+
+FRAMELESSHELPER_END_NAMESPACE
+
+#endif // (defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID))
@@ -25,6 +25,8 @@
 #pragma once
 
 #include <FramelessHelper/Core/framelesshelpercore_global.h>
+#include <QtCore/qstringlist.h>
+#include <atomic>
 
 FRAMELESSHELPER_BEGIN_NAMESPACE
 
@@ -35,6 +37,41 @@ class FRAMELESSHELPER_CORE_API SysApiLoader : public QObject
     Q_DISABLE_COPY_MOVE(SysApiLoader)
 
 public:
+    // The cached state of a single symbol. There is exactly one slot per library and
+    // symbol pair (see SlotStorage below), once resolved a lookup is a single atomic
+    // load and can be done from any thread.
+    struct Slot
+    {
+        static constexpr const quintptr Unresolved = 0;
+        static constexpr const quintptr Missing = 1;
+
+        std::atomic<quintptr> value{ Unresolved };
+    };
+
+    template<quint64 Key>
+    struct SlotStorage
+    {
+        static inline Slot slot = {};
+    };
+
+    // FNV-1a, only used to give every "library@symbol" pair its own slot at compile time.
+    Q_NODISCARD static constexpr quint64 slotKey(const char *name)
+    {
+        quint64 hash = 14695981039346656037ull;
+        for (; *name; ++name) {
+            hash = ((hash ^ quint64(static_cast<unsigned char>(*name))) * 1099511628211ull);
+        }
+        return hash;
+    }
+
+    // A library and the symbols which will most likely be needed from it.
+    struct ManifestEntry
+    {
+        QString library = {};
+        QStringList functions = {};
+    };
+    using Manifest = QList<ManifestEntry>;
+
     Q_NODISCARD static SysApiLoader *instance();
 
     Q_NODISCARD static QString platformSharedLibrarySuffixName();
@@ -48,30 +85,61 @@ public:
 
     Q_NODISCARD QFunctionPointer get(const QString &library, const QString &function);
 
+    // Everything the current platform loads dynamically, defined next to the
+    // wrappers themselves (platformsupport_*.cpp).
+    Q_NODISCARD static Manifest platformManifest();
+    // Resolves the whole manifest on a worker thread, so that the first calls
+    // through the API_* macros only hit the cache. Safe to call more than once.
+    static void prefetch(const Manifest &manifest);
+
     template<typename T>
     Q_NODISCARD T get(const QString &library, const QString &function)
     {
         return reinterpret_cast<T>(get(library, function));
     }
 
+    Q_NODISCARD static bool isAvailable(Slot &slot, const QString &library, const QString &function)
+    {
+        quintptr value = slot.value.load(std::memory_order_acquire);
+        if (value == Slot::Unresolved) {
+            value = resolveSlot(slot, library, function);
+        }
+        return (value != Slot::Missing);
+    }
+
+    template<typename T>
+    Q_NODISCARD static T get(Slot &slot, const QString &library, const QString &function)
+    {
+        quintptr value = slot.value.load(std::memory_order_acquire);
+        if (value == Slot::Unresolved) {
+            value = resolveSlot(slot, library, function);
+        }
+        return ((value == Slot::Missing) ? nullptr : reinterpret_cast<T>(value));
+    }
+
 private:
     explicit SysApiLoader(QObject *parent = nullptr);
     ~SysApiLoader() override;
+
+    Q_NODISCARD static quintptr resolveSlot(Slot &slot, const QString &library, const QString &function);
 };
 
 FRAMELESSHELPER_END_NAMESPACE
 
+#define API_SLOT(key) \
+  (FRAMELESSHELPER_PREPEND_NAMESPACE(SysApiLoader)::SlotStorage<FRAMELESSHELPER_PREPEND_NAMESPACE(SysApiLoader)::slotKey(key)>::slot)
+
 #define API_AVAILABLE(lib, func) \
-  (FRAMELESSHELPER_PREPEND_NAMESPACE(SysApiLoader)::instance()->isAvailable(k##lib, k##func))
+  (FRAMELESSHELPER_PREPEND_NAMESPACE(SysApiLoader)::isAvailable(API_SLOT(#lib "@" #func), k##lib, k##func))
 
 #define API_CALL_FUNCTION(lib, func, ...) \
-  ((FRAMELESSHELPER_PREPEND_NAMESPACE(SysApiLoader)::instance()->get<decltype(&func)>(k##lib, k##func))(__VA_ARGS__))
+  ((FRAMELESSHELPER_PREPEND_NAMESPACE(SysApiLoader)::get<decltype(&func)>(API_SLOT(#lib "@" #func), k##lib, k##func))(__VA_ARGS__))
 
 #define API_CALL_FUNCTION2(lib, func, type, ...) \
-  ((FRAMELESSHELPER_PREPEND_NAMESPACE(SysApiLoader)::instance()->get<type>(k##lib, k##func))(__VA_ARGS__))
+  ((FRAMELESSHELPER_PREPEND_NAMESPACE(SysApiLoader)::get<type>(API_SLOT(#lib "@" #func), k##lib, k##func))(__VA_ARGS__))
 
 #define API_CALL_FUNCTION3(lib, func, name, ...) \
-  ((FRAMELESSHELPER_PREPEND_NAMESPACE(SysApiLoader)::instance()->get<decltype(&func)>(k##lib, k##name))(__VA_ARGS__))
+  ((FRAMELESSHELPER_PREPEND_NAMESPACE(SysApiLoader)::get<decltype(&func)>(API_SLOT(#lib "@" #name), k##lib, k##name))(__VA_ARGS__))
 
 #define API_CALL_FUNCTION4(lib, func, ...) API_CALL_FUNCTION3(lib, _##func, func, __VA_ARGS__)
 
@@ -0,0 +1,65 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021-2023 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <FramelessHelper/Core/framelesshelpercore_global.h>
+#include <QtGui/qcolor.h>
+#include <array>
+#include <memory>
+
+FRAMELESSHELPER_BEGIN_NAMESPACE
+
+// Everything derived from the current system theme, computed only once per theme
+// change by FramelessManager and shared by all consumers. It's never modified after
+// creation, so it's safe to hold on to it for as long as needed.
+struct ThemeSnapshot
+{
+    static constexpr const int kButtonStateCount = static_cast<int>(Global::ButtonState::Released) + 1;
+
+    quint64 version = 0;
+    Global::SystemTheme theme = Global::SystemTheme::Unknown;
+    bool dark = false;
+    QColor accentColor = {};
+    bool titleBarColorized = false;
+#ifdef Q_OS_WINDOWS
+    Global::DwmColorizationArea colorizationArea = Global::DwmColorizationArea::None;
+#endif
+    QColor frameBorderActiveColor = {};
+    QColor frameBorderInactiveColor = {};
+    QColor titleBarActiveBackgroundColor = {};
+    QColor titleBarInactiveBackgroundColor = {};
+    QColor titleBarActiveForegroundColor = {};
+    QColor titleBarInactiveForegroundColor = {};
+    std::array<QColor, (static_cast<int>(Global::SystemButtonType::Last) + 1) * kButtonStateCount> systemButtonBackgroundColors = {};
+
+    [[nodiscard]] QColor systemButtonBackgroundColor(const Global::SystemButtonType button, const Global::ButtonState state) const
+    {
+        return systemButtonBackgroundColors.at((static_cast<int>(button) * kButtonStateCount) + static_cast<int>(state));
+    }
+};
+
+using ThemeSnapshotPtr = std::shared_ptr<const ThemeSnapshot>;
+
+FRAMELESSHELPER_END_NAMESPACE
@@ -0,0 +1,70 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021-2023 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <FramelessHelper/Core/framelesshelpercore_global.h>
+
+FRAMELESSHELPER_BEGIN_NAMESPACE
+
+// Optional span tracing, exported as Chrome trace-event JSON (chrome://tracing,
+// Perfetto UI). Enabled by Option::EnableTracing, costs a single branch otherwise.
+// Every thread records into its own buffer without any locking, the names must
+// be string literals because only the pointers are stored.
+namespace Trace
+{
+
+[[nodiscard]] FRAMELESSHELPER_CORE_API bool isEnabled();
+[[nodiscard]] FRAMELESSHELPER_CORE_API qint64 now();
+FRAMELESSHELPER_CORE_API void complete(const char *name, const qint64 start, const qint64 end);
+FRAMELESSHELPER_CORE_API void instant(const char *name);
+FRAMELESSHELPER_CORE_API bool dump(const QString &filePath = {});
+
+class Span
+{
+    Q_DISABLE_COPY_MOVE(Span)
+
+public:
+    explicit Span(const char *name) : m_name(name)
+    {
+        if (isEnabled()) {
+            m_start = now();
+        }
+    }
+
+    ~Span()
+    {
+        if (m_start >= 0) {
+            complete(m_name, m_start, now());
+        }
+    }
+
+private:
+    const char *m_name = nullptr;
+    qint64 m_start = -1;
+};
+
+} // namespace Trace
+
+FRAMELESSHELPER_END_NAMESPACE
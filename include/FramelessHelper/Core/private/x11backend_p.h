@@ -0,0 +1,224 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021-2023 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <FramelessHelper/Core/framelesshelpercore_global.h>
+
+#if (defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID))
+
+#include <FramelessHelper/Core/framelesshelper_linux.h>
+#include <FramelessHelper/Core/private/x11property_p.h>
+#include <QtCore/qhash.h>
+#include <QtCore/qmutex.h>
+#include <QtCore/qpair.h>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <vector>
+
+FRAMELESSHELPER_BEGIN_NAMESPACE
+
+// The handful of X11 requests the Linux code paths send once the capability probe
+// is done. Everything goes through the current backend, which is either the real
+// xcb connection of the application or a recording one that keeps everything in
+// memory, so those code paths can be exercised and benchmarked without an X server.
+namespace X11
+{
+
+enum class Operation : quint8
+{
+    InternAtom,
+    GetProperty,
+    ListProperties,
+    ChangeProperty,
+    DeleteProperty,
+    SendEvent,
+    UngrabPointer,
+    Flush,
+    Last = Flush
+};
+
+inline constexpr const auto kOperationCount = (static_cast<int>(Operation::Last) + 1);
+
+// Whether the operation has to wait for the reply of the server.
+[[nodiscard]] inline constexpr bool isRoundTrip(const Operation operation)
+{
+    return ((operation == Operation::InternAtom) || (operation == Operation::GetProperty)
+        || (operation == Operation::ListProperties));
+}
+
+struct OperationCount
+{
+    quint64 requests = 0;
+    quint64 roundTrips = 0;
+};
+using OperationCounts = std::array<OperationCount, kOperationCount>;
+
+struct AtomsAndProperties
+{
+    std::vector<xcb_atom_t> atoms = {}; // In the order of the names, XCB_NONE for failures.
+    std::vector<xcb_atom_t> properties = {}; // The properties of the window, unsorted.
+};
+
+// The public functions do the bookkeeping (the per-operation counters and the global
+// statistics) and forward to the protected virtual ones, so every implementation
+// reports the same numbers for the same sequence of operations. Only the backends
+// talking to a real server add to the global statistics.
+class FRAMELESSHELPER_CORE_API Backend
+{
+    Q_DISABLE_COPY_MOVE(Backend)
+
+public:
+    explicit Backend(const bool realServer = false);
+    virtual ~Backend();
+
+    Q_NODISCARD virtual xcb_window_t rootWindow() const = 0;
+
+    Q_NODISCARD xcb_atom_t internAtom(const char *name);
+    // Pipelined: all the atoms and the property list of the window are asked for at
+    // once and cost a single round trip together. Pass XCB_WINDOW_NONE to only intern
+    // the atoms.
+    Q_NODISCARD AtomsAndProperties internAtomsAndListProperties(const char * const *names,
+        const int count, const xcb_window_t window);
+    // The offset and the length are in 32-bit units, as for xcb_get_property().
+    // Counted as a round trip when sent, whether or not the reply is waited for.
+    Q_NODISCARD PropertyFuture requestProperty(const xcb_window_t window, const xcb_atom_t prop,
+        const xcb_atom_t type, const quint32 offset, const quint32 length);
+    // The same as requestProperty(...).get().
+    Q_NODISCARD PropertyReply getProperty(const xcb_window_t window, const xcb_atom_t prop,
+        const xcb_atom_t type, const quint32 length);
+    // Replaces the property, the count is in units of the format.
+    void changeProperty(const xcb_window_t window, const xcb_atom_t prop, const xcb_atom_t type,
+        const quint8 format, const void *data, const quint32 count);
+    void deleteProperty(const xcb_window_t window, const xcb_atom_t prop);
+    void sendClientMessage(const xcb_window_t destination, const xcb_client_message_event_t &event);
+    void ungrabPointer();
+    void flush();
+
+    Q_NODISCARD OperationCount count(const Operation operation) const;
+    Q_NODISCARD OperationCounts counts() const;
+    void resetCounts();
+
+protected:
+    Q_NODISCARD virtual xcb_atom_t doInternAtom(const char *name) = 0;
+    Q_NODISCARD virtual AtomsAndProperties doInternAtomsAndListProperties(const char * const *names,
+        const int count, const xcb_window_t window) = 0;
+    Q_NODISCARD virtual PropertyFuture doRequestProperty(const xcb_window_t window, const xcb_atom_t prop,
+        const xcb_atom_t type, const quint32 offset, const quint32 length) = 0;
+    virtual void doChangeProperty(const xcb_window_t window, const xcb_atom_t prop, const xcb_atom_t type,
+        const quint8 format, const void *data, const quint32 count) = 0;
+    virtual void doDeleteProperty(const xcb_window_t window, const xcb_atom_t prop) = 0;
+    virtual void doSendClientMessage(const xcb_window_t destination, const xcb_client_message_event_t &event) = 0;
+    virtual void doUngrabPointer() = 0;
+    virtual void doFlush() = 0;
+
+private:
+    void record(const Operation operation);
+    void record(const Operation operation, const quint64 requests, const quint64 roundTrips);
+
+private:
+    const bool m_realServer = false;
+    std::array<std::atomic<quint64>, kOperationCount> m_requests = {};
+    std::array<std::atomic<quint64>, kOperationCount> m_roundTrips = {};
+};
+
+// Keeps the window properties, the atoms and the messages in memory, nothing is
+// sent anywhere. Atoms are handed out in the order they are first asked for, and
+// property requests are fulfilled right away.
+class FRAMELESSHELPER_CORE_API RecordingBackend final : public Backend
+{
+    Q_DISABLE_COPY_MOVE(RecordingBackend)
+
+public:
+    struct Property
+    {
+        xcb_atom_t type = XCB_NONE;
+        quint8 format = 0;
+        quint32 count = 0;
+        QByteArray data = {};
+    };
+
+    struct Message
+    {
+        xcb_window_t destination = XCB_WINDOW_NONE;
+        xcb_client_message_event_t event = {};
+    };
+
+    explicit RecordingBackend(const xcb_window_t rootWindow = 1);
+    ~RecordingBackend() override;
+
+    Q_NODISCARD xcb_window_t rootWindow() const override;
+
+    Q_NODISCARD std::optional<Property> property(const xcb_window_t window, const xcb_atom_t prop) const;
+    Q_NODISCARD QList<Message> messages() const;
+    Q_NODISCARD quint32 pointerUngrabs() const;
+    Q_NODISCARD quint32 flushes() const;
+    // Forgets the recorded state, the counters are left alone.
+    void clear();
+
+protected:
+    Q_NODISCARD xcb_atom_t doInternAtom(const char *name) override;
+    Q_NODISCARD AtomsAndProperties doInternAtomsAndListProperties(const char * const *names,
+        const int count, const xcb_window_t window) override;
+    Q_NODISCARD PropertyFuture doRequestProperty(const xcb_window_t window, const xcb_atom_t prop,
+        const xcb_atom_t type, const quint32 offset, const quint32 length) override;
+    void doChangeProperty(const xcb_window_t window, const xcb_atom_t prop, const xcb_atom_t type,
+        const quint8 format, const void *data, const quint32 count) override;
+    void doDeleteProperty(const xcb_window_t window, const xcb_atom_t prop) override;
+    void doSendClientMessage(const xcb_window_t destination, const xcb_client_message_event_t &event) override;
+    void doUngrabPointer() override;
+    void doFlush() override;
+
+private:
+    mutable QMutex m_mutex{};
+    xcb_window_t m_rootWindow = XCB_WINDOW_NONE;
+    QHash<QByteArray, xcb_atom_t> m_atoms = {};
+    QHash<QPair<xcb_window_t, xcb_atom_t>, Property> m_properties = {};
+    QList<Message> m_messages = {};
+    quint32 m_pointerUngrabs = 0;
+    quint32 m_flushes = 0;
+};
+
+// Talks to the given connection, which doesn't have to be the application's own one.
+[[nodiscard]] FRAMELESSHELPER_CORE_API std::unique_ptr<Backend>
+    createXcbBackend(xcb_connection_t *connection, const xcb_window_t rootWindow);
+
+// The backend installed by setBackend(), or the xcb backend of the application's own
+// connection. Null when neither is available, on Wayland for example.
+[[nodiscard]] FRAMELESSHELPER_CORE_API Backend *backend();
+
+// Replaces the current backend, pass null to go back to the application's own
+// connection. Returns the backend installed before, if any. The capabilities are
+// probed again through the new backend the next time they are needed. Only meant
+// for tests and benchmarks: nothing may be using the current backend while it's
+// being replaced.
+FRAMELESSHELPER_CORE_API std::unique_ptr<Backend> setBackend(std::unique_ptr<Backend> value);
+
+} // namespace X11
+
+FRAMELESSHELPER_END_NAMESPACE
+
+#endif // (defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID))
@@ -0,0 +1,144 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021-2023 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <FramelessHelper/Core/framelesshelpercore_global.h>
+
+#if (defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID))
+
+#include <FramelessHelper/Core/framelesshelper_linux.h>
+#include <algorithm>
+#include <array>
+#include <memory>
+
+FRAMELESSHELPER_BEGIN_NAMESPACE
+
+// Everything we need to know about the X server and the window manager, asked
+// with pipelined requests: all the questions are sent first and the replies are
+// collected afterwards, so the whole probe costs a few round trips instead of
+// one per atom and per property. That matters a lot for remote X11 sessions.
+namespace X11
+{
+
+class Backend;
+
+enum class Atom : quint8
+{
+    NetSupported,
+    NetWmName,
+    NetWmMoveResize,
+    NetSupportingWmCheck,
+    NetKdeCompositeToggling,
+    KdeNetWmBlurBehindRegion,
+    GtkShowWindowMenu,
+    DeepinNoTitleBar,
+    DeepinForceDecorate,
+    NetWmDeepinBlurRegionMask,
+    NetWmDeepinBlurRegionRounded,
+    Utf8String,
+    Last = Utf8String
+};
+
+inline constexpr const auto kAtomCount = (static_cast<int>(Atom::Last) + 1);
+
+// Must be in the same order as the Atom enum.
+inline constexpr const std::array<const char *, kAtomCount> kAtomNames =
+{
+    ATOM_NET_SUPPORTED,
+    ATOM_NET_WM_NAME,
+    ATOM_NET_WM_MOVERESIZE,
+    ATOM_NET_SUPPORTING_WM_CHECK,
+    ATOM_NET_KDE_COMPOSITE_TOGGLING,
+    ATOM_KDE_NET_WM_BLUR_BEHIND_REGION,
+    ATOM_GTK_SHOW_WINDOW_MENU,
+    ATOM_DEEPIN_NO_TITLEBAR,
+    ATOM_DEEPIN_FORCE_DECORATE,
+    ATOM_NET_WM_DEEPIN_BLUR_REGION_MASK,
+    ATOM_NET_WM_DEEPIN_BLUR_REGION_ROUNDED,
+    ATOM_UTF8_STRING
+};
+
+#if (QT_VERSION >= QT_VERSION_CHECK(6, 0, 0))
+using AtomList = QList<xcb_atom_t>;
+#else // (QT_VERSION < QT_VERSION_CHECK(6, 0, 0))
+using AtomList = QVector<xcb_atom_t>;
+#endif // (QT_VERSION >= QT_VERSION_CHECK(6, 0, 0))
+
+// Immutable once published, a refresh publishes a new instance instead.
+struct Capabilities
+{
+    bool valid = false;
+    quint32 generation = 0; // Increased by every refresh.
+    xcb_window_t rootWindow = XCB_WINDOW_NONE;
+    std::array<xcb_atom_t, kAtomCount> atoms = {};
+    QString windowManagerName = {};
+    AtomList netSupported = {}; // _NET_SUPPORTED of the root window, sorted.
+    AtomList rootWindowProperties = {}; // Sorted.
+    quint32 roundTrips = 0; // How many times the probe had to wait for the server.
+
+    Q_NODISCARD xcb_atom_t atom(const Atom which) const
+    {
+        return atoms.at(static_cast<int>(which));
+    }
+
+    Q_NODISCARD bool isSupportedByWindowManager(const xcb_atom_t value) const
+    {
+        return std::binary_search(netSupported.cbegin(), netSupported.cend(), value);
+    }
+
+    Q_NODISCARD bool hasRootWindowProperty(const xcb_atom_t value) const
+    {
+        return std::binary_search(rootWindowProperties.cbegin(), rootWindowProperties.cend(), value);
+    }
+};
+using CapabilitiesPtr = std::shared_ptr<const Capabilities>;
+
+// Does the actual probing through the given backend and doesn't touch any global
+// state, so it can be pointed at any connection (an Xvfb instance for example, see
+// createXcbBackend()) or at a recording backend.
+[[nodiscard]] FRAMELESSHELPER_CORE_API Capabilities probeCapabilities(Backend &backend);
+
+// The current probe result for the current backend (the application's own connection
+// unless setBackend() has been used), never null.
+[[nodiscard]] FRAMELESSHELPER_CORE_API CapabilitiesPtr capabilities();
+
+// Forgets the current result, the next capabilities() call probes again.
+FRAMELESSHELPER_CORE_API void resetCapabilities();
+
+// Probes once and then keeps the result up to date by watching the PropertyNotify
+// events of the root window: _NET_SUPPORTED and _NET_SUPPORTING_WM_CHECK trigger a
+// new probe (the window manager has been restarted or replaced), other properties
+// appearing or disappearing are applied without asking the server again.
+// Must be called from the GUI thread.
+FRAMELESSHELPER_CORE_API void watchCapabilities();
+
+// XCB_NONE if the name is not one of kAtomNames.
+[[nodiscard]] FRAMELESSHELPER_CORE_API xcb_atom_t knownAtom(const char *name);
+
+} // namespace X11
+
+FRAMELESSHELPER_END_NAMESPACE
+
+#endif // (defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID))
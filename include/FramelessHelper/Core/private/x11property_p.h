@@ -0,0 +1,173 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021-2023 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <FramelessHelper/Core/framelesshelpercore_global.h>
+
+#if (defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID))
+
+#include <FramelessHelper/Core/framelesshelper_linux.h>
+#include <cstdlib>
+#include <memory>
+
+FRAMELESSHELPER_BEGIN_NAMESPACE
+
+// Property reads without copying: the reply allocated by xcb is owned by a
+// PropertyReply and the values are read through views into it, so a read costs
+// exactly the one allocation xcb makes for the reply. Requests can be sent ahead
+// of time and waited for later through a PropertyFuture.
+namespace X11
+{
+
+struct ReplyDeleter
+{
+    void operator()(void *reply) const noexcept
+    {
+        std::free(reply);
+    }
+};
+
+// For the replies allocated by xcb with malloc().
+template <typename T>
+using ReplyPtr = std::unique_ptr<T, ReplyDeleter>;
+
+// Only valid as long as the reply it points into.
+template <typename T>
+class PropertyValues
+{
+public:
+    constexpr PropertyValues() noexcept = default;
+    constexpr PropertyValues(const T *data, const int size) noexcept : m_data(data), m_size(data ? size : 0) {}
+
+    Q_NODISCARD constexpr const T *data() const noexcept { return m_data; }
+    Q_NODISCARD constexpr int size() const noexcept { return m_size; }
+    Q_NODISCARD constexpr bool isEmpty() const noexcept { return (m_size <= 0); }
+    Q_NODISCARD constexpr const T *begin() const noexcept { return m_data; }
+    Q_NODISCARD constexpr const T *end() const noexcept { return (m_data + m_size); }
+
+    Q_NODISCARD const T &at(const int index) const
+    {
+        Q_ASSERT((index >= 0) && (index < m_size));
+        return m_data[index];
+    }
+
+    Q_NODISCARD const T &operator[](const int index) const
+    {
+        return at(index);
+    }
+
+private:
+    const T *m_data = nullptr;
+    int m_size = 0;
+};
+
+class FRAMELESSHELPER_CORE_API PropertyReply
+{
+    Q_DISABLE_COPY(PropertyReply)
+
+public:
+    PropertyReply() noexcept = default;
+    // Takes the ownership of the reply.
+    explicit PropertyReply(xcb_get_property_reply_t *reply) noexcept;
+    PropertyReply(PropertyReply &&other) noexcept = default;
+    PropertyReply &operator=(PropertyReply &&other) noexcept = default;
+    ~PropertyReply();
+
+    // Builds a reply the way the server would send it, for the backends that
+    // don't talk to a server. The data is copied, count is in units of the format.
+    Q_NODISCARD static PropertyReply create(const xcb_atom_t type, const quint8 format,
+        const void *data, const quint32 count, const quint32 bytesAfter = 0);
+
+    Q_NODISCARD bool isValid() const noexcept { return (m_reply != nullptr); }
+    // XCB_NONE if the property doesn't exist.
+    Q_NODISCARD xcb_atom_t type() const noexcept { return (m_reply ? m_reply->type : xcb_atom_t(XCB_NONE)); }
+    Q_NODISCARD quint8 format() const noexcept { return (m_reply ? m_reply->format : 0); }
+    // How much of the property is left after the returned part, in bytes.
+    Q_NODISCARD quint32 bytesAfter() const noexcept { return (m_reply ? m_reply->bytes_after : 0); }
+    Q_NODISCARD int byteSize() const noexcept;
+    Q_NODISCARD const char *rawData() const noexcept;
+
+    // Empty unless the property has the expected type (XCB_NONE accepts any type)
+    // and its format matches the size of T.
+    template <typename T>
+    Q_NODISCARD PropertyValues<T> values(const xcb_atom_t expectedType = XCB_NONE) const noexcept
+    {
+        static_assert((sizeof(T) == 1) || (sizeof(T) == 2) || (sizeof(T) == 4));
+        if (!m_reply || (m_reply->format != quint8(sizeof(T) * 8))) {
+            return {};
+        }
+        if ((expectedType != XCB_NONE) && (m_reply->type != expectedType)) {
+            return {};
+        }
+        return PropertyValues<T>(reinterpret_cast<const T *>(rawData()), int(m_reply->value_len));
+    }
+
+    // Copies the value, for the callers that need to keep it around.
+    Q_NODISCARD QByteArray toByteArray() const;
+
+private:
+    ReplyPtr<xcb_get_property_reply_t> m_reply = nullptr;
+};
+
+// The request has been sent already, get() waits for the reply if it hasn't
+// arrived yet. A reply that is never asked for is discarded without waiting.
+class FRAMELESSHELPER_CORE_API PropertyFuture
+{
+    Q_DISABLE_COPY(PropertyFuture)
+
+public:
+    PropertyFuture() noexcept = default;
+    explicit PropertyFuture(xcb_connection_t *connection, const xcb_get_property_cookie_t cookie) noexcept;
+    // Already fulfilled.
+    explicit PropertyFuture(PropertyReply &&reply) noexcept;
+    PropertyFuture(PropertyFuture &&other) noexcept;
+    PropertyFuture &operator=(PropertyFuture &&other) noexcept;
+    ~PropertyFuture();
+
+    // Whether get() may still have to wait for the server.
+    Q_NODISCARD bool isPending() const noexcept { return (m_connection != nullptr); }
+    // Can only be called once, the reply is handed over to the caller.
+    Q_NODISCARD PropertyReply get();
+
+private:
+    void discard() noexcept;
+
+private:
+    xcb_connection_t *m_connection = nullptr;
+    xcb_get_property_cookie_t m_cookie = {};
+    PropertyReply m_reply = {};
+};
+
+// Sends the request right away but doesn't wait for the reply. The offset and
+// the length are in 32-bit units, as for xcb_get_property().
+[[nodiscard]] FRAMELESSHELPER_CORE_API PropertyFuture requestProperty(xcb_connection_t *connection,
+    const xcb_window_t window, const xcb_atom_t prop, const xcb_atom_t type,
+    const quint32 offset, const quint32 length);
+
+} // namespace X11
+
+FRAMELESSHELPER_END_NAMESPACE
+
+#endif // (defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID))
@@ -0,0 +1,61 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021-2023 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <FramelessHelper/Core/framelesshelpercore_global.h>
+
+#if (defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID))
+
+#include <FramelessHelper/Core/framelesshelper_linux.h>
+
+FRAMELESSHELPER_BEGIN_NAMESPACE
+
+// Window property writes are queued here instead of being sent and flushed one
+// by one. Writes to the same property of the same window are merged (only the
+// last one survives) and everything is sent with a single flush at the end of
+// the current event loop iteration. Setting up a single window touches several
+// properties, so this saves quite a few packets, especially over the network.
+namespace X11
+{
+
+// Replaces the property, the data is copied.
+FRAMELESSHELPER_CORE_API void queuePropertyChange(const WId windowId, const xcb_atom_t prop,
+    const xcb_atom_t type, const quint8 format, const void *data, const quint32 count);
+
+FRAMELESSHELPER_CORE_API void queuePropertyDeletion(const WId windowId, const xcb_atom_t prop);
+
+// Sends everything that is still queued, without flushing. Call this before
+// sending a request that must be ordered after the queued writes.
+FRAMELESSHELPER_CORE_API void submitPendingRequests();
+
+// The immediate path for urgent requests such as move/resize: sends whatever is
+// still queued and flushes the connection right away.
+FRAMELESSHELPER_CORE_API void flushNow();
+
+} // namespace X11
+
+FRAMELESSHELPER_END_NAMESPACE
+
+#endif // (defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID))
@@ -32,6 +32,7 @@
 #if (defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID))
 QT_BEGIN_NAMESPACE
 class QScreen;
+class QRegion;
 QT_END_NAMESPACE
 #endif // Q_OS_LINUX
 
@@ -156,6 +157,10 @@ FRAMELESSHELPER_CORE_API void printWin32Message(void *msg);
 #endif // Q_OS_WINDOWS
 
 #if (defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID))
+// The x11_* functions and everything built on top of them do nothing unless
+// the application is running on the xcb platform plugin.
+[[nodiscard]] FRAMELESSHELPER_CORE_API bool isXcbPlatform();
+[[nodiscard]] FRAMELESSHELPER_CORE_API bool isWaylandPlatform();
 [[nodiscard]] FRAMELESSHELPER_CORE_API QScreen *x11_findScreenForVirtualDesktop
     (const int virtualDesktopNumber);
 [[nodiscard]] FRAMELESSHELPER_CORE_API x11_return_type x11_appRootWindow(const int screen);
@@ -183,6 +188,12 @@ FRAMELESSHELPER_CORE_API void openSystemMenu(const WId windowId, const QPoint &g
 FRAMELESSHELPER_CORE_API void sendMoveResizeMessage
     (const WId windowId, const uint32_t action, const QPoint &globalPos, const Qt::MouseButton button = Qt::LeftButton);
 [[nodiscard]] FRAMELESSHELPER_CORE_API bool isCustomDecorationSupported();
+// Blurs only the given region (in logical pixels, relative to the window) instead of
+// the whole window. The region is clipped to the window and kept up to date when
+// the window is resized or moved to another screen. Pass an empty region to
+// disable the blur again. The radius is only honored by the Deepin window manager.
+[[nodiscard]] FRAMELESSHELPER_CORE_API bool setBlurBehindWindowRegion
+    (QWindow *window, const QRegion &region, const quint32 radius = 0);
 [[nodiscard]] FRAMELESSHELPER_CORE_API bool
     setPlatformPropertiesForWindow(QWindow *window, const QVariantHash &props);
 #endif // Q_OS_LINUX
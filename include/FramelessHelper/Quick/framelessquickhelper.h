@@ -87,6 +87,7 @@ public Q_SLOTS:
     void setHitTestVisible_rect(const QRect &rect, const bool visible = true);
     void setHitTestVisible_object(QObject *object, const bool visible = true);
     void setHitTestVisible_item(QQuickItem *item, const bool visible = true);
+    void setForceRepaintOnDprChange(QQuickItem *item, const bool value = true);
 
     void showSystemMenu(const QPoint &pos);
     void windowStartSystemMove2(const QPoint &pos);
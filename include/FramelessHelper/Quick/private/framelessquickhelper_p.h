@@ -58,6 +58,7 @@ public:
 
     void attach();
     void detach();
+    void markReady();
 
     void emitSignalForAllInstances(const char *signal);
 
@@ -92,7 +93,11 @@ public:
     bool blurBehindWindowEnabled = false;
     std::optional<bool> extendIntoTitleBar = std::nullopt;
     bool qpaReady = false;
+    bool centeredBeforeShow = false;
     quint32 qpaWaitTime = 0;
+
+protected:
+    Q_NODISCARD bool eventFilter(QObject *object, QEvent *event) override;
 };
 
 FRAMELESSHELPER_END_NAMESPACE
@@ -79,6 +79,8 @@ public Q_SLOTS:
     void setHitTestVisible(QWidget *widget, const bool visible = true);
     void setHitTestVisible(const QRect &rect, const bool visible = true);
     void setHitTestVisible(QObject *object, const bool visible = true);
+    void setRepolishOnDprChange(QWidget *widget, const bool value = true);
+    void setForceRepaintOnDprChange(QWidget *widget, const bool value = true);
 
     void showSystemMenu(const QPoint &pos);
     void windowStartSystemMove2(const QPoint &pos);
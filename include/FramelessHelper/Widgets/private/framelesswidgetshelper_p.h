@@ -56,6 +56,7 @@ public:
 
     void attach();
     void detach();
+    void markReady();
 
     void emitSignalForAllInstances(const char *signal);
 
@@ -91,8 +92,12 @@ public:
     bool blurBehindWindowEnabled = false;
     QPointer<QWidget> window = nullptr;
     bool qpaReady = false;
+    bool centeredBeforeShow = false;
     QSizePolicy savedSizePolicy = {};
     quint32 qpaWaitTime = 0;
+
+protected:
+    Q_NODISCARD bool eventFilter(QObject *object, QEvent *event) override;
 };
 
 FRAMELESSHELPER_END_NAMESPACE
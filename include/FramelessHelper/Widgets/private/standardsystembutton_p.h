@@ -49,6 +49,11 @@ public:
 
     Q_NODISCARD static QSize getRecommendedButtonSize();
 
+    // Updates all the colors at once without triggering a repaint, the caller is
+    // responsible for repainting the button if this function returns true.
+    Q_NODISCARD bool setColors(const QColor &activeForeground, const QColor &inactiveForeground,
+        const QColor &normal, const QColor &hover, const QColor &press, const bool isActive);
+
     StandardSystemButton *q_ptr = nullptr;
     Global::SystemButtonType buttonType = Global::SystemButtonType::Unknown;
     QString glyph = {};
@@ -25,6 +25,7 @@
 #pragma once
 
 #include <FramelessHelper/Widgets/framelesshelperwidgets_global.h>
+#include <FramelessHelper/Core/chromepalette.h>
 #include <QtGui/qfont.h>
 #include <optional>
 
@@ -39,7 +40,6 @@ FRAMELESSHELPER_BEGIN_NAMESPACE
 #if FRAMELESSHELPER_CONFIG(system_button)
 class StandardSystemButton;
 #endif
-class ChromePalette;
 class StandardTitleBar;
 
 class FRAMELESSHELPER_WIDGETS_API StandardTitleBarPrivate : public QObject
@@ -73,6 +73,8 @@ public:
     Q_SLOT void updateMaximizeButton();
     Q_SLOT void updateTitleBarColor();
     Q_SLOT void updateChromeButtonColor();
+    Q_SLOT void handleChromePaletteChange(const ChromePalette::Changes changes);
+    void scheduleRepaint();
     Q_SLOT void retranslateUi();
 
     Q_NODISCARD bool mouseEventHandler(QMouseEvent *event);
@@ -34,12 +34,18 @@ HEADERS += \
     $$CORE_PRIV_INC_DIR/chromepalette_p.h \
     $$CORE_PRIV_INC_DIR/framelessconfig_p.h \
     $$CORE_PRIV_INC_DIR/framelessmanager_p.h \
+    $$CORE_PRIV_INC_DIR/themesnapshot_p.h \
     $$CORE_PRIV_INC_DIR/micamaterial_p.h \
     $$CORE_PRIV_INC_DIR/sysapiloader_p.h \
     $$CORE_PRIV_INC_DIR/windowborderpainter_p.h \
     $$CORE_PRIV_INC_DIR/framelesshelpercore_global_p.h \
     $$CORE_PRIV_INC_DIR/versionnumber_p.h \
-    $$CORE_PRIV_INC_DIR/scopeguard_p.h
+    $$CORE_PRIV_INC_DIR/scopeguard_p.h \
+    $$CORE_PRIV_INC_DIR/hittest_p.h \
+    $$CORE_PRIV_INC_DIR/repaintscheduler_p.h \
+    $$CORE_PRIV_INC_DIR/framelessstatistics_p.h \
+    $$CORE_PRIV_INC_DIR/tracing_p.h \
+    $$CORE_PRIV_INC_DIR/flightrecorder_p.h
 
 SOURCES += \
     $$CORE_SRC_DIR/chromepalette.cpp \
@@ -47,6 +53,11 @@ SOURCES += \
     $$CORE_SRC_DIR/framelesshelper_qt.cpp \
     $$CORE_SRC_DIR/framelessmanager.cpp \
     $$CORE_SRC_DIR/framelesshelpercore_global.cpp \
+    $$CORE_SRC_DIR/hittest.cpp \
+    $$CORE_SRC_DIR/repaintscheduler.cpp \
+    $$CORE_SRC_DIR/framelessstatistics.cpp \
+    $$CORE_SRC_DIR/tracing.cpp \
+    $$CORE_SRC_DIR/flightrecorder.cpp \
     $$CORE_SRC_DIR/micamaterial.cpp \
     $$CORE_SRC_DIR/sysapiloader.cpp \
     $$CORE_SRC_DIR/utils.cpp \
@@ -72,13 +83,36 @@ win32 {
 
 unix:!macx {
     CONFIG += link_pkgconfig
-    PKGCONFIG += xcb gtk+-3.0
-    DEFINES += GDK_VERSION_MIN_REQUIRED=GDK_VERSION_3_6
+    PKGCONFIG += xcb
+    # Add "CONFIG += framelesshelper_link_gtk" to link to the system GTK directly,
+    # by default it's only loaded at runtime when Option::UseGtkThemeDetection is set.
+    framelesshelper_link_gtk {
+        PKGCONFIG += gtk+-3.0
+        DEFINES += GDK_VERSION_MIN_REQUIRED=GDK_VERSION_3_6 FRAMELESSHELPER_LINK_GTK
+    }
+    qtHaveModule(dbus) {
+        QT += dbus
+        DEFINES += FRAMELESSHELPER_HAS_DBUS
+    }
     HEADERS += \
-        $$CORE_PUB_INC_DIR/framelesshelper_linux.h
+        $$CORE_PUB_INC_DIR/framelesshelper_linux.h \
+        $$CORE_PRIV_INC_DIR/x11capabilities_p.h \
+        $$CORE_PRIV_INC_DIR/x11requestbatcher_p.h \
+        $$CORE_PRIV_INC_DIR/linuxwallpaper_p.h \
+        $$CORE_PRIV_INC_DIR/linuxtheme_p.h \
+        $$CORE_PRIV_INC_DIR/settingsportal_p.h \
+        $$CORE_PRIV_INC_DIR/x11backend_p.h \
+        $$CORE_PRIV_INC_DIR/x11property_p.h
     SOURCES += \
         $$CORE_SRC_DIR/utils_linux.cpp \
-        $$CORE_SRC_DIR/platformsupport_linux.cpp
+        $$CORE_SRC_DIR/platformsupport_linux.cpp \
+        $$CORE_SRC_DIR/x11capabilities.cpp \
+        $$CORE_SRC_DIR/x11requestbatcher.cpp \
+        $$CORE_SRC_DIR/linuxwallpaper.cpp \
+        $$CORE_SRC_DIR/linuxtheme.cpp \
+        $$CORE_SRC_DIR/settingsportal.cpp \
+        $$CORE_SRC_DIR/x11backend.cpp \
+        $$CORE_SRC_DIR/x11property.cpp
 }
 
 macx {
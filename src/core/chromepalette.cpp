@@ -28,8 +28,11 @@
 #if FRAMELESSHELPER_CONFIG(titlebar)
 
 #include "framelessmanager.h"
+#include "framelessmanager_p.h"
+#include "tracing_p.h"
 #include "utils.h"
 #include <QtCore/qloggingcategory.h>
+#include <utility>
 
 FRAMELESSHELPER_BEGIN_NAMESPACE
 
@@ -81,55 +84,90 @@ const ChromePalettePrivate *ChromePalettePrivate::get(const ChromePalette *q)
 
 void ChromePalettePrivate::refresh()
 {
-    const bool colorized = Utils::isTitleBarColorized();
-    const bool dark = (FramelessManager::instance()->systemTheme() == SystemTheme::Dark);
-    titleBarActiveBackgroundColor_sys = [colorized, dark]() -> QColor {
-        if (colorized) {
-            return Utils::getAccentColor();
-        } else {
-            return (dark ? kDefaultBlackColor : kDefaultWhiteColor);
+    const Trace::Span span("ChromePalette::refresh");
+    // All the system colors are computed only once per theme change and
+    // shared by all palettes, no need to query the system again here.
+    const ThemeSnapshotPtr theme = FramelessManagerPrivate::currentThemeSnapshot();
+    ChromePalette::Changes changes = {};
+    // Only notify the colors that really changed and are not overridden by the user.
+    const auto update = [&changes](QColor &sys, const QColor &value, const std::optional<QColor> &user, const ChromePalette::ChangeFlag flag) {
+        if (sys == value) {
+            return;
         }
-    }();
-    titleBarInactiveBackgroundColor_sys = (dark ? kDefaultSystemDarkColor : kDefaultWhiteColor);
-    titleBarActiveForegroundColor_sys = [this, dark, colorized]() -> QColor {
-        if (dark || colorized) {
-            // Calculate the most appropriate foreground color, based on the
-            // current background color.
-            const qreal grayF = (
-                (qreal(0.299) * titleBarActiveBackgroundColor_sys.redF()) +
-                (qreal(0.587) * titleBarActiveBackgroundColor_sys.greenF()) +
-                (qreal(0.114) * titleBarActiveBackgroundColor_sys.blueF()));
-            static constexpr const auto kFlag = qreal(0.5);
-            if ((grayF < kFlag) || qFuzzyCompare(grayF, kFlag)) {
-                return kDefaultWhiteColor;
-            }
+        sys = value;
+        if (!user.has_value()) {
+            changes |= flag;
         }
-        return kDefaultBlackColor;
-    }();
-    titleBarInactiveForegroundColor_sys = kDefaultDarkGrayColor;
-    chromeButtonNormalColor_sys = kDefaultTransparentColor;
-    chromeButtonHoverColor_sys =
-        Utils::calculateSystemButtonBackgroundColor(SystemButtonType::Minimize, ButtonState::Hovered);
-    chromeButtonPressColor_sys =
-        Utils::calculateSystemButtonBackgroundColor(SystemButtonType::Minimize, ButtonState::Pressed);
-    closeButtonNormalColor_sys = kDefaultTransparentColor;
-    closeButtonHoverColor_sys =
-        Utils::calculateSystemButtonBackgroundColor(SystemButtonType::Close, ButtonState::Hovered);
-    closeButtonPressColor_sys =
-        Utils::calculateSystemButtonBackgroundColor(SystemButtonType::Close, ButtonState::Pressed);
+    };
+    using Flag = ChromePalette::ChangeFlag;
+    update(titleBarActiveBackgroundColor_sys, theme->titleBarActiveBackgroundColor, titleBarActiveBackgroundColor, Flag::TitleBarActiveBackgroundColor);
+    update(titleBarInactiveBackgroundColor_sys, theme->titleBarInactiveBackgroundColor, titleBarInactiveBackgroundColor, Flag::TitleBarInactiveBackgroundColor);
+    update(titleBarActiveForegroundColor_sys, theme->titleBarActiveForegroundColor, titleBarActiveForegroundColor, Flag::TitleBarActiveForegroundColor);
+    update(titleBarInactiveForegroundColor_sys, theme->titleBarInactiveForegroundColor, titleBarInactiveForegroundColor, Flag::TitleBarInactiveForegroundColor);
+    update(chromeButtonNormalColor_sys, theme->systemButtonBackgroundColor(SystemButtonType::Minimize, ButtonState::Normal), chromeButtonNormalColor, Flag::ChromeButtonNormalColor);
+    update(chromeButtonHoverColor_sys, theme->systemButtonBackgroundColor(SystemButtonType::Minimize, ButtonState::Hovered), chromeButtonHoverColor, Flag::ChromeButtonHoverColor);
+    update(chromeButtonPressColor_sys, theme->systemButtonBackgroundColor(SystemButtonType::Minimize, ButtonState::Pressed), chromeButtonPressColor, Flag::ChromeButtonPressColor);
+    update(closeButtonNormalColor_sys, theme->systemButtonBackgroundColor(SystemButtonType::Close, ButtonState::Normal), closeButtonNormalColor, Flag::CloseButtonNormalColor);
+    update(closeButtonHoverColor_sys, theme->systemButtonBackgroundColor(SystemButtonType::Close, ButtonState::Hovered), closeButtonHoverColor, Flag::CloseButtonHoverColor);
+    update(closeButtonPressColor_sys, theme->systemButtonBackgroundColor(SystemButtonType::Close, ButtonState::Pressed), closeButtonPressColor, Flag::CloseButtonPressColor);
+    markChanged(changes);
+}
+
+void ChromePalettePrivate::markChanged(const ChromePalette::Changes changes)
+{
+    pendingChanges |= changes;
+    if (updateDepth > 0) {
+        return;
+    }
+    flushChanges();
+}
+
+void ChromePalettePrivate::flushChanges()
+{
+    const ChromePalette::Changes changes = std::exchange(pendingChanges, {});
+    if (!changes) {
+        return;
+    }
+    using Flag = ChromePalette::ChangeFlag;
     Q_Q(ChromePalette);
-    Q_EMIT q->titleBarActiveBackgroundColorChanged();
-    Q_EMIT q->titleBarInactiveBackgroundColorChanged();
-    Q_EMIT q->titleBarActiveForegroundColorChanged();
-    Q_EMIT q->titleBarInactiveForegroundColorChanged();
-    Q_EMIT q->chromeButtonNormalColorChanged();
-    Q_EMIT q->chromeButtonHoverColorChanged();
-    Q_EMIT q->chromeButtonPressColorChanged();
-    Q_EMIT q->closeButtonNormalColorChanged();
-    Q_EMIT q->closeButtonHoverColorChanged();
-    Q_EMIT q->closeButtonPressColorChanged();
-    Q_EMIT q->titleBarColorChanged();
-    Q_EMIT q->chromeButtonColorChanged();
+    if (changes.testFlag(Flag::TitleBarActiveBackgroundColor)) {
+        Q_EMIT q->titleBarActiveBackgroundColorChanged();
+    }
+    if (changes.testFlag(Flag::TitleBarInactiveBackgroundColor)) {
+        Q_EMIT q->titleBarInactiveBackgroundColorChanged();
+    }
+    if (changes.testFlag(Flag::TitleBarActiveForegroundColor)) {
+        Q_EMIT q->titleBarActiveForegroundColorChanged();
+    }
+    if (changes.testFlag(Flag::TitleBarInactiveForegroundColor)) {
+        Q_EMIT q->titleBarInactiveForegroundColorChanged();
+    }
+    if (changes.testFlag(Flag::ChromeButtonNormalColor)) {
+        Q_EMIT q->chromeButtonNormalColorChanged();
+    }
+    if (changes.testFlag(Flag::ChromeButtonHoverColor)) {
+        Q_EMIT q->chromeButtonHoverColorChanged();
+    }
+    if (changes.testFlag(Flag::ChromeButtonPressColor)) {
+        Q_EMIT q->chromeButtonPressColorChanged();
+    }
+    if (changes.testFlag(Flag::CloseButtonNormalColor)) {
+        Q_EMIT q->closeButtonNormalColorChanged();
+    }
+    if (changes.testFlag(Flag::CloseButtonHoverColor)) {
+        Q_EMIT q->closeButtonHoverColorChanged();
+    }
+    if (changes.testFlag(Flag::CloseButtonPressColor)) {
+        Q_EMIT q->closeButtonPressColorChanged();
+    }
+    // The aggregated signals are emitted only once, no matter how many colors have changed.
+    if (!!(changes & Flag::TitleBarColors)) {
+        Q_EMIT q->titleBarColorChanged();
+    }
+    if (!!(changes & Flag::ChromeButtonColors)) {
+        Q_EMIT q->chromeButtonColorChanged();
+    }
+    Q_EMIT q->changed(changes);
 }
 
 ChromePalette::ChromePalette(QObject *parent) :
@@ -199,6 +237,25 @@ QColor ChromePalette::closeButtonPressColor() const
     return d->closeButtonPressColor.value_or(d->closeButtonPressColor_sys);
 }
 
+void ChromePalette::beginUpdate()
+{
+    Q_D(ChromePalette);
+    ++d->updateDepth;
+}
+
+void ChromePalette::endUpdate()
+{
+    Q_D(ChromePalette);
+    Q_ASSERT(d->updateDepth > 0);
+    if (d->updateDepth <= 0) {
+        return;
+    }
+    if (--d->updateDepth > 0) {
+        return;
+    }
+    d->flushChanges();
+}
+
 void ChromePalette::setTitleBarActiveBackgroundColor(const QColor &value)
 {
     Q_ASSERT(value.isValid());
@@ -210,16 +267,14 @@ void ChromePalette::setTitleBarActiveBackgroundColor(const QColor &value)
         return;
     }
     d->titleBarActiveBackgroundColor = value;
-    Q_EMIT titleBarActiveBackgroundColorChanged();
-    Q_EMIT titleBarColorChanged();
+    d->markChanged(ChangeFlag::TitleBarActiveBackgroundColor);
 }
 
 void ChromePalette::resetTitleBarActiveBackgroundColor()
 {
     Q_D(ChromePalette);
     d->titleBarActiveBackgroundColor = std::nullopt;
-    Q_EMIT titleBarActiveBackgroundColorChanged();
-    Q_EMIT titleBarColorChanged();
+    d->markChanged(ChangeFlag::TitleBarActiveBackgroundColor);
 }
 
 void ChromePalette::setTitleBarInactiveBackgroundColor(const QColor &value)
@@ -233,16 +288,14 @@ void ChromePalette::setTitleBarInactiveBackgroundColor(const QColor &value)
         return;
     }
     d->titleBarInactiveBackgroundColor = value;
-    Q_EMIT titleBarInactiveBackgroundColorChanged();
-    Q_EMIT titleBarColorChanged();
+    d->markChanged(ChangeFlag::TitleBarInactiveBackgroundColor);
 }
 
 void ChromePalette::resetTitleBarInactiveBackgroundColor()
 {
     Q_D(ChromePalette);
     d->titleBarInactiveBackgroundColor = std::nullopt;
-    Q_EMIT titleBarInactiveBackgroundColorChanged();
-    Q_EMIT titleBarColorChanged();
+    d->markChanged(ChangeFlag::TitleBarInactiveBackgroundColor);
 }
 
 void ChromePalette::setTitleBarActiveForegroundColor(const QColor &value)
@@ -256,16 +309,14 @@ void ChromePalette::setTitleBarActiveForegroundColor(const QColor &value)
         return;
     }
     d->titleBarActiveForegroundColor = value;
-    Q_EMIT titleBarActiveForegroundColorChanged();
-    Q_EMIT titleBarColorChanged();
+    d->markChanged(ChangeFlag::TitleBarActiveForegroundColor);
 }
 
 void ChromePalette::resetTitleBarActiveForegroundColor()
 {
     Q_D(ChromePalette);
     d->titleBarActiveForegroundColor = std::nullopt;
-    Q_EMIT titleBarActiveForegroundColorChanged();
-    Q_EMIT titleBarColorChanged();
+    d->markChanged(ChangeFlag::TitleBarActiveForegroundColor);
 }
 
 void ChromePalette::setTitleBarInactiveForegroundColor(const QColor &value)
@@ -279,16 +330,14 @@ void ChromePalette::setTitleBarInactiveForegroundColor(const QColor &value)
         return;
     }
     d->titleBarInactiveForegroundColor = value;
-    Q_EMIT titleBarInactiveForegroundColorChanged();
-    Q_EMIT titleBarColorChanged();
+    d->markChanged(ChangeFlag::TitleBarInactiveForegroundColor);
 }
 
 void ChromePalette::resetTitleBarInactiveForegroundColor()
 {
     Q_D(ChromePalette);
     d->titleBarInactiveForegroundColor = std::nullopt;
-    Q_EMIT titleBarInactiveForegroundColorChanged();
-    Q_EMIT titleBarColorChanged();
+    d->markChanged(ChangeFlag::TitleBarInactiveForegroundColor);
 }
 
 void ChromePalette::setChromeButtonNormalColor(const QColor &value)
@@ -302,16 +351,14 @@ void ChromePalette::setChromeButtonNormalColor(const QColor &value)
         return;
     }
     d->chromeButtonNormalColor = value;
-    Q_EMIT chromeButtonNormalColorChanged();
-    Q_EMIT chromeButtonColorChanged();
+    d->markChanged(ChangeFlag::ChromeButtonNormalColor);
 }
 
 void ChromePalette::resetChromeButtonNormalColor()
 {
     Q_D(ChromePalette);
     d->chromeButtonNormalColor = std::nullopt;
-    Q_EMIT chromeButtonNormalColorChanged();
-    Q_EMIT chromeButtonColorChanged();
+    d->markChanged(ChangeFlag::ChromeButtonNormalColor);
 }
 
 void ChromePalette::setChromeButtonHoverColor(const QColor &value)
@@ -325,16 +372,14 @@ void ChromePalette::setChromeButtonHoverColor(const QColor &value)
         return;
     }
     d->chromeButtonHoverColor = value;
-    Q_EMIT chromeButtonHoverColorChanged();
-    Q_EMIT chromeButtonColorChanged();
+    d->markChanged(ChangeFlag::ChromeButtonHoverColor);
 }
 
 void ChromePalette::resetChromeButtonHoverColor()
 {
     Q_D(ChromePalette);
     d->chromeButtonHoverColor = std::nullopt;
-    Q_EMIT chromeButtonHoverColorChanged();
-    Q_EMIT chromeButtonColorChanged();
+    d->markChanged(ChangeFlag::ChromeButtonHoverColor);
 }
 
 void ChromePalette::setChromeButtonPressColor(const QColor &value)
@@ -348,16 +393,14 @@ void ChromePalette::setChromeButtonPressColor(const QColor &value)
         return;
     }
     d->chromeButtonPressColor = value;
-    Q_EMIT chromeButtonPressColorChanged();
-    Q_EMIT chromeButtonColorChanged();
+    d->markChanged(ChangeFlag::ChromeButtonPressColor);
 }
 
 void ChromePalette::resetChromeButtonPressColor()
 {
     Q_D(ChromePalette);
     d->chromeButtonPressColor = std::nullopt;
-    Q_EMIT chromeButtonPressColorChanged();
-    Q_EMIT chromeButtonColorChanged();
+    d->markChanged(ChangeFlag::ChromeButtonPressColor);
 }
 
 void ChromePalette::setCloseButtonNormalColor(const QColor &value)
@@ -371,16 +414,14 @@ void ChromePalette::setCloseButtonNormalColor(const QColor &value)
         return;
     }
     d->closeButtonNormalColor = value;
-    Q_EMIT closeButtonNormalColorChanged();
-    Q_EMIT chromeButtonColorChanged();
+    d->markChanged(ChangeFlag::CloseButtonNormalColor);
 }
 
 void ChromePalette::resetCloseButtonNormalColor()
 {
     Q_D(ChromePalette);
     d->closeButtonNormalColor = std::nullopt;
-    Q_EMIT closeButtonNormalColorChanged();
-    Q_EMIT chromeButtonColorChanged();
+    d->markChanged(ChangeFlag::CloseButtonNormalColor);
 }
 
 void ChromePalette::setCloseButtonHoverColor(const QColor &value)
@@ -394,16 +435,14 @@ void ChromePalette::setCloseButtonHoverColor(const QColor &value)
         return;
     }
     d->closeButtonHoverColor = value;
-    Q_EMIT closeButtonHoverColorChanged();
-    Q_EMIT chromeButtonColorChanged();
+    d->markChanged(ChangeFlag::CloseButtonHoverColor);
 }
 
 void ChromePalette::resetCloseButtonHoverColor()
 {
     Q_D(ChromePalette);
     d->closeButtonHoverColor = std::nullopt;
-    Q_EMIT closeButtonHoverColorChanged();
-    Q_EMIT chromeButtonColorChanged();
+    d->markChanged(ChangeFlag::CloseButtonHoverColor);
 }
 
 void ChromePalette::setCloseButtonPressColor(const QColor &value)
@@ -417,16 +456,14 @@ void ChromePalette::setCloseButtonPressColor(const QColor &value)
         return;
     }
     d->closeButtonPressColor = value;
-    Q_EMIT closeButtonPressColorChanged();
-    Q_EMIT chromeButtonColorChanged();
+    d->markChanged(ChangeFlag::CloseButtonPressColor);
 }
 
 void ChromePalette::resetCloseButtonPressColor()
 {
     Q_D(ChromePalette);
     d->closeButtonPressColor = std::nullopt;
-    Q_EMIT closeButtonPressColorChanged();
-    Q_EMIT chromeButtonColorChanged();
+    d->markChanged(ChangeFlag::CloseButtonPressColor);
 }
 
 FRAMELESSHELPER_END_NAMESPACE
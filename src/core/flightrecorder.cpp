@@ -0,0 +1,282 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021-2023 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "flightrecorder_p.h"
+#include <QtCore/qcoreapplication.h>
+#include <QtCore/qdir.h>
+#include <QtCore/qfile.h>
+#include <QtCore/qloggingcategory.h>
+#include <QtCore/qmutex.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#ifdef Q_OS_WINDOWS
+#  include <io.h>
+#else
+#  include <unistd.h>
+#endif
+
+FRAMELESSHELPER_BEGIN_NAMESPACE
+
+#if FRAMELESSHELPER_CONFIG(debug_output)
+[[maybe_unused]] static Q_LOGGING_CATEGORY(lcFlightRecorder, "wangwenx190.framelesshelper.core.flightrecorder")
+#  define INFO qCInfo(lcFlightRecorder)
+#  define DEBUG qCDebug(lcFlightRecorder)
+#  define WARNING qCWarning(lcFlightRecorder)
+#  define CRITICAL qCCritical(lcFlightRecorder)
+#else
+#  define INFO QT_NO_QDEBUG_MACRO()
+#  define DEBUG QT_NO_QDEBUG_MACRO()
+#  define WARNING QT_NO_QDEBUG_MACRO()
+#  define CRITICAL QT_NO_QDEBUG_MACRO()
+#endif
+
+using namespace Global;
+
+// Must be a power of two. 4096 * 32 bytes = 128 KiB, which covers the last few
+// minutes of interaction while being small enough to always keep around.
+static constexpr const quint64 kRingCapacity = (1ull << 12);
+static constexpr const quint64 kRingMask = (kRingCapacity - 1);
+static constexpr const char kRawMagic[4] = { 'F', 'H', 'F', 'R' };
+static constexpr const quint32 kRawVersion = 1;
+
+// Every field is an atomic so that concurrent writers and the dumping thread never
+// race in the C++ sense. The sequence works like a seqlock: it's odd while the slot
+// is being written and "2 * (index + 1)" once the record with that index is complete.
+struct Slot
+{
+    std::atomic<quint64> sequence{ 0 };
+    std::atomic<quint64> timestamp{ 0 };
+    std::atomic<quint64> windowId{ 0 };
+    std::atomic<quint64> payload{ 0 }; // event | arg2 << 16 | arg1 << 32
+};
+
+// Plain static storage instead of Q_GLOBAL_STATIC: the ring must stay usable
+// from signal handlers and during static destruction.
+static std::array<Slot, kRingCapacity> g_ring = {};
+static std::atomic<quint64> g_head{ 0 };
+static std::atomic<quint64> g_epoch{ 0 };
+
+struct SymbolNameData
+{
+    QMutex mutex{};
+    QStringList names = {};
+};
+
+Q_GLOBAL_STATIC(SymbolNameData, g_symbolNameData)
+
+[[nodiscard]] static inline quint64 steadyNanoseconds() noexcept
+{
+    return quint64(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+[[nodiscard]] static inline bool readSlot(const quint64 index, FlightRecorder::Record &record) noexcept
+{
+    const Slot &slot = g_ring[index & kRingMask];
+    const quint64 expected = ((index + 1) << 1);
+    if (slot.sequence.load(std::memory_order_acquire) != expected) {
+        return false;
+    }
+    const quint64 payload = slot.payload.load(std::memory_order_relaxed);
+    record.sequence = index;
+    record.timestamp = slot.timestamp.load(std::memory_order_relaxed);
+    record.windowId = slot.windowId.load(std::memory_order_relaxed);
+    record.event = quint16(payload & 0xFFFF);
+    record.arg2 = quint16((payload >> 16) & 0xFFFF);
+    record.arg1 = quint32(payload >> 32);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    // A writer lapped us while we were copying, the record is torn.
+    return (slot.sequence.load(std::memory_order_relaxed) == expected);
+}
+
+[[nodiscard]] static inline bool writeAll(const int fd, const void *data, const size_t size) noexcept
+{
+    auto bytes = static_cast<const char *>(data);
+    size_t remaining = size;
+    while (remaining > 0) {
+#ifdef Q_OS_WINDOWS
+        const int written = ::_write(fd, bytes, unsigned(remaining));
+#else
+        const ssize_t written = ::write(fd, bytes, remaining);
+#endif
+        if (written <= 0) {
+            return false;
+        }
+        bytes += written;
+        remaining -= size_t(written);
+    }
+    return true;
+}
+
+[[nodiscard]] static inline const char *eventName(const quint16 event)
+{
+    switch (FlightRecorder::Event(event)) {
+    case FlightRecorder::Event::Invalid:
+        break;
+    case FlightRecorder::Event::WindowAdded:
+        return "WindowAdded";
+    case FlightRecorder::Event::WindowRemoved:
+        return "WindowRemoved";
+    case FlightRecorder::Event::WindowStateChanged:
+        return "WindowStateChanged";
+    case FlightRecorder::Event::HitTestAtPress:
+        return "HitTestAtPress";
+    case FlightRecorder::Event::ThemeChanged:
+        return "ThemeChanged";
+    case FlightRecorder::Event::WallpaperChanged:
+        return "WallpaperChanged";
+    case FlightRecorder::Event::SysApiFailure:
+        return "SysApiFailure";
+    }
+    return "Invalid";
+}
+
+[[nodiscard]] static inline QString defaultDumpFilePath()
+{
+    const QString path = qEnvironmentVariable(kFlightRecorderFileVar);
+    if (!path.isEmpty()) {
+        return path;
+    }
+    return QDir::temp().filePath(FRAMELESSHELPER_STRING_LITERAL("framelesshelper-flightrecorder-%1.txt").arg(QCoreApplication::applicationPid()));
+}
+
+void FlightRecorder::record(const Event event, const WId windowId, const quint32 arg1, const quint16 arg2) noexcept
+{
+    const quint64 now = steadyNanoseconds();
+    quint64 epoch = g_epoch.load(std::memory_order_relaxed);
+    // Whoever gets here first defines time zero, a failed exchange loads the winner's value.
+    if ((epoch == 0) && g_epoch.compare_exchange_strong(epoch, now, std::memory_order_relaxed)) {
+        epoch = now;
+    }
+    const quint64 index = g_head.fetch_add(1, std::memory_order_relaxed);
+    Slot &slot = g_ring[index & kRingMask];
+    slot.sequence.store((index << 1) | 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.timestamp.store(now - epoch, std::memory_order_relaxed);
+    slot.windowId.store(quint64(windowId), std::memory_order_relaxed);
+    slot.payload.store(quint64(event) | (quint64(arg2) << 16) | (quint64(arg1) << 32), std::memory_order_relaxed);
+    slot.sequence.store((index + 1) << 1, std::memory_order_release);
+}
+
+quint32 FlightRecorder::internSymbolName(const QString &name)
+{
+    if (name.isEmpty() || g_symbolNameData.isDestroyed()) {
+        return 0;
+    }
+    const QMutexLocker locker(&g_symbolNameData()->mutex);
+    QStringList &names = g_symbolNameData()->names;
+    const qsizetype index = names.indexOf(name);
+    if (index >= 0) {
+        return quint32(index) + 1;
+    }
+    names.append(name);
+    return quint32(names.size());
+}
+
+QString FlightRecorder::symbolName(const quint32 index)
+{
+    if ((index == 0) || g_symbolNameData.isDestroyed()) {
+        return {};
+    }
+    const QMutexLocker locker(&g_symbolNameData()->mutex);
+    return g_symbolNameData()->names.value(qsizetype(index) - 1);
+}
+
+bool FlightRecorder::dump(const QString &filePath)
+{
+    const QString path = (filePath.isEmpty() ? defaultDumpFilePath() : filePath);
+    QFile file(path);
+    if (!file.open(QFile::WriteOnly | QFile::Truncate | QFile::Text)) {
+        WARNING << "Failed to open" << path << "to write the flight recorder:" << file.errorString();
+        return false;
+    }
+    const quint64 head = g_head.load(std::memory_order_acquire);
+    const quint64 first = ((head > kRingCapacity) ? (head - kRingCapacity) : 0);
+    QByteArray text = {};
+    text.reserve(int((head - first) * 80));
+    for (quint64 index = first; index != head; ++index) {
+        Record record = {};
+        if (!readSlot(index, record)) {
+            continue;
+        }
+        text.append(QByteArray::number(record.sequence) + ' '
+            + QByteArray::number(qreal(record.timestamp) / qreal(1000000), 'f', 3) + "ms "
+            + eventName(record.event) + " window=0x" + QByteArray::number(record.windowId, 16)
+            + " arg1=" + QByteArray::number(record.arg1) + " arg2=" + QByteArray::number(record.arg2));
+        if (FlightRecorder::Event(record.event) == Event::SysApiFailure) {
+            text.append(" symbol=" + symbolName(record.arg1).toUtf8());
+        }
+        text.append('\n');
+    }
+    if (file.write(text) != text.size()) {
+        WARNING << "Failed to write the flight recorder to" << path << ':' << file.errorString();
+        return false;
+    }
+    INFO << "Flight recorder written to" << path << ", events:" << (head - first) << ", lost:" << first;
+    return true;
+}
+
+bool FlightRecorder::dumpRaw(const int fd) noexcept
+{
+    // No allocation, no locking and no Qt: only plain stores and write(2).
+    if (fd < 0) {
+        return false;
+    }
+    const quint64 head = g_head.load(std::memory_order_acquire);
+    const quint64 first = ((head > kRingCapacity) ? (head - kRingCapacity) : 0);
+    const quint32 count = quint32(head - first);
+    char header[16] = {};
+    std::memcpy(header, kRawMagic, sizeof(kRawMagic));
+    std::memcpy(header + 4, &kRawVersion, sizeof(kRawVersion));
+    std::memcpy(header + 8, &count, sizeof(count));
+    if (!writeAll(fd, header, sizeof(header))) {
+        return false;
+    }
+    // Small chunks so that we don't need much stack inside a signal handler.
+    std::array<Record, 32> chunk = {};
+    size_t used = 0;
+    for (quint64 index = first; index != head; ++index) {
+        Record &record = chunk[used];
+        if (!readSlot(index, record)) {
+            // Keep the count in the header right, torn records are marked as invalid.
+            record = Record{};
+            record.sequence = index;
+        }
+        if (++used == chunk.size()) {
+            if (!writeAll(fd, chunk.data(), used * sizeof(Record))) {
+                return false;
+            }
+            used = 0;
+        }
+    }
+    return ((used == 0) || writeAll(fd, chunk.data(), used * sizeof(Record)));
+}
+
+bool FramelessHelperDumpFlightRecorder(const QString &filePath)
+{
+    return FlightRecorder::dump(filePath);
+}
+
+FRAMELESSHELPER_END_NAMESPACE
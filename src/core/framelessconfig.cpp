@@ -26,6 +26,9 @@
 #include <array>
 #include <memory>
 #include <QtCore/qdir.h>
+#include <QtCore/qfileinfo.h>
+#include <QtCore/qfilesystemwatcher.h>
+#include <QtCore/qmutex.h>
 #include <QtCore/qsettings.h>
 #include <QtCore/qcoreapplication.h>
 #include <QtCore/qtimer.h>
@@ -66,21 +69,69 @@ static constexpr const std::array<FramelessConfigEntry, static_cast<int>(Option:
     FramelessConfigEntry{ "FRAMELESSHELPER_FORCE_NON_NATIVE_BACKGROUND_BLUR", "Options/ForceNonNativeBackgroundBlur" },
     FramelessConfigEntry{ "FRAMELESSHELPER_DISABLE_LAZY_INITIALIZATION_FOR_MICA_MATERIAL", "Options/DisableLazyInitializationForMicaMaterial" },
     FramelessConfigEntry{ "FRAMELESSHELPER_FORCE_NATIVE_BACKGROUND_BLUR", "Options/ForceNativeBackgroundBlur" },
-    FramelessConfigEntry{ "FRAMELESSHELPER_WINDOW_USE_SQUARE_CORNERS", "Options/WindowUseSquareCorners" }
+    FramelessConfigEntry{ "FRAMELESSHELPER_WINDOW_USE_SQUARE_CORNERS", "Options/WindowUseSquareCorners" },
+    FramelessConfigEntry{ "FRAMELESSHELPER_COALESCE_HOVER_MOUSE_MOVES", "Options/CoalesceHoverMouseMoves" },
+    FramelessConfigEntry{ "FRAMELESSHELPER_ENABLE_TRACING", "Options/EnableTracing" },
+    FramelessConfigEntry{ "FRAMELESSHELPER_ENABLE_CONFIG_HOT_RELOAD", "Options/EnableConfigHotReload" },
+    FramelessConfigEntry{ "FRAMELESSHELPER_USE_GTK_THEME_DETECTION", "Options/UseGtkThemeDetection" }
 };
 
 static constexpr const auto OptionCount = std::size(FramelessOptionsTable);
 
+static_assert(OptionCount <= 32, "The options no longer fit into FramelessConfig::Snapshot.");
+
+// Editors usually save a file in several steps, only reload once they are done.
+static constexpr const int kHotReloadDelay = 200; // ms
+
 struct FramelessConfigData
 {
+    QMutex mutex{}; // Serializes the writers only, readers just load the snapshot.
     bool loaded = false;
-    std::array<bool, OptionCount> options = {};
+    quint32 loadedOptions = 0; // From the environment variables and the configuration file.
+    quint32 overrideMask = 0; // Options changed through set().
+    quint32 overrideValues = 0;
     bool disableEnvVar = false;
     bool disableCfgFile = false;
+    bool loadedWithoutApp = false; // The configuration file couldn't be located yet.
+    std::atomic<quint64> snapshot{ 0 }; // version << 32 | options
 };
 
 Q_GLOBAL_STATIC(FramelessConfigData, g_framelessConfigData)
 
+[[nodiscard]] static inline QString configFilePath()
+{
+    if (!qApp) {
+        return {};
+    }
+    const QDir appDir(QCoreApplication::applicationDirPath());
+    return appDir.filePath(FRAMELESSHELPER_STRING_LITERAL(".framelesshelper.ini"));
+}
+
+// Must be called with the mutex held. Returns whether any option has changed.
+[[nodiscard]] static inline bool publishSnapshot(FramelessConfigData &data)
+{
+    const quint32 options = ((data.loadedOptions & ~data.overrideMask) | (data.overrideValues & data.overrideMask));
+    const quint64 current = data.snapshot.load(std::memory_order_relaxed);
+    const auto version = quint32(current >> 32);
+    if ((version != 0) && (quint32(current) == options)) {
+        return false;
+    }
+    data.snapshot.store((quint64(version + 1) << 32) | options, std::memory_order_release);
+    return true;
+}
+
+// The configuration file lives next to the executable, which can't be located before
+// the application object exists. If someone has loaded the options before that, load
+// them again (and start the hot reload) once the application has been created.
+static void reloadConfigurationForApplication()
+{
+    if (!g_framelessConfigData()->loadedWithoutApp) {
+        return;
+    }
+    FramelessConfig::instance()->reload(true);
+}
+Q_COREAPP_STARTUP_FUNCTION(reloadConfigurationForApplication)
+
 #if FRAMELESSHELPER_CONFIG(debug_output)
 static inline void warnInappropriateOptions()
 {
@@ -134,34 +185,146 @@ void FramelessConfig::reload(const bool force)
         return;
     }
     const auto configFile = []() -> std::unique_ptr<QSettings> {
-        if (!qApp) {
+        const QString filePath = configFilePath();
+        if (filePath.isEmpty()) {
             return nullptr;
         }
-        const QDir appDir(QCoreApplication::applicationDirPath());
-        return std::make_unique<QSettings>(appDir.filePath(FRAMELESSHELPER_STRING_LITERAL(".framelesshelper.ini")), QSettings::IniFormat);
+        return std::make_unique<QSettings>(filePath, QSettings::IniFormat);
     }();
+    quint32 options = 0;
     for (int i = 0; i != OptionCount; ++i) {
         const bool envVar = (!g_framelessConfigData()->disableEnvVar
             && qEnvironmentVariableIsSet(FramelessOptionsTable.at(i).env)
             && (qEnvironmentVariableIntValue(FramelessOptionsTable.at(i).env) > 0));
         const bool cfgFile = (!g_framelessConfigData()->disableCfgFile && configFile
             && configFile->value(QUtf8String(FramelessOptionsTable.at(i).cfg), false).toBool());
-        g_framelessConfigData()->options.at(i) = (envVar || cfgFile);
+        if (envVar || cfgFile) {
+            options |= (quint32(1) << i);
+        }
+    }
+    bool firstLoad = false;
+    bool changed = false;
+    {
+        const QMutexLocker locker(&g_framelessConfigData()->mutex);
+        firstLoad = !g_framelessConfigData()->loaded;
+        g_framelessConfigData()->loadedOptions = options;
+        g_framelessConfigData()->loaded = true;
+        g_framelessConfigData()->loadedWithoutApp = !qApp;
+        changed = publishSnapshot(*g_framelessConfigData());
+    }
+    updateHotReload();
+    if (changed && !firstLoad) {
+        INFO << "Configuration reloaded, version:" << quint32(g_framelessConfigData()->snapshot.load(std::memory_order_relaxed) >> 32);
+        Q_EMIT optionsChanged();
     }
-    g_framelessConfigData()->loaded = true;
 #if FRAMELESSHELPER_CONFIG(debug_output)
-    QTimer::singleShot(0, this, [](){ warnInappropriateOptions(); });
+    if (qApp) {
+        QTimer::singleShot(0, this, [](){ warnInappropriateOptions(); });
+    }
 #endif
 }
 
 void FramelessConfig::set(const Option option, const bool on)
 {
-    g_framelessConfigData()->options.at(static_cast<int>(option)) = on;
+    const quint32 bit = (quint32(1) << static_cast<int>(option));
+    bool changed = false;
+    {
+        const QMutexLocker locker(&g_framelessConfigData()->mutex);
+        g_framelessConfigData()->overrideMask |= bit;
+        if (on) {
+            g_framelessConfigData()->overrideValues |= bit;
+        } else {
+            g_framelessConfigData()->overrideValues &= ~bit;
+        }
+        changed = publishSnapshot(*g_framelessConfigData());
+    }
+    if (option == Option::EnableConfigHotReload) {
+        updateHotReload();
+    }
+    if (changed) {
+        Q_EMIT optionsChanged();
+    }
 }
 
 bool FramelessConfig::isSet(const Option option) const
 {
-    return g_framelessConfigData()->options.at(static_cast<int>(option));
+    return snapshot().isSet(option);
+}
+
+FramelessConfig::Snapshot FramelessConfig::snapshot()
+{
+    // Make sure the options have been loaded at least once.
+    std::ignore = instance();
+    const quint64 value = g_framelessConfigData()->snapshot.load(std::memory_order_acquire);
+    return Snapshot{ quint32(value >> 32), quint32(value) };
+}
+
+quint32 FramelessConfig::version()
+{
+    return snapshot().version;
+}
+
+bool FramelessConfig::isLoaded()
+{
+    if (g_framelessConfigData.isDestroyed()) {
+        return false;
+    }
+    // The first snapshot is published by the first load.
+    return ((g_framelessConfigData()->snapshot.load(std::memory_order_acquire) >> 32) != 0);
+}
+
+void FramelessConfig::updateHotReload()
+{
+    // Also called from the constructor, so don't go through instance() here.
+    const quint64 value = g_framelessConfigData()->snapshot.load(std::memory_order_acquire);
+    const bool enable = (Snapshot{ quint32(value >> 32), quint32(value) }.isSet(Option::EnableConfigHotReload)
+        && !g_framelessConfigData()->disableCfgFile);
+    if (!enable) {
+        if (m_watcher) {
+            delete m_watcher;
+            m_watcher = nullptr;
+            DEBUG << "Configuration hot reload disabled.";
+        }
+        return;
+    }
+    if (m_watcher) {
+        return;
+    }
+    const QString filePath = configFilePath();
+    if (filePath.isEmpty()) {
+        // No application yet, reloadConfigurationForApplication() will get us here again.
+        return;
+    }
+    if (!m_reloadTimer) {
+        m_reloadTimer = new QTimer(this);
+        m_reloadTimer->setSingleShot(true);
+        m_reloadTimer->setInterval(kHotReloadDelay);
+        connect(m_reloadTimer, &QTimer::timeout, this, [this](){ reload(true); });
+    }
+    m_watcher = new QFileSystemWatcher(this);
+    // Many editors save by replacing the file, which silently drops a file watch,
+    // so also watch the directory to notice the new file.
+    const auto onChanged = [this](){
+        rewatchConfigurationFile();
+        m_reloadTimer->start();
+    };
+    connect(m_watcher, &QFileSystemWatcher::fileChanged, this, onChanged);
+    connect(m_watcher, &QFileSystemWatcher::directoryChanged, this, onChanged);
+    std::ignore = m_watcher->addPath(QFileInfo(filePath).absolutePath());
+    rewatchConfigurationFile();
+    DEBUG << "Configuration hot reload enabled for" << filePath;
+}
+
+void FramelessConfig::rewatchConfigurationFile()
+{
+    if (!m_watcher) {
+        return;
+    }
+    const QString filePath = configFilePath();
+    if (filePath.isEmpty() || m_watcher->files().contains(filePath) || !QFileInfo::exists(filePath)) {
+        return;
+    }
+    std::ignore = m_watcher->addPath(filePath);
 }
 
 void FramelessConfig::setLoadFromEnvironmentVariablesDisabled(const bool on)
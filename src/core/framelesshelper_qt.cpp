@@ -28,9 +28,18 @@
 #include "framelessconfig_p.h"
 #include "framelesshelpercore_global_p.h"
 #include "utils.h"
+#include "hittest_p.h"
+#include "framelessstatistics_p.h"
+#include "tracing_p.h"
+#include "flightrecorder_p.h"
 #include <QtCore/qloggingcategory.h>
+#include <QtCore/qalgorithms.h>
+#include <QtCore/qelapsedtimer.h>
+#include <QtCore/qtimer.h>
+#include <QtCore/qmath.h>
 #include <QtGui/qevent.h>
 #include <QtGui/qwindow.h>
+#include <QtGui/qscreen.h>
 
 FRAMELESSHELPER_BEGIN_NAMESPACE
 
@@ -55,12 +64,158 @@ struct FramelessQtHelperData
     FramelessHelperQt *eventFilter = nullptr;
     bool cursorShapeChanged = false;
     bool leftButtonPressed = false;
+    QElapsedTimer hoverTimer = {};
+    QPointF pendingHoverPos = {};
+    bool hoverPending = false;
+    int hoverInterval = 0; // ms
+    quint32 hoverIntervalVersion = 0; // The configuration version it was calculated for.
+    QMetaObject::Connection refreshRateConnection = {};
+    ResizeBorderSettings resizeBorderSettings = {};
+    ResizeBorderBands resizeBorder = {};
+    Stats::WindowCountersPtr stats = nullptr;
 };
 
 using FramelessQtHelperInternal = QHash<WId, FramelessQtHelperData>;
 
 Q_GLOBAL_STATIC(FramelessQtHelperInternal, g_framelessQtHelperData)
 
+[[nodiscard]] static inline int hoverCoalesceInterval(const QWindow *window)
+{
+    Q_ASSERT(window);
+    if (!window) {
+        return 0;
+    }
+    static const int userInterval = []() -> int {
+        bool ok = false;
+        const int value = qEnvironmentVariableIntValue(kHoverCoalesceIntervalVar, &ok);
+        return ((ok && (value > 0)) ? value : 0);
+    }();
+    if (userInterval > 0) {
+        return userInterval;
+    }
+    // By default we evaluate hover moves at most once per frame of the screen
+    // the window currently lives on, anything faster can't be seen anyway.
+    const QScreen * const screen = window->screen();
+    const qreal refreshRate = (screen ? screen->refreshRate() : qreal(0));
+    return ((refreshRate > qreal(0)) ? qMax(1, qFloor(qreal(1000) / refreshRate)) : 16);
+}
+
+static inline void updateHoverInterval(const QWindow *window, FramelessQtHelperData &data)
+{
+    Q_ASSERT(window);
+    if (!window) {
+        return;
+    }
+    data.hoverInterval = hoverCoalesceInterval(window);
+    data.hoverIntervalVersion = FramelessConfig::version();
+}
+
+static inline void watchScreenRefreshRate(const WId windowId)
+{
+    Q_ASSERT(windowId);
+    if (!windowId) {
+        return;
+    }
+    const auto it = g_framelessQtHelperData()->find(windowId);
+    if (it == g_framelessQtHelperData()->end()) {
+        return;
+    }
+    FramelessQtHelperData &data = it.value();
+    QWindow * const window = data.params.getWindowHandle();
+    QObject::disconnect(data.refreshRateConnection);
+    data.refreshRateConnection = {};
+    if (const QScreen * const screen = window->screen()) {
+        data.refreshRateConnection = QObject::connect(screen, &QScreen::refreshRateChanged, data.eventFilter, [windowId](){
+            const auto found = g_framelessQtHelperData()->find(windowId);
+            if (found == g_framelessQtHelperData()->end()) {
+                return;
+            }
+            updateHoverInterval(found.value().params.getWindowHandle(), found.value());
+        });
+    }
+    updateHoverInterval(window, data);
+}
+
+static inline void updateResizeBorder(const QWindow *window, FramelessQtHelperData &data)
+{
+    Q_ASSERT(window);
+    if (!window) {
+        return;
+    }
+    data.resizeBorder.update(data.resizeBorderSettings, window->size(), window->devicePixelRatio());
+}
+
+static inline void reloadResizeBorderSettings(FramelessQtHelperData &data)
+{
+    data.resizeBorderSettings = HitTest::readResizeBorderSettings(data.params);
+    updateResizeBorder(data.params.getWindowHandle(), data);
+}
+
+[[nodiscard]] static inline HitTestResult hitTestResizeBorder(const QWindow *window, const FramelessQtHelperData &data, const QPointF &scenePos)
+{
+#ifdef Q_OS_MACOS
+    Q_UNUSED(window);
+    Q_UNUSED(data);
+    Q_UNUSED(scenePos);
+    return HitTestResult::Client;
+#else
+    Q_ASSERT(window);
+    if (!window) {
+        return HitTestResult::Client;
+    }
+    Stats::countHitTest(data.stats);
+    // Same decision as WM_NCHITTEST on Windows. Both callers have ruled out fixed size
+    // windows already, and only the resize border matters here: the title bar is
+    // handled by the mouse events themselves.
+    const QWindow::Visibility visibility = window->visibility();
+    HitTestSnapshot snapshot = {};
+    snapshot.resizeBorder = &data.resizeBorder;
+    snapshot.maximized = (visibility == QWindow::Maximized);
+    snapshot.fullScreen = (visibility == QWindow::FullScreen);
+    return HitTest::evaluate(snapshot, data.resizeBorder.mapToNative(scenePos));
+#endif
+}
+
+static inline void updateCursorShape(QWindow *window, FramelessQtHelperData &data, const QPointF &scenePos)
+{
+    Q_ASSERT(window);
+    if (!window) {
+        return;
+    }
+    if (data.params.isWindowFixedSize() || data.params.getProperty(kDontOverrideCursorVar, false).toBool()) {
+        return;
+    }
+    const Qt::CursorShape cs = HitTest::toCursorShape(hitTestResizeBorder(window, data, scenePos));
+    if (cs == Qt::ArrowCursor) {
+        if (data.cursorShapeChanged) {
+            data.params.unsetCursor();
+            data.cursorShapeChanged = false;
+        }
+    } else {
+        data.params.setCursor(cs);
+        data.cursorShapeChanged = true;
+    }
+}
+
+static inline void flushPendingHover(const WId windowId)
+{
+    Q_ASSERT(windowId);
+    if (!windowId) {
+        return;
+    }
+    const auto it = g_framelessQtHelperData()->find(windowId);
+    if (it == g_framelessQtHelperData()->end()) {
+        return;
+    }
+    FramelessQtHelperData &data = it.value();
+    if (!data.hoverPending) {
+        return;
+    }
+    data.hoverPending = false;
+    data.hoverTimer.start();
+    updateCursorShape(data.params.getWindowHandle(), data, data.pendingHoverPos);
+}
+
 FramelessHelperQt::FramelessHelperQt(QObject *parent) : QObject(parent) {}
 
 FramelessHelperQt::~FramelessHelperQt() = default;
@@ -81,6 +236,8 @@ void FramelessHelperQt::addWindow(FramelessParamsConst params)
     QWindow *window = params->getWindowHandle();
     // Give it a parent so that it can be automatically deleted by Qt.
     data.eventFilter = new FramelessHelperQt(window);
+    data.stats = Stats::windowCounters(windowId);
+    reloadResizeBorderSettings(data);
     g_framelessQtHelperData()->insert(windowId, data);
     const auto shouldApplyFramelessFlag = []() -> bool {
 #ifdef Q_OS_MACOS
@@ -103,7 +260,15 @@ void FramelessHelperQt::addWindow(FramelessParamsConst params)
         Utils::setSystemTitleBarVisible(windowId, false);
 #endif // Q_OS_LINUX
     }
+    // The hover coalescing interval follows the refresh rate of the screen the window
+    // is on, it's calculated once here and only updated when that may have changed.
+    watchScreenRefreshRate(windowId);
+    connect(window, &QWindow::screenChanged, data.eventFilter, [windowId](){ watchScreenRefreshRate(windowId); });
     window->installEventFilter(data.eventFilter);
+    // The resize border settings are dynamic properties of the widget (if any), not of the window.
+    if (QObject * const widget = params->getWidgetHandle(); widget && (widget != window)) {
+        widget->installEventFilter(data.eventFilter);
+    }
     FramelessHelperEnableThemeAware();
 }
 
@@ -117,6 +282,7 @@ void FramelessHelperQt::removeWindow(const WId windowId)
     if (it == g_framelessQtHelperData()->constEnd()) {
         return;
     }
+    QObject::disconnect(it.value().refreshRateConnection);
     g_framelessQtHelperData()->erase(it);
 #ifdef Q_OS_MACOS
     Utils::removeWindowProxy(windowId);
@@ -143,14 +309,28 @@ bool FramelessHelperQt::eventFilter(QObject *object, QEvent *event)
         return QObject::eventFilter(object, event);
     }
 #endif // (QT_VERSION < QT_VERSION_CHECK(6, 5, 0))
+    if (event->type() == QEvent::DynamicPropertyChange) {
+        const auto propertyEvent = static_cast<QDynamicPropertyChangeEvent *>(event);
+        if (HitTest::isResizeBorderProperty(propertyEvent->propertyName())) {
+            // Every window has its own event filter.
+            for (auto it = g_framelessQtHelperData()->begin(); it != g_framelessQtHelperData()->end(); ++it) {
+                if (it.value().eventFilter == this) {
+                    reloadResizeBorderSettings(it.value());
+                    break;
+                }
+            }
+        }
+        return QObject::eventFilter(object, event);
+    }
     // We are only interested in events that are dispatched to top level windows.
     if (!object->isWindowType()) {
         return QObject::eventFilter(object, event);
     }
     const QEvent::Type type = event->type();
-    // We are only interested in some specific mouse events (plus DPR change event).
+    // We are only interested in some specific mouse events (plus geometry and DPR change events).
     if ((type != QEvent::MouseButtonPress) && (type != QEvent::MouseButtonRelease)
             && (type != QEvent::MouseButtonDblClick) && (type != QEvent::MouseMove)
+            && (type != QEvent::Resize) && (type != QEvent::Show)
 #if (QT_VERSION >= QT_VERSION_CHECK(6, 6, 0))
             && (type != QEvent::DevicePixelRatioChange)
 #else // QT_VERSION < QT_VERSION_CHECK(6, 6, 0)
@@ -167,40 +347,73 @@ bool FramelessHelperQt::eventFilter(QObject *object, QEvent *event)
     }
     const FramelessQtHelperData &data = it.value();
     FramelessQtHelperData &muData = it.value();
+    const Stats::ScopedLatency latency(Stats::Latency::EventFilter);
+    Stats::countEvent(data.stats);
 #if (QT_VERSION >= QT_VERSION_CHECK(6, 6, 0))
     if (type == QEvent::DevicePixelRatioChange)
 #else // QT_VERSION < QT_VERSION_CHECK(6, 6, 0)
     if (type == QEvent::ScreenChangeInternal)
 #endif // (QT_VERSION >= QT_VERSION_CHECK(6, 6, 0))
     {
+        const Trace::Span span("FramelessHelperQt::dprChange");
+        updateResizeBorder(window, muData);
         data.params.forceChildrenRepaint(500);
         return QObject::eventFilter(object, event);
     }
+    if ((type == QEvent::Resize) || (type == QEvent::Show)) {
+        updateResizeBorder(window, muData);
+        return QObject::eventFilter(object, event);
+    }
     const auto mouseEvent = static_cast<QMouseEvent *>(event);
     const Qt::MouseButton button = mouseEvent->button();
 #if (QT_VERSION >= QT_VERSION_CHECK(6, 0, 0))
-    const QPoint scenePos = mouseEvent->scenePosition().toPoint();
+    const QPointF scenePosF = mouseEvent->scenePosition();
     const QPoint globalPos = mouseEvent->globalPosition().toPoint();
 #else
-    const QPoint scenePos = mouseEvent->windowPos().toPoint();
+    const QPointF scenePosF = mouseEvent->windowPos();
     const QPoint globalPos = mouseEvent->screenPos().toPoint();
 #endif
+    const QPoint scenePos = scenePosF.toPoint();
+    // Hover-only moves (no button is being held) only affect the cursor shape, so
+    // they can be folded into one evaluation per interval without any visible
+    // difference. Presses, releases and drag detection are never delayed.
+    if ((type == QEvent::MouseMove) && (mouseEvent->buttons() == Qt::NoButton) && !data.leftButtonPressed
+            && FramelessConfig::instance()->isSet(Option::CoalesceHoverMouseMoves)) {
+        muData.pendingHoverPos = scenePosF;
+        if (data.hoverIntervalVersion != FramelessConfig::version()) {
+            updateHoverInterval(window, muData);
+        }
+        const int interval = data.hoverInterval;
+        if (!data.hoverTimer.isValid() || data.hoverTimer.hasExpired(interval)) {
+            muData.hoverPending = false;
+            muData.hoverTimer.start();
+            updateCursorShape(window, muData, scenePosF);
+        } else if (!data.hoverPending) {
+            // Make sure the last position always gets evaluated, otherwise the cursor
+            // may end up with a stale shape once the pointer stops moving.
+            muData.hoverPending = true;
+            const int remaining = qMax(0, interval - int(data.hoverTimer.elapsed()));
+            QTimer::singleShot(remaining, data.eventFilter, [windowId](){ flushPendingHover(windowId); });
+        }
+        return QObject::eventFilter(object, event);
+    }
     const bool windowFixedSize = data.params.isWindowFixedSize();
     const bool ignoreThisEvent = data.params.shouldIgnoreMouseEvents(scenePos);
     const bool insideTitleBar = data.params.isInsideTitleBarDraggableArea(scenePos);
-    const bool dontOverrideCursor = data.params.getProperty(kDontOverrideCursorVar, false).toBool();
     const bool dontToggleMaximize = data.params.getProperty(kDontToggleMaximizeVar, false).toBool();
     switch (type) {
     case QEvent::MouseButtonPress: {
+        muData.hoverPending = false;
+        const HitTestResult hitTestResult = (windowFixedSize ? HitTestResult::Client : hitTestResizeBorder(window, data, scenePosF));
+        FlightRecorder::record(FlightRecorder::Event::HitTestAtPress, windowId,
+            quint32(hitTestResult), quint16(qCountTrailingZeroBits(quint32(button)) + 1));
         if (button == Qt::LeftButton) {
             muData.leftButtonPressed = true;
-            if (!windowFixedSize) {
-                const Qt::Edges edges = Utils::calculateWindowEdges(window, scenePos);
-                if (edges != Qt::Edges{}) {
-                    std::ignore = Utils::startSystemResize(window, edges, globalPos);
-                    event->accept();
-                    return true;
-                }
+            const Qt::Edges edges = HitTest::toWindowEdges(hitTestResult);
+            if (edges != Qt::Edges{}) {
+                std::ignore = Utils::startSystemResize(window, edges, globalPos);
+                event->accept();
+                return true;
             }
         }
     } break;
@@ -228,18 +441,7 @@ bool FramelessHelperQt::eventFilter(QObject *object, QEvent *event)
         }
     } break;
     case QEvent::MouseMove: {
-        if (!dontOverrideCursor && !windowFixedSize) {
-            const Qt::CursorShape cs = Utils::calculateCursorShape(window, scenePos);
-            if (cs == Qt::ArrowCursor) {
-                if (data.cursorShapeChanged) {
-                    data.params.unsetCursor();
-                    muData.cursorShapeChanged = false;
-                }
-            } else {
-                data.params.setCursor(cs);
-                muData.cursorShapeChanged = true;
-            }
-        }
+        updateCursorShape(window, muData, scenePosF);
         if (data.leftButtonPressed) {
             if (!ignoreThisEvent && insideTitleBar) {
                 std::ignore = Utils::startSystemMove(window, globalPos);
@@ -34,12 +34,17 @@
 #include "framelesshelper_windows.h"
 #include "framelesshelpercore_global_p.h"
 #include "scopeguard_p.h"
+#include "hittest_p.h"
+#include "framelessstatistics_p.h"
+#include "tracing_p.h"
+#include "flightrecorder_p.h"
 #include <optional>
 #include <memory>
 #include <QtCore/qhash.h>
 #include <QtCore/qvariant.h>
 #include <QtCore/qcoreapplication.h>
 #include <QtCore/qtimer.h>
+#include <QtCore/qpointer.h>
 #include <QtCore/qloggingcategory.h>
 #include <QtGui/qwindow.h>
 
@@ -100,6 +105,25 @@ enum class WindowPart : quint8
     TitleBar
 };
 
+// The resize border settings are dynamic properties of the window (or its widget),
+// this one reloads them for the hit test whenever they change.
+class ResizeBorderSettingsWatcher : public QObject
+{
+    Q_OBJECT
+    FRAMELESSHELPER_CLASS_INFO
+    Q_DISABLE_COPY_MOVE(ResizeBorderSettingsWatcher)
+
+public:
+    explicit ResizeBorderSettingsWatcher(const WId windowId, QObject *parent = nullptr) : QObject(parent), m_windowId(windowId) {}
+    ~ResizeBorderSettingsWatcher() override = default;
+
+protected:
+    Q_NODISCARD bool eventFilter(QObject *object, QEvent *event) override;
+
+private:
+    WId m_windowId = 0;
+};
+
 struct FramelessWin32HelperData
 {
     SystemParameters params = {};
@@ -112,6 +136,12 @@ struct FramelessWin32HelperData
 #if (QT_VERSION < QT_VERSION_CHECK(6, 5, 1))
     QRect restoreGeometry = {};
 #endif // (QT_VERSION < QT_VERSION_CHECK(6, 5, 1))
+    Stats::WindowCountersPtr stats = nullptr;
+    ResizeBorderSettings resizeBorderSettings = {};
+    ResizeBorderBands resizeBorder = {};
+    // The client area size (in device pixels) the bands were built for, empty if they need to be rebuilt.
+    QSize resizeBorderSize = {};
+    QPointer<ResizeBorderSettingsWatcher> resizeBorderWatcher = nullptr;
 };
 
 struct FramelessWin32HelperInternal
@@ -181,6 +211,93 @@ Q_GLOBAL_STATIC(FramelessWin32HelperInternal, g_framelessWin32HelperData)
     return WindowPart::Outside;
 }
 
+[[nodiscard]] static inline HitTestResult nativeToHitTestResult(const LRESULT hitTestResult)
+{
+    switch (hitTestResult) {
+    case HTCLIENT:
+        return HitTestResult::Client;
+    case HTCAPTION:
+        return HitTestResult::Caption;
+    case HTSYSMENU:
+        return HitTestResult::SystemMenu;
+    case HTHELP:
+        return HitTestResult::Help;
+    case HTREDUCE:
+        return HitTestResult::Minimize;
+    case HTZOOM:
+        return HitTestResult::Maximize;
+    case HTCLOSE:
+        return HitTestResult::Close;
+    case HTTOP:
+        return HitTestResult::Top;
+    case HTBOTTOM:
+        return HitTestResult::Bottom;
+    case HTLEFT:
+        return HitTestResult::Left;
+    case HTRIGHT:
+        return HitTestResult::Right;
+    case HTTOPLEFT:
+        return HitTestResult::TopLeft;
+    case HTTOPRIGHT:
+        return HitTestResult::TopRight;
+    case HTBOTTOMLEFT:
+        return HitTestResult::BottomLeft;
+    case HTBOTTOMRIGHT:
+        return HitTestResult::BottomRight;
+    case HTNOWHERE:
+        return HitTestResult::Nowhere;
+    case HTBORDER:
+        return HitTestResult::Border;
+    default:
+        break;
+    }
+    return HitTestResult::Native;
+}
+
+// The native value is what HitTestResult::Native stands for.
+[[nodiscard]] static inline LRESULT hitTestResultToNative(const HitTestResult result, const LRESULT native = HTCLIENT)
+{
+    switch (result) {
+    case HitTestResult::Client:
+        return HTCLIENT;
+    case HitTestResult::Caption:
+        return HTCAPTION;
+    case HitTestResult::SystemMenu:
+        return HTSYSMENU;
+    case HitTestResult::Help:
+        return HTHELP;
+    case HitTestResult::Minimize:
+        return HTREDUCE;
+    case HitTestResult::Maximize:
+        return HTZOOM;
+    case HitTestResult::Close:
+        return HTCLOSE;
+    case HitTestResult::Border:
+        return HTBORDER;
+    case HitTestResult::Top:
+        return HTTOP;
+    case HitTestResult::Bottom:
+        return HTBOTTOM;
+    case HitTestResult::Left:
+        return HTLEFT;
+    case HitTestResult::Right:
+        return HTRIGHT;
+    case HitTestResult::TopLeft:
+        return HTTOPLEFT;
+    case HitTestResult::TopRight:
+        return HTTOPRIGHT;
+    case HitTestResult::BottomLeft:
+        return HTBOTTOMLEFT;
+    case HitTestResult::BottomRight:
+        return HTBOTTOMRIGHT;
+    case HitTestResult::Nowhere:
+        return HTNOWHERE;
+    case HitTestResult::Native:
+        return native;
+    }
+    return HTCLIENT;
+}
+
 [[nodiscard]] static inline constexpr bool isTaggedMessage(const WPARAM wParam)
 {
     return (wParam == kMessageTag);
@@ -212,6 +329,36 @@ FramelessHelperWin::FramelessHelperWin() : QAbstractNativeEventFilter() {}
 
 FramelessHelperWin::~FramelessHelperWin() = default;
 
+[[nodiscard]] static inline ResizeBorderSettings readResizeBorderSettings(const WId windowId, const SystemParameters &params)
+{
+    // What a native window has when nothing is set: the system's resize border, and
+    // corners twice as wide, to make them easier to grab.
+    ResizeBorderSettings defaults = {};
+    defaults.thickness = int(Utils::getResizeBorderThickness(windowId, true, false));
+    defaults.cornerSize = (defaults.thickness * 2);
+    return HitTest::readResizeBorderSettings(params, defaults);
+}
+
+bool ResizeBorderSettingsWatcher::eventFilter(QObject *object, QEvent *event)
+{
+    Q_ASSERT(object);
+    Q_ASSERT(event);
+    if (!object || !event) {
+        return false;
+    }
+    if (event->type() == QEvent::DynamicPropertyChange) {
+        const auto propertyEvent = static_cast<QDynamicPropertyChangeEvent *>(event);
+        if (HitTest::isResizeBorderProperty(propertyEvent->propertyName())) {
+            const auto it = g_framelessWin32HelperData()->data.find(m_windowId);
+            if (it != g_framelessWin32HelperData()->data.end()) {
+                it.value().resizeBorderSettings = readResizeBorderSettings(m_windowId, it.value().params);
+                it.value().resizeBorderSize = {};
+            }
+        }
+    }
+    return QObject::eventFilter(object, event);
+}
+
 void FramelessHelperWin::addWindow(FramelessParamsConst params)
 {
     Q_ASSERT(params);
@@ -226,6 +373,17 @@ void FramelessHelperWin::addWindow(FramelessParamsConst params)
     FramelessWin32HelperData data = {};
     data.params = *params;
     data.dpi = {Utils::getWindowDpi(windowId, true), Utils::getWindowDpi(windowId, false)};
+    data.stats = Stats::windowCounters(windowId);
+    data.resizeBorderSettings = readResizeBorderSettings(windowId, data.params);
+    {
+        QObject *propertyHolder = params->getWidgetHandle();
+        if (!propertyHolder) {
+            propertyHolder = params->getWindowHandle();
+        }
+        // Deleted together with the window (or widget) it watches.
+        data.resizeBorderWatcher = new ResizeBorderSettingsWatcher(windowId, propertyHolder);
+        propertyHolder->installEventFilter(data.resizeBorderWatcher);
+    }
     g_framelessWin32HelperData()->data.insert(windowId, data);
     if (!g_framelessWin32HelperData()->nativeEventFilter) {
         g_framelessWin32HelperData()->nativeEventFilter = std::make_unique<FramelessHelperWin>();
@@ -291,6 +449,7 @@ void FramelessHelperWin::removeWindow(const WId windowId)
     if (it == g_framelessWin32HelperData()->data.constEnd()) {
         return;
     }
+    delete it.value().resizeBorderWatcher;
     g_framelessWin32HelperData()->data.erase(it);
     if (g_framelessWin32HelperData()->data.isEmpty()) {
         if (g_framelessWin32HelperData()->nativeEventFilter) {
@@ -346,6 +505,8 @@ bool FramelessHelperWin::nativeEventFilter(const QByteArray &eventType, void *me
     }
     const FramelessWin32HelperData &data = it.value();
     FramelessWin32HelperData &muData = it.value();
+    const Stats::ScopedLatency latency(Stats::Latency::EventFilter);
+    Stats::countEvent(data.stats);
     const QWindow *window = data.params.getWindowHandle();
     const bool frameBorderVisible = Utils::isWindowFrameBorderVisible();
     const WPARAM wParam = msg->wParam;
@@ -831,167 +992,50 @@ bool FramelessHelperWin::nativeEventFilter(const QByteArray &eventType, void *me
         const auto clientHeight = RECT_HEIGHT(clientRect);
 
         const QPoint qtScenePos = Utils::fromNativeLocalPosition(window, QPoint(nativeLocalPos.x, nativeLocalPos.y));
-        SystemButtonType sysButtonType = SystemButtonType::Unknown;
-        if (data.params.isInsideSystemButtons(qtScenePos, &sysButtonType)) {
-            // Even if the mouse is inside the chrome button area now, we should still allow the user
-            // to be able to resize the window with the top or right window border, this is also the
-            // normal behavior of a native Win32 window.
-            static constexpr const int kBorderSize = 2;
-            const bool isTop = (nativeLocalPos.y <= kBorderSize);
-            const bool isRight = (nativeLocalPos.x >= (clientWidth - kBorderSize));
-            if (isTop || isRight) {
-                if (isTop && isRight) {
-                    *result = HTTOPRIGHT;
-                } else if (isTop) {
-                    *result = HTTOP;
-                } else {
-                    *result = HTRIGHT;
-                }
-            } else {
-                // OK, we are now really inside one of the chrome buttons, tell Windows the exact role of our button.
-                // The Snap Layout feature introduced in Windows 11 won't work without this.
-                switch (sysButtonType) {
-                case SystemButtonType::WindowIcon:
-                    *result = HTSYSMENU;
-                    break;
-                case SystemButtonType::Help:
-                    *result = HTHELP;
-                    break;
-                case SystemButtonType::Minimize:
-                    *result = HTREDUCE;
-                    break;
-                case SystemButtonType::Maximize:
-                case SystemButtonType::Restore:
-                    *result = HTZOOM;
-                    break;
-                case SystemButtonType::Close:
-                    *result = HTCLOSE;
-                    break;
-                case SystemButtonType::Unknown:
-                    *result = HTCLIENT; // Normally we'd never enter this branch.
-                    break;
-                }
-            }
-            return true;
-        }
-        // OK, we are not inside of any chrome buttons, try to find out which part of the window
-        // are we hitting.
-
-        const bool max = IsMaximized(hWnd);
-        const bool full = Utils::isFullScreen(windowId);
-        const int frameSizeY = Utils::getResizeBorderThickness(windowId, false, true);
-        const bool isTop = (nativeLocalPos.y < frameSizeY);
-        const bool isTitleBar = data.params.isInsideTitleBarDraggableArea(qtScenePos);
-        const bool isFixedSize = data.params.isWindowFixedSize();
-        const bool dontOverrideCursor = data.params.getProperty(kDontOverrideCursorVar, false).toBool();
-        const bool dontToggleMaximize = data.params.getProperty(kDontToggleMaximizeVar, false).toBool();
-
-        if (dontToggleMaximize) {
-            static bool once = false;
-            if (!once) {
-                once = true;
-                DEBUG << "To disable window maximization, you should remove the "
-                         "WS_MAXIMIZEBOX style from the window instead. FramelessHelper "
-                         "won't do that for you, so you'll have to do it manually yourself.";
-            }
-        }
-
-        if (frameBorderVisible) {
-            // This will handle the left, right and bottom parts of the frame
-            // because we didn't change them.
-            const LRESULT originalHitTestResult = ::DefWindowProcW(hWnd, WM_NCHITTEST, 0, lParam);
-            if (originalHitTestResult != HTCLIENT) {
-                *result = ((isFixedSize || dontOverrideCursor) ? HTBORDER : originalHitTestResult);
-                return true;
-            }
-            if (full) {
-                *result = HTCLIENT;
-                return true;
-            }
-            if (max) {
-                *result = (isTitleBar ? HTCAPTION : HTCLIENT);
-                return true;
-            }
-            // At this point, we know that the cursor is inside the client area
-            // so it has to be either the little border at the top of our custom
-            // title bar or the drag bar. Apparently, it must be the drag bar or
-            // the little border at the top which the user can use to move or
-            // resize the window.
-            if (isTop) {
-                // Return HTCLIENT instead of HTBORDER here, because the mouse is
-                // inside our homemade title bar now, return HTCLIENT to let our
-                // title bar can still capture mouse events.
-                *result = ((isFixedSize || dontOverrideCursor) ? HTCLIENT : HTTOP);
-                return true;
-            }
-            if (isTitleBar) {
-                *result = HTCAPTION;
-                return true;
-            }
-            *result = HTCLIENT;
+        Stats::countHitTest(data.stats);
+        HitTestSnapshot snapshot = {};
+        snapshot.size = QSize(clientWidth, clientHeight);
+        LRESULT nativeResult = HTCLIENT;
+        if (data.params.isInsideSystemButtons(qtScenePos, &snapshot.systemButton)) {
+            // The Snap Layout feature introduced in Windows 11 won't work unless we tell
+            // Windows the exact role of our chrome buttons.
+            snapshot.insideSystemButton = true;
+            snapshot.systemButtonResizeBorder = 2;
         } else {
-            if (full) {
-                *result = HTCLIENT;
-                return true;
+            // OK, we are not inside of any chrome buttons, try to find out which part of the window
+            // are we hitting.
+            snapshot.maximized = IsMaximized(hWnd);
+            snapshot.fullScreen = Utils::isFullScreen(windowId);
+            snapshot.insideTitleBar = data.params.isInsideTitleBarDraggableArea(qtScenePos);
+            snapshot.fixedSize = data.params.isWindowFixedSize();
+            snapshot.dontOverrideCursor = data.params.getProperty(kDontOverrideCursorVar, false).toBool();
+            snapshot.frameBorderVisible = frameBorderVisible;
+            // Rebuilt only when the size, the DPI or the settings have changed since the last time.
+            const QSize clientSize = QSize(clientWidth, clientHeight);
+            const qreal dpr = (qreal(data.dpi.x) / qreal(USER_DEFAULT_SCREEN_DPI));
+            if ((clientSize != data.resizeBorderSize) || !qFuzzyCompare(dpr, data.resizeBorder.devicePixelRatio)) {
+                muData.resizeBorder.updateNative(data.resizeBorderSettings, clientSize, dpr);
+                muData.resizeBorderSize = clientSize;
             }
-            if (max) {
-                *result = (isTitleBar ? HTCAPTION : HTCLIENT);
-                return true;
+            snapshot.resizeBorder = &data.resizeBorder;
+            if (frameBorderVisible) {
+                // This will handle the left, right and bottom parts of the frame
+                // because we didn't change them.
+                nativeResult = ::DefWindowProcW(hWnd, WM_NCHITTEST, 0, lParam);
+                snapshot.nativeResult = nativeToHitTestResult(nativeResult);
             }
-            if (!isFixedSize) {
-                const bool isBottom = (nativeLocalPos.y >= (clientHeight - frameSizeY));
-                // Make the border a little wider to let the user easy to resize on corners.
-                const auto scaleFactor = ((isTop || isBottom) ? qreal(2) : qreal(1));
-                const int frameSizeX = Utils::getResizeBorderThickness(windowId, true, true);
-                const int scaledFrameSizeX = std::round(qreal(frameSizeX) * scaleFactor);
-                const bool isLeft = (nativeLocalPos.x < scaledFrameSizeX);
-                const bool isRight = (nativeLocalPos.x >= (clientWidth - scaledFrameSizeX));
-                if (dontOverrideCursor && (isTop || isBottom || isLeft || isRight)) {
-                    // Return HTCLIENT instead of HTBORDER here, because the mouse is
-                    // inside the window now, return HTCLIENT to let the controls
-                    // inside our window can still capture mouse events.
-                    *result = HTCLIENT;
-                    return true;
+            const bool dontToggleMaximize = data.params.getProperty(kDontToggleMaximizeVar, false).toBool();
+            if (dontToggleMaximize) {
+                static bool once = false;
+                if (!once) {
+                    once = true;
+                    DEBUG << "To disable window maximization, you should remove the "
+                             "WS_MAXIMIZEBOX style from the window instead. FramelessHelper "
+                             "won't do that for you, so you'll have to do it manually yourself.";
                 }
-                if (isTop) {
-                    if (isLeft) {
-                        *result = HTTOPLEFT;
-                        return true;
-                    }
-                    if (isRight) {
-                        *result = HTTOPRIGHT;
-                        return true;
-                    }
-                    *result = HTTOP;
-                    return true;
-                }
-                if (isBottom) {
-                    if (isLeft) {
-                        *result = HTBOTTOMLEFT;
-                        return true;
-                    }
-                    if (isRight) {
-                        *result = HTBOTTOMRIGHT;
-                        return true;
-                    }
-                    *result = HTBOTTOM;
-                    return true;
-                }
-                if (isLeft) {
-                    *result = HTLEFT;
-                    return true;
-                }
-                if (isRight) {
-                    *result = HTRIGHT;
-                    return true;
-                }
-            }
-            if (isTitleBar) {
-                *result = HTCAPTION;
-                return true;
             }
-            *result = HTCLIENT;
         }
+        *result = hitTestResultToNative(HitTest::evaluate(snapshot, QPoint(nativeLocalPos.x, nativeLocalPos.y)), nativeResult);
         return true;
     }
     case WM_MOUSEMOVE:
@@ -1020,6 +1064,14 @@ bool FramelessHelperWin::nativeEventFilter(const QByteArray &eventType, void *me
 #endif
     case WM_NCMOUSEHOVER: {
         const WindowPart currentWindowPart = data.lastHitTestResult;
+        if ((uMsg == WM_NCLBUTTONDOWN) || (uMsg == WM_NCRBUTTONDOWN)
+            || (uMsg == WM_NCMBUTTONDOWN) || (uMsg == WM_NCXBUTTONDOWN)) {
+            // Button numbers follow the Qt side: 1 left, 2 right, 3 middle, 4+ extra.
+            const quint16 button = ((uMsg == WM_NCLBUTTONDOWN) ? 1 : ((uMsg == WM_NCRBUTTONDOWN) ? 2
+                : ((uMsg == WM_NCMBUTTONDOWN) ? 3 : quint16(3 + HIWORD(wParam)))));
+            FlightRecorder::record(FlightRecorder::Event::HitTestAtPress, windowId,
+                quint32(nativeToHitTestResult(LOWORD(wParam))), button);
+        }
         if (uMsg == WM_NCMOUSEMOVE) {
             if (currentWindowPart != WindowPart::ChromeButton) {
                 std::ignore = data.params.resetQtGrabbedControl();
@@ -1127,6 +1179,7 @@ bool FramelessHelperWin::nativeEventFilter(const QByteArray &eventType, void *me
     }
 #endif // (QT_VERSION <= QT_VERSION_CHECK(6, 4, 2))
     case WM_DPICHANGED: {
+        const Trace::Span span("FramelessHelperWin::dprChange");
         const Dpi oldDpi = data.dpi;
         const Dpi newDpi = {UINT(LOWORD(wParam)), UINT(HIWORD(wParam))};
         if (Q_UNLIKELY(newDpi == oldDpi)) {
@@ -1319,4 +1372,6 @@ bool FramelessHelperWin::nativeEventFilter(const QByteArray &eventType, void *me
 
 FRAMELESSHELPER_END_NAMESPACE
 
+#include "framelesshelper_win.moc"
+
 #endif // Q_OS_WINDOWS
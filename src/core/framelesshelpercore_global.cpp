@@ -26,6 +26,7 @@
 #include "framelesshelpercore_global_p.h"
 #include "versionnumber_p.h"
 #include "utils.h"
+#include "sysapiloader_p.h"
 #include <QtCore/qiodevice.h>
 #include <QtCore/qcoreapplication.h>
 #include <QtCore/qloggingcategory.h>
@@ -124,13 +125,28 @@ void FramelessHelperCoreInitialize()
 
     FramelessHelperPrintLogo();
 
+    // Resolve the system APIs we are going to need in the background, while the
+    // application is still busy constructing itself.
+    SysApiLoader::prefetch(SysApiLoader::platformManifest());
+
 #if (defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID))
-    // Qt's Wayland experience is not good, so we force the XCB backend here.
-    // TODO: Remove this hack once Qt's Wayland implementation is good enough.
     // We are setting the preferred QPA backend, so we have to set it early
     // enough, that is, before the construction of any Q(Gui)Application
     // instances. QCoreApplication won't instantiate the platform plugin.
-    qputenv("QT_QPA_PLATFORM", "xcb");
+    // An explicit choice of the user always wins. Only the environment can be asked
+    // here: the configuration file is read once the application object exists, and
+    // by then the platform plugin has been chosen already.
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        // Moving and resizing a Wayland window can only be started by the compositor,
+        // which needs QWindow::startSystemMove/Resize(), they were added in Qt 5.15.
+        // Older Qt versions have to go through XWayland and _NET_WM_MOVERESIZE.
+        static constexpr const bool kNativeWaylandSupported = (QT_VERSION >= QT_VERSION_CHECK(5, 15, 0));
+        const bool waylandSession = (!qEnvironmentVariableIsEmpty("WAYLAND_DISPLAY")
+            || (qgetenv("XDG_SESSION_TYPE") == FRAMELESSHELPER_BYTEARRAY_LITERAL("wayland")));
+        if ((qEnvironmentVariableIntValue(kForceXcbBackendVar) != 0) || (waylandSession && !kNativeWaylandSupported)) {
+            qputenv("QT_QPA_PLATFORM", "xcb");
+        }
+    }
     // Fedora and Arch users report segfault when calling XInitThreads() and gtk_init().
     //XInitThreads(); // Users report that GTK is crashing without this.
     //gtk_init(nullptr, nullptr); // Users report that GTK functionalities won't work without this.
@@ -27,6 +27,13 @@
 #include "framelesshelper_qt.h"
 #include "framelessconfig_p.h"
 #include "framelesshelpercore_global_p.h"
+#include "framelessstatistics_p.h"
+#include "flightrecorder_p.h"
+#include "x11capabilities_p.h"
+#include "linuxtheme_p.h"
+#include "linuxwallpaper_p.h"
+#include "settingsportal_p.h"
+#include "tracing_p.h"
 #include "utils.h"
 #ifdef Q_OS_WINDOWS
 #  include "framelesshelper_win.h"
@@ -35,12 +42,19 @@
 #include <QtCore/qvariant.h>
 #include <QtCore/qcoreapplication.h>
 #include <QtCore/qloggingcategory.h>
+#if (defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID))
+#  include <QtCore/qdir.h>
+#  include <QtCore/qfileinfo.h>
+#  include <QtCore/qfilesystemwatcher.h>
+#  include <QtCore/qstandardpaths.h>
+#endif // (defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID))
 #include <QtGui/qfontdatabase.h>
 #include <QtGui/qwindow.h>
+#include <QtGui/qguiapplication.h>
 #if (QT_VERSION >= QT_VERSION_CHECK(6, 5, 0))
-#  include <QtGui/qguiapplication.h>
 #  include <QtGui/qstylehints.h>
 #endif // (QT_VERSION >= QT_VERSION_CHECK(6, 5, 0))
+#include <utility>
 
 FRAMELESSHELPER_BEGIN_NAMESPACE
 
@@ -63,7 +77,7 @@ using FramelessManagerData = QList<WId>;
 
 Q_GLOBAL_STATIC(FramelessManagerData, g_framelessManagerData)
 
-static constexpr const int kEventDelayInterval = 1000;
+static constexpr const int kDefaultDebounceInterval = 250;
 
 #if FRAMELESSHELPER_CONFIG(bundle_resource)
 [[nodiscard]] static inline QString iconFontFamilyName()
@@ -83,16 +97,25 @@ static constexpr const int kEventDelayInterval = 1000;
 }
 #endif
 
+[[nodiscard]] static inline int debounceInterval()
+{
+    static const auto result = []() -> int {
+        bool ok = false;
+        const int value = qEnvironmentVariableIntValue(kSystemChangeDebounceIntervalVar, &ok);
+        return ((ok && (value >= 0)) ? value : kDefaultDebounceInterval);
+    }();
+    return result;
+}
+
 [[nodiscard]] static inline bool usePureQtImplementation()
 {
-    static const auto result = []() -> bool {
 #ifdef Q_OS_WINDOWS
-        return FramelessConfig::instance()->isSet(Option::UseCrossPlatformQtImplementation);
+    // Not cached: the option may change when the configuration is reloaded. The
+    // answer only matters when a window is added, a window never switches later.
+    return FramelessConfig::instance()->isSet(Option::UseCrossPlatformQtImplementation);
 #else
-        return true;
+    return true;
 #endif
-    }();
-    return result;
 }
 
 FramelessManagerPrivate::FramelessManagerPrivate(FramelessManager *q) : QObject(q)
@@ -165,38 +188,72 @@ QFont FramelessManagerPrivate::getIconFont()
 
 void FramelessManagerPrivate::notifySystemThemeHasChangedOrNot()
 {
-    themeTimer.start();
+    debounce(themeDebouncer, &FramelessManagerPrivate::doNotifySystemThemeHasChangedOrNot);
 }
 
 void FramelessManagerPrivate::notifyWallpaperHasChangedOrNot()
 {
-    wallpaperTimer.start();
+    debounce(wallpaperDebouncer, &FramelessManagerPrivate::doNotifyWallpaperHasChangedOrNot);
 }
 
-void FramelessManagerPrivate::doNotifySystemThemeHasChangedOrNot()
+void FramelessManagerPrivate::setupDebouncer(ChangeDebouncer &debouncer, const ChangeHandler handler)
 {
-    const SystemTheme currentSystemTheme = (Utils::shouldAppsUseDarkMode() ? SystemTheme::Dark : SystemTheme::Light);
-    const QColor currentAccentColor = Utils::getAccentColor();
-#ifdef Q_OS_WINDOWS
-    const DwmColorizationArea currentColorizationArea = Utils::getDwmColorizationArea();
-#endif
-    bool notify = false;
-    if (systemTheme != currentSystemTheme) {
-        systemTheme = currentSystemTheme;
-        notify = true;
-    }
-    if (accentColor != currentAccentColor) {
-        accentColor = currentAccentColor;
-        notify = true;
+    debouncer.timer.setSingleShot(true);
+    debouncer.timer.setInterval(debounceInterval());
+    debouncer.timer.callOnTimeout(this, [this, &debouncer, handler](){
+        if (!debouncer.pending) {
+            // Nothing happened during the whole window, we are idle again.
+            debouncer.windowOpen = false;
+            DEBUG << "Debounce window closed, raw notifications:" << debouncer.rawCount
+                  << ", delivered:" << debouncer.deliveredCount << ", folded:" << debouncer.foldedCount();
+            return;
+        }
+        // Trailing edge: deliver the final state of the burst and keep the window
+        // open, so that a continuous stream of changes costs at most one delivery
+        // per window.
+        debouncer.pending = false;
+        ++debouncer.deliveredCount;
+        Stats::increment(Stats::Counter::SystemChangesDelivered);
+        (this->*handler)();
+        debouncer.timer.start();
+    });
+}
+
+void FramelessManagerPrivate::debounce(ChangeDebouncer &debouncer, const ChangeHandler handler)
+{
+    ++debouncer.rawCount;
+    Stats::increment(Stats::Counter::SystemChangesReceived);
+    if (debouncer.windowOpen) {
+        if (debouncer.pending) {
+            // Only the final state of the burst is delivered.
+            Stats::increment(Stats::Counter::SystemChangesFolded);
+        }
+        debouncer.pending = true;
+        return;
     }
-#ifdef Q_OS_WINDOWS
-    if (colorizationArea != currentColorizationArea) {
-        colorizationArea = currentColorizationArea;
-        notify = true;
+    // Leading edge: react to the first change right away. It's still queued because
+    // we may be called from inside a native event handler.
+    debouncer.windowOpen = true;
+    QTimer::singleShot(0, this, [this, &debouncer, handler](){
+        ++debouncer.deliveredCount;
+        Stats::increment(Stats::Counter::SystemChangesDelivered);
+        (this->*handler)();
+        debouncer.timer.start();
+    });
+}
+
+void FramelessManagerPrivate::doNotifySystemThemeHasChangedOrNot()
+{
+    const Trace::Span span("FramelessManager::themeRefresh");
+    // A full probe is about to run anyway, the pending startup one (if any) is stale now.
+    const bool queried = std::exchange(systemStateReady, true);
+    // Nobody has asked for the previous state, so there's nobody to notify either.
+    if (!applySystemState(probeSystemState()) || !queried) {
+        return;
     }
-#endif
+    FlightRecorder::record(FlightRecorder::Event::ThemeChanged, 0, accentColor.rgba(), quint16(systemTheme));
     // Don't emit the signal if the user has overrided the global theme.
-    if (notify && !isThemeOverrided()) {
+    if (!isThemeOverrided()) {
         Q_Q(FramelessManager);
         Q_EMIT q->systemThemeChanged();
         DEBUG.nospace() << "System theme changed. Current theme: " << systemTheme
@@ -210,6 +267,12 @@ void FramelessManagerPrivate::doNotifySystemThemeHasChangedOrNot()
 
 void FramelessManagerPrivate::doNotifyWallpaperHasChangedOrNot()
 {
+    const Trace::Span span("FramelessManager::wallpaperRefresh");
+    if (!wallpaperReady) {
+        // Nobody has asked for the wallpaper yet, so there's nobody to notify either.
+        ensureWallpaper();
+        return;
+    }
     const QString currentWallpaper = Utils::getWallpaperFilePath();
     const WallpaperAspectStyle currentWallpaperAspectStyle = Utils::getWallpaperAspectStyle();
     bool notify = false;
@@ -222,6 +285,7 @@ void FramelessManagerPrivate::doNotifyWallpaperHasChangedOrNot()
         notify = true;
     }
     if (notify) {
+        FlightRecorder::record(FlightRecorder::Event::WallpaperChanged, 0, quint32(wallpaperAspectStyle));
         Q_Q(FramelessManager);
         Q_EMIT q->wallpaperChanged();
         DEBUG.nospace() << "Wallpaper changed. Current wallpaper: " << wallpaper
@@ -229,38 +293,306 @@ void FramelessManagerPrivate::doNotifyWallpaperHasChangedOrNot()
     }
 }
 
-bool FramelessManagerPrivate::isThemeOverrided() const
+SystemState FramelessManagerPrivate::probeSystemState()
 {
-    return (overrideTheme.value_or(SystemTheme::Unknown) != SystemTheme::Unknown);
+    SystemState state = {};
+    state.theme = (Utils::shouldAppsUseDarkMode() ? SystemTheme::Dark : SystemTheme::Light);
+    state.accentColor = Utils::getAccentColor();
+#ifdef Q_OS_WINDOWS
+    state.colorizationArea = Utils::getDwmColorizationArea();
+#endif
+    return state;
 }
 
-void FramelessManagerPrivate::initialize()
+void FramelessManagerPrivate::startSystemStateProbe()
 {
-    themeTimer.setInterval(kEventDelayInterval);
-    themeTimer.callOnTimeout(this, [this](){
-        themeTimer.stop();
-        doNotifySystemThemeHasChangedOrNot();
-    });
-    wallpaperTimer.setInterval(kEventDelayInterval);
-    wallpaperTimer.callOnTimeout(this, [this](){
-        wallpaperTimer.stop();
-        doNotifyWallpaperHasChangedOrNot();
-    });
-    systemTheme = (Utils::shouldAppsUseDarkMode() ? SystemTheme::Dark : SystemTheme::Light);
-    accentColor = Utils::getAccentColor();
 #ifdef Q_OS_WINDOWS
-    colorizationArea = Utils::getDwmColorizationArea();
-#endif
-    wallpaper = Utils::getWallpaperFilePath();
-    wallpaperAspectStyle = Utils::getWallpaperAspectStyle();
+    // The registry and DWM can be queried from any thread, so let's do it in the
+    // background while the application is busy creating its first window. Nothing
+    // else is allowed there: the rest of the probe needs the platform plugin and
+    // has to run on the GUI thread.
+    systemStateProbe = std::async(std::launch::async, [this]() -> SystemState {
+        const SystemState state = probeSystemStateInBackground();
+        QMetaObject::invokeMethod(this, [this](){ ensureSystemState(); }, Qt::QueuedConnection);
+        return state;
+    }).share();
+#else // !Q_OS_WINDOWS
+    // The platform APIs we use here are not thread safe, so there's nothing to start
+    // early: the probe runs on the first query instead, see ensureSystemState().
+    // Applications that never ask for the theme or the accent color don't pay for it.
+#endif // Q_OS_WINDOWS
+}
+
+#ifdef Q_OS_WINDOWS
+SystemState FramelessManagerPrivate::probeSystemStateInBackground()
+{
+    // Only the registry and DWM reads, the theme is left for the GUI thread.
+    SystemState state = {};
+#if (QT_VERSION < QT_VERSION_CHECK(6, 6, 0))
+    state.accentColor = Utils::getAccentColor_windows();
+#endif // (QT_VERSION < QT_VERSION_CHECK(6, 6, 0))
+    state.colorizationArea = Utils::getDwmColorizationArea();
+    return state;
+}
+#endif // Q_OS_WINDOWS
+
+void FramelessManagerPrivate::ensureSystemState()
+{
+    if (systemStateReady) {
+        return;
+    }
+    systemStateReady = true;
+    // Every reader comes through here first, so there are no placeholder values
+    // anyone could have seen and nobody to notify.
+#ifdef Q_OS_WINDOWS
+    // Usually finished long ago, only the first query of a very early caller waits.
+    SystemState state = systemStateProbe.get();
+    state.theme = (Utils::shouldAppsUseDarkMode() ? SystemTheme::Dark : SystemTheme::Light);
+#  if (QT_VERSION >= QT_VERSION_CHECK(6, 6, 0))
+    state.accentColor = Utils::getAccentColor();
+#  endif // (QT_VERSION >= QT_VERSION_CHECK(6, 6, 0))
+#else // !Q_OS_WINDOWS
+    const SystemState state = probeSystemState();
+#endif // Q_OS_WINDOWS
+    std::ignore = applySystemState(state);
     DEBUG.nospace() << "Current system theme: " << systemTheme
                     << ", accent color: " << accentColor.name(QColor::HexArgb).toUpper()
 #ifdef Q_OS_WINDOWS
                     << ", colorization area: " << colorizationArea
 #endif
-                    << ", wallpaper: " << wallpaper
-                    << ", aspect style: " << wallpaperAspectStyle
                     << '.';
+}
+
+void FramelessManagerPrivate::ensureWallpaper()
+{
+    if (wallpaperReady) {
+        return;
+    }
+    wallpaperReady = true;
+    // Only the mica material needs the wallpaper, there's no need to query it at startup.
+    wallpaper = Utils::getWallpaperFilePath();
+    wallpaperAspectStyle = Utils::getWallpaperAspectStyle();
+    DEBUG.nospace() << "Current wallpaper: " << wallpaper
+                    << ", aspect style: " << wallpaperAspectStyle << '.';
+}
+
+#if (defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID))
+void FramelessManagerPrivate::watchWallpaper()
+{
+    if (wallpaperWatcher) {
+        return;
+    }
+    // The mica material reads the wallpaper by itself, so we need something to
+    // compare with before the first change arrives.
+    ensureWallpaper();
+    wallpaperWatcher = new QFileSystemWatcher(this);
+    // Desktops save their settings in bursts (and some rewrite several files),
+    // the wallpaper debouncer folds all these events into one refresh.
+    const auto onChanged = [this](){
+        rewatchWallpaper();
+        notifyWallpaperHasChangedOrNot();
+    };
+    connect(wallpaperWatcher, &QFileSystemWatcher::fileChanged, this, onChanged);
+    connect(wallpaperWatcher, &QFileSystemWatcher::directoryChanged, this, onChanged);
+    rewatchWallpaper();
+}
+
+void FramelessManagerPrivate::rewatchWallpaper()
+{
+    QStringList files = {};
+    const QList<LinuxWallpaper::Source> sources = LinuxWallpaper::currentSources();
+    for (auto &&source : std::as_const(sources)) {
+        files.append(LinuxWallpaper::configFiles(source));
+    }
+    rewatchFiles(wallpaperWatcher, files);
+}
+
+void FramelessManagerPrivate::watchTheme()
+{
+    if (themeWatcher) {
+        return;
+    }
+    themeWatcher = new QFileSystemWatcher(this);
+    const auto onChanged = [this](){
+        rewatchFiles(themeWatcher, LinuxTheme::configFiles());
+        notifySystemThemeHasChangedOrNot();
+    };
+    connect(themeWatcher, &QFileSystemWatcher::fileChanged, this, onChanged);
+    connect(themeWatcher, &QFileSystemWatcher::directoryChanged, this, onChanged);
+    rewatchFiles(themeWatcher, LinuxTheme::configFiles());
+    if (SettingsPortal::isSupported()) {
+        settingsPortal = new SettingsPortal(this);
+        connect(settingsPortal, &SettingsPortal::updated, this, &FramelessManagerPrivate::notifySystemThemeHasChangedOrNot);
+        settingsPortal->start();
+    }
+}
+
+void FramelessManagerPrivate::rewatchFiles(QFileSystemWatcher *watcher, const QStringList &files)
+{
+    Q_ASSERT(watcher);
+    if (!watcher) {
+        return;
+    }
+    // Files replaced by a rename (which is how most settings get saved) drop out
+    // of the watch list, and files that don't exist yet can't be watched at all.
+    // Watch those through their directories until they (re)appear, except for the
+    // home directory and ~/.config: they change all the time for unrelated reasons,
+    // a file missing from there is only noticed once something else changes.
+    const QStringList busyDirs = {
+        QDir::cleanPath(QDir::homePath()),
+        QDir::cleanPath(QStandardPaths::writableLocation(QStandardPaths::GenericConfigLocation))
+    };
+    QStringList wanted = {};
+    for (auto &&file : std::as_const(files)) {
+        const QFileInfo info(file);
+        const QString path = (info.exists() ? info.absoluteFilePath() : info.absolutePath());
+        if (!info.exists() && busyDirs.contains(QDir::cleanPath(path))) {
+            continue;
+        }
+        if (QFileInfo::exists(path) && !wanted.contains(path)) {
+            wanted.append(path);
+        }
+    }
+    QStringList unwanted = (watcher->files() + watcher->directories());
+    for (auto &&path : std::as_const(wanted)) {
+        unwanted.removeAll(path);
+    }
+    if (!unwanted.isEmpty()) {
+        std::ignore = watcher->removePaths(unwanted);
+    }
+    QStringList missing = {};
+    for (auto &&path : std::as_const(wanted)) {
+        if (!watcher->files().contains(path) && !watcher->directories().contains(path)) {
+            missing.append(path);
+        }
+    }
+    if (!missing.isEmpty()) {
+        std::ignore = watcher->addPaths(missing);
+    }
+}
+#endif // (defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID))
+
+bool FramelessManagerPrivate::applySystemState(const SystemState &state)
+{
+    bool changed = false;
+    if (systemTheme != state.theme) {
+        systemTheme = state.theme;
+        changed = true;
+    }
+    if (accentColor != state.accentColor) {
+        accentColor = state.accentColor;
+        changed = true;
+    }
+#ifdef Q_OS_WINDOWS
+    if (colorizationArea != state.colorizationArea) {
+        colorizationArea = state.colorizationArea;
+        changed = true;
+    }
+#endif
+    if (changed) {
+        invalidateThemeSnapshot();
+    }
+    return changed;
+}
+
+bool FramelessManagerPrivate::isThemeOverrided() const
+{
+    return (overrideTheme.value_or(SystemTheme::Unknown) != SystemTheme::Unknown);
+}
+
+ThemeSnapshotPtr FramelessManagerPrivate::themeSnapshot() const
+{
+    // Created lazily, because some of the values below need to access
+    // the FramelessManager instance, which may not be ready yet.
+    if (cachedThemeSnapshot) {
+        return cachedThemeSnapshot;
+    }
+    const_cast<FramelessManagerPrivate *>(this)->ensureSystemState();
+    Q_Q(const FramelessManager);
+    const auto snapshot = std::make_shared<ThemeSnapshot>();
+    snapshot->version = ++themeSnapshotVersion;
+    snapshot->theme = q->systemTheme();
+    snapshot->dark = (snapshot->theme == SystemTheme::Dark);
+    snapshot->accentColor = accentColor;
+    snapshot->titleBarColorized = Utils::isTitleBarColorized();
+#ifdef Q_OS_WINDOWS
+    snapshot->colorizationArea = colorizationArea;
+#endif
+    snapshot->frameBorderActiveColor = Utils::getFrameBorderColor(true);
+    snapshot->frameBorderInactiveColor = Utils::getFrameBorderColor(false);
+    const bool dark = snapshot->dark;
+    const bool colorized = snapshot->titleBarColorized;
+    snapshot->titleBarActiveBackgroundColor = (colorized ? accentColor : (dark ? kDefaultBlackColor : kDefaultWhiteColor));
+    snapshot->titleBarInactiveBackgroundColor = (dark ? kDefaultSystemDarkColor : kDefaultWhiteColor);
+    snapshot->titleBarActiveForegroundColor = [&snapshot, dark, colorized]() -> QColor {
+        if (dark || colorized) {
+            // Calculate the most appropriate foreground color, based on the
+            // current background color.
+            const QColor &background = snapshot->titleBarActiveBackgroundColor;
+            const qreal grayF = (
+                (qreal(0.299) * background.redF()) +
+                (qreal(0.587) * background.greenF()) +
+                (qreal(0.114) * background.blueF()));
+            static constexpr const auto kFlag = qreal(0.5);
+            if ((grayF < kFlag) || qFuzzyCompare(grayF, kFlag)) {
+                return kDefaultWhiteColor;
+            }
+        }
+        return kDefaultBlackColor;
+    }();
+    snapshot->titleBarInactiveForegroundColor = kDefaultDarkGrayColor;
+    for (int button = 0; button <= static_cast<int>(SystemButtonType::Last); ++button) {
+        for (int state = 0; state != ThemeSnapshot::kButtonStateCount; ++state) {
+            const auto buttonState = static_cast<ButtonState>(state);
+            const bool isClose = (static_cast<SystemButtonType>(button) == SystemButtonType::Close);
+            const bool isHovered = (buttonState == ButtonState::Hovered);
+            QColor color = kDefaultTransparentColor;
+            if (buttonState != ButtonState::Normal) {
+                if (isClose) {
+                    color = (isHovered ? kDefaultSystemCloseButtonBackgroundColor.lighter(110) : kDefaultSystemCloseButtonBackgroundColor.lighter(140));
+                } else if (colorized) {
+                    color = (isHovered ? accentColor.lighter(150) : accentColor.lighter(120));
+                } else {
+                    color = (isHovered ? kDefaultSystemButtonBackgroundColor.lighter(110) : kDefaultSystemButtonBackgroundColor);
+                }
+            }
+            snapshot->systemButtonBackgroundColors.at((button * ThemeSnapshot::kButtonStateCount) + state) = color;
+        }
+    }
+    cachedThemeSnapshot = snapshot;
+    return cachedThemeSnapshot;
+}
+
+ThemeSnapshotPtr FramelessManagerPrivate::currentThemeSnapshot()
+{
+    return get(FramelessManager::instance())->themeSnapshot();
+}
+
+void FramelessManagerPrivate::invalidateThemeSnapshot()
+{
+    // Anyone still holding the old snapshot keeps a valid (but outdated) copy.
+    cachedThemeSnapshot = nullptr;
+}
+
+void FramelessManagerPrivate::initialize()
+{
+    setupDebouncer(themeDebouncer, &FramelessManagerPrivate::doNotifySystemThemeHasChangedOrNot);
+    setupDebouncer(wallpaperDebouncer, &FramelessManagerPrivate::doNotifyWallpaperHasChangedOrNot);
+    // Probing the system state can be slow, don't let it delay the first frame.
+    // It's done in the background on Windows, and on the first query elsewhere.
+    startSystemStateProbe();
+#if (defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID))
+    // Ask the X server everything we'll need in a few pipelined round trips now,
+    // instead of one blocking round trip per atom or property later on, and keep
+    // the answers fresh when the window manager gets restarted or replaced.
+    X11::watchCapabilities();
+    // Watching the wallpaper and theme settings means reading a few files, keep it
+    // out of the way of the first frame as well.
+    QTimer::singleShot(0, this, [this](){
+        watchWallpaper();
+        watchTheme();
+    });
+#endif // (defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID))
     // We are doing some tricks in our Windows message handling code, so
     // we don't use Qt's theme notifier on Windows. But for other platforms
     // we want to use as many Qt functionalities as possible.
@@ -306,27 +638,36 @@ SystemTheme FramelessManager::systemTheme() const
     if (d->isThemeOverrided()) {
         return d->overrideTheme.value();
     }
+    const_cast<FramelessManagerPrivate *>(d)->ensureSystemState();
     return d->systemTheme;
 }
 
 QColor FramelessManager::systemAccentColor() const
 {
     Q_D(const FramelessManager);
+    const_cast<FramelessManagerPrivate *>(d)->ensureSystemState();
     return d->accentColor;
 }
 
 QString FramelessManager::wallpaper() const
 {
     Q_D(const FramelessManager);
+    const_cast<FramelessManagerPrivate *>(d)->ensureWallpaper();
     return d->wallpaper;
 }
 
 WallpaperAspectStyle FramelessManager::wallpaperAspectStyle() const
 {
     Q_D(const FramelessManager);
+    const_cast<FramelessManagerPrivate *>(d)->ensureWallpaper();
     return d->wallpaperAspectStyle;
 }
 
+Statistics FramelessManager::statistics()
+{
+    return Stats::snapshot();
+}
+
 void FramelessManager::setOverrideTheme(const SystemTheme theme)
 {
     Q_D(FramelessManager);
@@ -339,11 +680,13 @@ void FramelessManager::setOverrideTheme(const SystemTheme theme)
     } else {
         d->overrideTheme = theme;
     }
+    d->invalidateThemeSnapshot();
     Q_EMIT systemThemeChanged();
 }
 
 void FramelessManager::addWindow(FramelessParamsConst params)
 {
+    const Trace::Span span("FramelessManager::addWindow");
     Q_ASSERT(params);
     if (!params) {
         return;
@@ -353,7 +696,8 @@ void FramelessManager::addWindow(FramelessParamsConst params)
         return;
     }
     g_framelessManagerData()->append(windowId);
-    static const bool pureQt = usePureQtImplementation();
+    FlightRecorder::record(FlightRecorder::Event::WindowAdded, windowId);
+    const bool pureQt = usePureQtImplementation();
     if (pureQt) {
         FramelessHelperQt::addWindow(params);
     }
@@ -364,10 +708,14 @@ void FramelessManager::addWindow(FramelessParamsConst params)
     std::ignore = Utils::installWindowProcHook(windowId, params);
 #endif
     connect(params->getWindowHandle(), &QWindow::destroyed, FramelessManager::instance(), [this, windowId](){ removeWindow(windowId); });
+    connect(params->getWindowHandle(), &QWindow::windowStateChanged, FramelessManager::instance(), [windowId](const Qt::WindowState state){
+        FlightRecorder::record(FlightRecorder::Event::WindowStateChanged, windowId, quint32(state));
+    });
 }
 
 void FramelessManager::removeWindow(const WId windowId)
 {
+    const Trace::Span span("FramelessManager::removeWindow");
     Q_ASSERT(windowId);
     if (!windowId) {
         return;
@@ -376,14 +724,13 @@ void FramelessManager::removeWindow(const WId windowId)
         return;
     }
     g_framelessManagerData()->removeAll(windowId);
-    static const bool pureQt = usePureQtImplementation();
-    if (pureQt) {
-        FramelessHelperQt::removeWindow(windowId);
-    }
+    FlightRecorder::record(FlightRecorder::Event::WindowRemoved, windowId);
+    Stats::removeWindow(windowId);
+    // The configuration may have been reloaded since this window was added, so don't
+    // guess which implementation owns it: both simply ignore windows they don't know.
+    FramelessHelperQt::removeWindow(windowId);
 #ifdef Q_OS_WINDOWS
-    if (!pureQt) {
-        FramelessHelperWin::removeWindow(windowId);
-    }
+    FramelessHelperWin::removeWindow(windowId);
     std::ignore = Utils::uninstallWindowProcHook(windowId);
     std::ignore = Utils::removeMicaWindow(windowId);
 #endif
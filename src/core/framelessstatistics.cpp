@@ -0,0 +1,183 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021-2023 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "framelessstatistics_p.h"
+#include <QtCore/qhash.h>
+#include <QtCore/qmutex.h>
+#include <QtCore/qalgorithms.h>
+#include <QtCore/qloggingcategory.h>
+#include <array>
+
+FRAMELESSHELPER_BEGIN_NAMESPACE
+
+#if FRAMELESSHELPER_CONFIG(debug_output)
+[[maybe_unused]] static Q_LOGGING_CATEGORY(lcFramelessStatistics, "wangwenx190.framelesshelper.core.framelessstatistics")
+#  define INFO qCInfo(lcFramelessStatistics)
+#  define DEBUG qCDebug(lcFramelessStatistics)
+#  define WARNING qCWarning(lcFramelessStatistics)
+#  define CRITICAL qCCritical(lcFramelessStatistics)
+#else
+#  define INFO QT_NO_QDEBUG_MACRO()
+#  define DEBUG QT_NO_QDEBUG_MACRO()
+#  define WARNING QT_NO_QDEBUG_MACRO()
+#  define CRITICAL QT_NO_QDEBUG_MACRO()
+#endif
+
+using namespace Global;
+
+static constexpr const auto kRelaxed = std::memory_order_relaxed;
+static constexpr const int kCounterCount = static_cast<int>(Stats::Counter::Last) + 1;
+static constexpr const int kLatencyCount = static_cast<int>(Stats::Latency::Last) + 1;
+
+struct AtomicHistogram
+{
+    std::atomic<quint64> count{ 0 };
+    std::atomic<quint64> totalNanoseconds{ 0 };
+    std::atomic<quint64> maximumNanoseconds{ 0 };
+    std::array<std::atomic<quint64>, LatencyHistogram::kBucketCount> buckets{};
+};
+
+struct StatisticsData
+{
+    std::array<std::atomic<quint64>, kCounterCount> counters{};
+    std::array<AtomicHistogram, kLatencyCount> latencies{};
+    // Only touched when a window is added or removed, and when taking a snapshot.
+    QMutex mutex{};
+    QHash<WId, Stats::WindowCountersPtr> windows = {};
+};
+
+Q_GLOBAL_STATIC(StatisticsData, g_statisticsData)
+
+[[nodiscard]] static inline int bucketIndex(const quint64 nanoseconds) noexcept
+{
+    const quint64 microseconds = (nanoseconds / 1000);
+    if (microseconds == 0) {
+        return 0;
+    }
+    const int log2 = (63 - int(qCountLeadingZeroBits(microseconds)));
+    return qMin(log2, LatencyHistogram::kBucketCount - 1);
+}
+
+[[nodiscard]] static inline LatencyHistogram loadHistogram(const AtomicHistogram &histogram)
+{
+    LatencyHistogram result = {};
+    result.count = histogram.count.load(kRelaxed);
+    result.totalNanoseconds = histogram.totalNanoseconds.load(kRelaxed);
+    result.maximumNanoseconds = histogram.maximumNanoseconds.load(kRelaxed);
+    for (int i = 0; i != LatencyHistogram::kBucketCount; ++i) {
+        result.buckets[i] = histogram.buckets.at(i).load(kRelaxed);
+    }
+    return result;
+}
+
+void Stats::increment(const Counter counter, const quint64 value) noexcept
+{
+    if (g_statisticsData.isDestroyed()) {
+        return;
+    }
+    g_statisticsData()->counters.at(static_cast<int>(counter)).fetch_add(value, kRelaxed);
+}
+
+void Stats::record(const Latency latency, const quint64 nanoseconds) noexcept
+{
+    if (g_statisticsData.isDestroyed()) {
+        return;
+    }
+    AtomicHistogram &histogram = g_statisticsData()->latencies.at(static_cast<int>(latency));
+    histogram.count.fetch_add(1, kRelaxed);
+    histogram.totalNanoseconds.fetch_add(nanoseconds, kRelaxed);
+    histogram.buckets.at(bucketIndex(nanoseconds)).fetch_add(1, kRelaxed);
+    quint64 maximum = histogram.maximumNanoseconds.load(kRelaxed);
+    while ((nanoseconds > maximum) && !histogram.maximumNanoseconds.compare_exchange_weak(maximum, nanoseconds, kRelaxed)) {}
+}
+
+Stats::WindowCountersPtr Stats::windowCounters(const WId windowId)
+{
+    Q_ASSERT(windowId);
+    if (!windowId || g_statisticsData.isDestroyed()) {
+        return nullptr;
+    }
+    const QMutexLocker locker(&g_statisticsData()->mutex);
+    WindowCountersPtr &counters = g_statisticsData()->windows[windowId];
+    if (!counters) {
+        counters = std::make_shared<WindowCounters>();
+    }
+    return counters;
+}
+
+void Stats::removeWindow(const WId windowId)
+{
+    Q_ASSERT(windowId);
+    if (!windowId || g_statisticsData.isDestroyed()) {
+        return;
+    }
+    const QMutexLocker locker(&g_statisticsData()->mutex);
+    g_statisticsData()->windows.remove(windowId);
+}
+
+Statistics Stats::snapshot()
+{
+    Statistics result = {};
+    if (g_statisticsData.isDestroyed()) {
+        return result;
+    }
+    const StatisticsData * const data = g_statisticsData();
+    const auto counter = [data](const Counter c) -> quint64 {
+        return data->counters.at(static_cast<int>(c)).load(kRelaxed);
+    };
+    const auto latency = [data](const Latency l) -> LatencyHistogram {
+        return loadHistogram(data->latencies.at(static_cast<int>(l)));
+    };
+    result.eventsFiltered = counter(Counter::EventsFiltered);
+    result.hitTests = counter(Counter::HitTests);
+    result.paletteRepaints = counter(Counter::PaletteRepaints);
+    result.micaRepaints = counter(Counter::MicaRepaints);
+    result.borderRepaints = counter(Counter::BorderRepaints);
+    result.sysApiResolutions = counter(Counter::SysApiResolutions);
+    result.sysApiCacheHits = counter(Counter::SysApiCacheHits);
+    result.x11RoundTrips = counter(Counter::X11RoundTrips);
+    result.x11Flushes = counter(Counter::X11Flushes);
+    result.x11RequestsMerged = counter(Counter::X11RequestsMerged);
+    result.systemChangesReceived = counter(Counter::SystemChangesReceived);
+    result.systemChangesDelivered = counter(Counter::SystemChangesDelivered);
+    result.systemChangesFolded = counter(Counter::SystemChangesFolded);
+    result.eventFilterTime = latency(Latency::EventFilter);
+    result.wallpaperLoadTime = latency(Latency::WallpaperLoad);
+    result.wallpaperScaleTime = latency(Latency::WallpaperScale);
+    result.wallpaperBlurTime = latency(Latency::WallpaperBlur);
+    result.sysApiResolveTime = latency(Latency::SysApiResolve);
+    result.sysApiPrefetchTime = latency(Latency::SysApiPrefetch);
+    const QMutexLocker locker(&g_statisticsData()->mutex);
+    result.windows.reserve(data->windows.size());
+    for (auto it = data->windows.cbegin(); it != data->windows.cend(); ++it) {
+        WindowStatistics window = {};
+        window.windowId = it.key();
+        window.eventsFiltered = it.value()->eventsFiltered.load(kRelaxed);
+        window.hitTests = it.value()->hitTests.load(kRelaxed);
+        result.windows.append(window);
+    }
+    return result;
+}
+
+FRAMELESSHELPER_END_NAMESPACE
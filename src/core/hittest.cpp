@@ -0,0 +1,312 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021-2023 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "hittest_p.h"
+#include "framelesshelpercore_global_p.h"
+#include <QtCore/qloggingcategory.h>
+#include <QtCore/qmath.h>
+
+FRAMELESSHELPER_BEGIN_NAMESPACE
+
+#if FRAMELESSHELPER_CONFIG(debug_output)
+[[maybe_unused]] static Q_LOGGING_CATEGORY(lcHitTest, "wangwenx190.framelesshelper.core.hittest")
+#  define INFO qCInfo(lcHitTest)
+#  define DEBUG qCDebug(lcHitTest)
+#  define WARNING qCWarning(lcHitTest)
+#  define CRITICAL qCCritical(lcHitTest)
+#else
+#  define INFO QT_NO_QDEBUG_MACRO()
+#  define DEBUG QT_NO_QDEBUG_MACRO()
+#  define WARNING QT_NO_QDEBUG_MACRO()
+#  define CRITICAL QT_NO_QDEBUG_MACRO()
+#endif
+
+using namespace Global;
+
+[[nodiscard]] static inline HitTestResult systemButtonToHitTestResult(const SystemButtonType button) noexcept
+{
+    switch (button) {
+    case SystemButtonType::WindowIcon:
+        return HitTestResult::SystemMenu;
+    case SystemButtonType::Help:
+        return HitTestResult::Help;
+    case SystemButtonType::Minimize:
+        return HitTestResult::Minimize;
+    case SystemButtonType::Maximize:
+    case SystemButtonType::Restore:
+        return HitTestResult::Maximize;
+    case SystemButtonType::Close:
+        return HitTestResult::Close;
+    case SystemButtonType::Unknown:
+        break;
+    }
+    return HitTestResult::Client; // Normally we'd never reach here.
+}
+
+[[nodiscard]] static inline HitTestResult edgesToHitTestResult(const Qt::Edges edges) noexcept
+{
+    const bool top = edges.testFlag(Qt::TopEdge);
+    const bool bottom = edges.testFlag(Qt::BottomEdge);
+    const bool left = edges.testFlag(Qt::LeftEdge);
+    const bool right = edges.testFlag(Qt::RightEdge);
+    if (top) {
+        return (left ? HitTestResult::TopLeft : (right ? HitTestResult::TopRight : HitTestResult::Top));
+    }
+    if (bottom) {
+        return (left ? HitTestResult::BottomLeft : (right ? HitTestResult::BottomRight : HitTestResult::Bottom));
+    }
+    if (left) {
+        return HitTestResult::Left;
+    }
+    if (right) {
+        return HitTestResult::Right;
+    }
+    return HitTestResult::Client;
+}
+
+[[nodiscard]] static inline std::array<int, 4> calculateBands(const int length, const ResizeBorderSettings &settings, const qreal dpr) noexcept
+{
+    const int half = (length / 2);
+    int thickness = qMax(0, qRound(qreal(settings.thickness) * dpr));
+    const int corner = qMin(qMax(thickness, qRound(qreal(settings.cornerSize) * dpr)), half);
+    thickness = qMin(thickness, corner);
+    // Must be kept in ascending order, see bandIndex().
+    return { thickness, corner, (length - corner), (length - thickness) };
+}
+
+[[nodiscard]] static inline int bandIndex(const std::array<int, 4> &bands, const int value) noexcept
+{
+    return (int(value >= bands[0]) + int(value >= bands[1]) + int(value >= bands[2]) + int(value >= bands[3]));
+}
+
+void ResizeBorderBands::update(const ResizeBorderSettings &settings, const QSize &logicalSize, const qreal dpr) noexcept
+{
+    const qreal ratio = ((dpr > qreal(0)) ? dpr : qreal(1));
+    updateNative(settings, QSize(qRound(qreal(logicalSize.width()) * ratio), qRound(qreal(logicalSize.height()) * ratio)), ratio);
+}
+
+void ResizeBorderBands::updateNative(const ResizeBorderSettings &settings, const QSize &nativeSize, const qreal dpr) noexcept
+{
+    static constexpr const auto C = HitTestResult::Client;
+    static constexpr const auto T = HitTestResult::Top;
+    static constexpr const auto B = HitTestResult::Bottom;
+    static constexpr const auto L = HitTestResult::Left;
+    static constexpr const auto R = HitTestResult::Right;
+    static constexpr const auto TL = HitTestResult::TopLeft;
+    static constexpr const auto TR = HitTestResult::TopRight;
+    static constexpr const auto BL = HitTestResult::BottomLeft;
+    static constexpr const auto BR = HitTestResult::BottomRight;
+    // Rows are the vertical bands, columns are the horizontal bands: outer border,
+    // corner extension, middle, corner extension, outer border.
+    static constexpr const std::array<HitTestResult, 25> kFullTable =
+    {
+        TL, TL, T, TR, TR,
+        TL, C,  C, C,  TR,
+        L,  C,  C, C,  R,
+        BL, C,  C, C,  BR,
+        BL, BL, B, BR, BR
+    };
+    devicePixelRatio = ((dpr > qreal(0)) ? dpr : qreal(1));
+    horizontal = calculateBands(nativeSize.width(), settings, devicePixelRatio);
+    vertical = calculateBands(nativeSize.height(), settings, devicePixelRatio);
+    for (std::size_t i = 0; i != kFullTable.size(); ++i) {
+        table[i] = edgesToHitTestResult(HitTest::toWindowEdges(kFullTable[i]) & settings.edges);
+    }
+}
+
+QPoint ResizeBorderBands::mapToNative(const QPointF &logicalPos) const noexcept
+{
+    return QPoint(qFloor(logicalPos.x() * devicePixelRatio), qFloor(logicalPos.y() * devicePixelRatio));
+}
+
+HitTestResult ResizeBorderBands::lookup(const QPointF &logicalPos) const noexcept
+{
+    return lookupNative(mapToNative(logicalPos));
+}
+
+HitTestResult ResizeBorderBands::lookupNative(const QPoint &nativePos) const noexcept
+{
+    return table[(bandIndex(vertical, nativePos.y()) * 5) + bandIndex(horizontal, nativePos.x())];
+}
+
+HitTestResult HitTest::evaluate(const HitTestSnapshot &snapshot, const QPoint &pos) noexcept
+{
+    const int x = pos.x();
+    const int y = pos.y();
+    const int width = snapshot.size.width();
+    const int height = snapshot.size.height();
+    if (snapshot.insideSystemButton) {
+        // Even if the mouse is inside the chrome button area now, we should still allow the user
+        // to be able to resize the window with the top or right window border, this is also the
+        // normal behavior of a native Win32 window.
+        const int border = snapshot.systemButtonResizeBorder;
+        const bool isTop = ((border > 0) && (y <= border));
+        const bool isRight = ((border > 0) && (x >= (width - border)));
+        if (isTop && isRight) {
+            return HitTestResult::TopRight;
+        }
+        if (isTop) {
+            return HitTestResult::Top;
+        }
+        if (isRight) {
+            return HitTestResult::Right;
+        }
+        return systemButtonToHitTestResult(snapshot.systemButton);
+    }
+    const bool noResize = (snapshot.fixedSize || snapshot.dontOverrideCursor);
+    const HitTestResult border = (snapshot.resizeBorder ? snapshot.resizeBorder->lookupNative(pos) : HitTestResult::Client);
+    const bool isTop = (snapshot.resizeBorder ? toWindowEdges(border).testFlag(Qt::TopEdge) : (y < snapshot.resizeBorderThicknessY));
+    if (snapshot.frameBorderVisible) {
+        // The platform handles the left, right and bottom parts of the frame itself.
+        if (snapshot.nativeResult != HitTestResult::Client) {
+            return (noResize ? HitTestResult::Border : snapshot.nativeResult);
+        }
+    }
+    if (snapshot.fullScreen) {
+        return HitTestResult::Client;
+    }
+    if (snapshot.maximized) {
+        return (snapshot.insideTitleBar ? HitTestResult::Caption : HitTestResult::Client);
+    }
+    if (snapshot.frameBorderVisible) {
+        // At this point the cursor is inside the client area, so it has to be either
+        // the little border at the top of our custom title bar or the drag bar.
+        if (isTop) {
+            // Return Client instead of Border here, to let our title bar still capture mouse events.
+            return (noResize ? HitTestResult::Client : HitTestResult::Top);
+        }
+        return (snapshot.insideTitleBar ? HitTestResult::Caption : HitTestResult::Client);
+    }
+    if (!snapshot.fixedSize && snapshot.resizeBorder) {
+        if (border != HitTestResult::Client) {
+            // Same as below, let the controls inside our window still capture mouse events.
+            return (snapshot.dontOverrideCursor ? HitTestResult::Client : border);
+        }
+    } else if (!snapshot.fixedSize) {
+        const bool isBottom = (y >= (height - snapshot.resizeBorderThicknessY));
+        const qreal scaleFactor = ((isTop || isBottom) ? snapshot.cornerScaleFactor : qreal(1));
+        const int frameSizeX = qRound(qreal(snapshot.resizeBorderThicknessX) * scaleFactor);
+        const bool isLeft = (x < frameSizeX);
+        const bool isRight = (x >= (width - frameSizeX));
+        if (snapshot.dontOverrideCursor && (isTop || isBottom || isLeft || isRight)) {
+            // Return Client instead of Border here, to let the controls inside
+            // our window still capture mouse events.
+            return HitTestResult::Client;
+        }
+        if (isTop) {
+            if (isLeft) {
+                return HitTestResult::TopLeft;
+            }
+            if (isRight) {
+                return HitTestResult::TopRight;
+            }
+            return HitTestResult::Top;
+        }
+        if (isBottom) {
+            if (isLeft) {
+                return HitTestResult::BottomLeft;
+            }
+            if (isRight) {
+                return HitTestResult::BottomRight;
+            }
+            return HitTestResult::Bottom;
+        }
+        if (isLeft) {
+            return HitTestResult::Left;
+        }
+        if (isRight) {
+            return HitTestResult::Right;
+        }
+    }
+    return (snapshot.insideTitleBar ? HitTestResult::Caption : HitTestResult::Client);
+}
+
+Qt::Edges HitTest::toWindowEdges(const HitTestResult result) noexcept
+{
+    switch (result) {
+    case HitTestResult::Top:
+        return Qt::TopEdge;
+    case HitTestResult::Bottom:
+        return Qt::BottomEdge;
+    case HitTestResult::Left:
+        return Qt::LeftEdge;
+    case HitTestResult::Right:
+        return Qt::RightEdge;
+    case HitTestResult::TopLeft:
+        return (Qt::TopEdge | Qt::LeftEdge);
+    case HitTestResult::TopRight:
+        return (Qt::TopEdge | Qt::RightEdge);
+    case HitTestResult::BottomLeft:
+        return (Qt::BottomEdge | Qt::LeftEdge);
+    case HitTestResult::BottomRight:
+        return (Qt::BottomEdge | Qt::RightEdge);
+    default:
+        break;
+    }
+    return {};
+}
+
+Qt::CursorShape HitTest::toCursorShape(const HitTestResult result) noexcept
+{
+    switch (result) {
+    case HitTestResult::TopLeft:
+    case HitTestResult::BottomRight:
+        return Qt::SizeFDiagCursor;
+    case HitTestResult::TopRight:
+    case HitTestResult::BottomLeft:
+        return Qt::SizeBDiagCursor;
+    case HitTestResult::Left:
+    case HitTestResult::Right:
+        return Qt::SizeHorCursor;
+    case HitTestResult::Top:
+    case HitTestResult::Bottom:
+        return Qt::SizeVerCursor;
+    default:
+        break;
+    }
+    return Qt::ArrowCursor;
+}
+
+ResizeBorderSettings HitTest::readResizeBorderSettings(const SystemParameters &params, const ResizeBorderSettings &defaults)
+{
+    Q_ASSERT(params.getProperty);
+    if (!params.getProperty) {
+        return defaults;
+    }
+    ResizeBorderSettings settings = defaults;
+    settings.thickness = params.getProperty(kResizeBorderThicknessVar, defaults.thickness).toInt();
+    settings.cornerSize = params.getProperty(kResizeBorderCornerSizeVar, defaults.cornerSize).toInt();
+    const int edges = params.getProperty(kResizableEdgesVar, -1).toInt();
+    if (edges >= 0) {
+        settings.edges = Qt::Edges(QFlag(edges));
+    }
+    return settings;
+}
+
+bool HitTest::isResizeBorderProperty(const QByteArray &name) noexcept
+{
+    return ((name == kResizeBorderThicknessVar) || (name == kResizeBorderCornerSizeVar) || (name == kResizableEdgesVar));
+}
+
+FRAMELESSHELPER_END_NAMESPACE
@@ -0,0 +1 @@
+#include "../../include/FramelessHelper/Core/private/hittest_p.h"
@@ -0,0 +1,321 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021-2023 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "linuxtheme_p.h"
+#include "linuxwallpaper_p.h"
+
+#if (defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID))
+
+#include <FramelessHelper/Core/framelesshelper_linux.h>
+#include <QtCore/qdir.h>
+#include <QtCore/qfile.h>
+#include <QtCore/qloggingcategory.h>
+#include <QtCore/qmutex.h>
+#include <QtCore/qstandardpaths.h>
+#include <algorithm>
+
+FRAMELESSHELPER_BEGIN_NAMESPACE
+
+#if FRAMELESSHELPER_CONFIG(debug_output)
+[[maybe_unused]] static Q_LOGGING_CATEGORY(lcLinuxTheme, "wangwenx190.framelesshelper.core.linuxtheme")
+#  define INFO qCInfo(lcLinuxTheme)
+#  define DEBUG qCDebug(lcLinuxTheme)
+#  define WARNING qCWarning(lcLinuxTheme)
+#  define CRITICAL qCCritical(lcLinuxTheme)
+#else
+#  define INFO QT_NO_QDEBUG_MACRO()
+#  define DEBUG QT_NO_QDEBUG_MACRO()
+#  define WARNING QT_NO_QDEBUG_MACRO()
+#  define CRITICAL QT_NO_QDEBUG_MACRO()
+#endif
+
+using namespace Global;
+
+// Settings files are tiny and the dconf database rarely exceeds a megabyte,
+// anything bigger than this is not one of them.
+static constexpr const qint64 kMaximumFileSize = 16 * 1024 * 1024;
+
+static constexpr const char kGnomeInterfaceDir[] = "/org/gnome/desktop/interface/";
+
+struct LinuxThemeData
+{
+    QMutex mutex{};
+    LinuxTheme::ThemeHints portal = {};
+};
+
+Q_GLOBAL_STATIC(LinuxThemeData, g_linuxThemeData)
+
+[[nodiscard]] static inline QByteArray readSmallFile(const QString &filePath)
+{
+    QFile file(filePath);
+    if (!file.open(QFile::ReadOnly) || (file.size() > kMaximumFileSize)) {
+        return {};
+    }
+    return file.readAll();
+}
+
+[[nodiscard]] static inline bool isKdeSession()
+{
+    return qEnvironmentVariable("XDG_CURRENT_DESKTOP").contains(FRAMELESSHELPER_STRING("KDE"), Qt::CaseInsensitive);
+}
+
+[[nodiscard]] static inline std::optional<bool> parseBool(const QByteArray &value)
+{
+    const QByteArray lower = value.trimmed().toLower();
+    if ((lower == FRAMELESSHELPER_BYTEARRAY_LITERAL("true")) || (lower == FRAMELESSHELPER_BYTEARRAY_LITERAL("1"))) {
+        return true;
+    }
+    if ((lower == FRAMELESSHELPER_BYTEARRAY_LITERAL("false")) || (lower == FRAMELESSHELPER_BYTEARRAY_LITERAL("0"))) {
+        return false;
+    }
+    return std::nullopt;
+}
+
+// KDE writes colors as "r,g,b" or "r,g,b,a", "#rrggbb" shows up occasionally as well.
+[[nodiscard]] static inline std::optional<QColor> parseKdeColor(const QByteArray &value)
+{
+    const QByteArray trimmed = value.trimmed();
+    if (trimmed.startsWith('#')) {
+        const QColor color(QString::fromLatin1(trimmed));
+        return (color.isValid() ? std::optional<QColor>(color) : std::nullopt);
+    }
+    const QList<QByteArray> parts = trimmed.split(',');
+    if ((parts.size() != 3) && (parts.size() != 4)) {
+        return std::nullopt;
+    }
+    int components[4] = { 0, 0, 0, 255 };
+    for (int i = 0; i != parts.size(); ++i) {
+        bool ok = false;
+        components[i] = parts.at(i).trimmed().toInt(&ok);
+        if (!ok || (components[i] < 0) || (components[i] > 255)) {
+            return std::nullopt;
+        }
+    }
+    return QColor(components[0], components[1], components[2], components[3]);
+}
+
+// Calls the handler with (group, key, value) for every entry of an INI style file.
+template<typename Handler>
+static inline void forEachIniEntry(const QByteArray &data, Handler &&handler)
+{
+    QByteArray group = {};
+    for (auto &&rawLine : data.split('\n')) {
+        const QByteArray line = rawLine.trimmed();
+        if (line.isEmpty() || line.startsWith('#') || line.startsWith(';')) {
+            continue;
+        }
+        if (line.startsWith('[') && line.endsWith(']')) {
+            group = line.mid(1, line.size() - 2).trimmed();
+            continue;
+        }
+        const int equal = line.indexOf('=');
+        if (equal <= 0) {
+            continue;
+        }
+        QByteArray key = line.left(equal).trimmed();
+        if (const int flags = key.indexOf('['); flags > 0) {
+            // KDE's "Key[$e]" and localized keys.
+            key.truncate(flags);
+        }
+        handler(group, key, line.mid(equal + 1).trimmed());
+    }
+}
+
+LinuxTheme::ThemeHints LinuxTheme::parseGtkThemeEnv(const QString &value)
+{
+    ThemeHints hints = {};
+    if (!value.isEmpty()) {
+        // Either the "Name:dark" variant syntax, or a theme with "dark" in its name.
+        hints.dark = value.contains(FRAMELESSHELPER_STRING("dark"), Qt::CaseInsensitive);
+    }
+    return hints;
+}
+
+LinuxTheme::ThemeHints LinuxTheme::parseGtkSettingsIni(const QByteArray &data)
+{
+    std::optional<bool> preferDark = std::nullopt;
+    QByteArray themeName = {};
+    forEachIniEntry(data, [&preferDark, &themeName](const QByteArray &group, const QByteArray &key, const QByteArray &value){
+        if (group != FRAMELESSHELPER_BYTEARRAY_LITERAL("Settings")) {
+            return;
+        }
+        if (key == GTK_THEME_PREFER_DARK_PROP) {
+            preferDark = parseBool(value);
+        } else if (key == GTK_THEME_NAME_PROP) {
+            themeName = value;
+        }
+    });
+    ThemeHints hints = {};
+    if (preferDark.value_or(false)) {
+        hints.dark = true;
+    } else if (!themeName.isEmpty()) {
+        hints.dark = themeName.toLower().contains("dark");
+    } else if (preferDark.has_value()) {
+        hints.dark = false;
+    }
+    return hints;
+}
+
+LinuxTheme::ThemeHints LinuxTheme::parseKdeGlobals(const QByteArray &data)
+{
+    QByteArray colorScheme = {};
+    std::optional<QColor> windowBackground = std::nullopt;
+    std::optional<QColor> accentColor = std::nullopt;
+    std::optional<QColor> selectionBackground = std::nullopt;
+    std::optional<bool> titleBarColorized = std::nullopt;
+    forEachIniEntry(data, [&](const QByteArray &group, const QByteArray &key, const QByteArray &value){
+        if (group == FRAMELESSHELPER_BYTEARRAY_LITERAL("General")) {
+            if (key == FRAMELESSHELPER_BYTEARRAY_LITERAL("ColorScheme")) {
+                colorScheme = value;
+            } else if (key == FRAMELESSHELPER_BYTEARRAY_LITERAL("AccentColor")) {
+                accentColor = parseKdeColor(value);
+            } else if (key == FRAMELESSHELPER_BYTEARRAY_LITERAL("TitlebarIsAccentColored")) {
+                titleBarColorized = parseBool(value);
+            }
+        } else if (group == FRAMELESSHELPER_BYTEARRAY_LITERAL("Colors:Window")) {
+            if (key == FRAMELESSHELPER_BYTEARRAY_LITERAL("BackgroundNormal")) {
+                windowBackground = parseKdeColor(value);
+            }
+        } else if (group == FRAMELESSHELPER_BYTEARRAY_LITERAL("Colors:Selection")) {
+            if (key == FRAMELESSHELPER_BYTEARRAY_LITERAL("BackgroundNormal")) {
+                selectionBackground = parseKdeColor(value);
+            }
+        }
+    });
+    ThemeHints hints = {};
+    if (windowBackground.has_value()) {
+        // The scheme name is just a name, the colors are what the user actually sees.
+        hints.dark = (windowBackground->lightnessF() < 0.5);
+    } else if (!colorScheme.isEmpty()) {
+        hints.dark = colorScheme.toLower().contains("dark");
+    }
+    // Without an explicit accent color the scheme's selection color is used.
+    hints.accentColor = (accentColor.has_value() ? accentColor : selectionBackground);
+    hints.titleBarColorized = titleBarColorized;
+    return hints;
+}
+
+LinuxTheme::ThemeHints LinuxTheme::parseDconfUser(const QByteArray &data)
+{
+    const LinuxWallpaper::StringMap interface = LinuxWallpaper::parseDconfDatabase(data, QUtf8String(kGnomeInterfaceDir));
+    const QString colorScheme = interface.value(FRAMELESSHELPER_STRING_LITERAL("color-scheme"));
+    const QString themeName = interface.value(FRAMELESSHELPER_STRING_LITERAL("gtk-theme"));
+    ThemeHints hints = {};
+    // Same priorities as the GTK settings files: the explicit preference first, then the theme name.
+    // "default" means no preference, just like the portal's 0.
+    if (colorScheme == FRAMELESSHELPER_STRING_LITERAL("prefer-dark")) {
+        hints.dark = true;
+    } else if (!themeName.isEmpty()) {
+        hints.dark = themeName.contains(FRAMELESSHELPER_STRING("dark"), Qt::CaseInsensitive);
+    } else if (colorScheme == FRAMELESSHELPER_STRING_LITERAL("prefer-light")) {
+        hints.dark = false;
+    }
+    return hints;
+}
+
+LinuxTheme::ThemeHints LinuxTheme::parsePortalAppearance
+    (const std::optional<quint32> &colorScheme, const std::optional<std::array<qreal, 3>> &accentColor)
+{
+    ThemeHints hints = {};
+    if (colorScheme.has_value()) {
+        switch (colorScheme.value()) {
+        case 1:
+            hints.dark = true;
+            break;
+        case 2:
+            hints.dark = false;
+            break;
+        default:
+            // No preference, let the other sources decide.
+            break;
+        }
+    }
+    if (accentColor.has_value()) {
+        const std::array<qreal, 3> &rgb = accentColor.value();
+        const bool valid = std::all_of(rgb.cbegin(), rgb.cend(), [](const qreal component){
+            return ((component >= 0) && (component <= 1));
+        });
+        if (valid) {
+            hints.accentColor = QColor::fromRgbF(rgb.at(0), rgb.at(1), rgb.at(2));
+        }
+    }
+    return hints;
+}
+
+void LinuxTheme::setPortalHints(const ThemeHints &hints)
+{
+    const QMutexLocker locker(&g_linuxThemeData()->mutex);
+    g_linuxThemeData()->portal = hints;
+}
+
+LinuxTheme::ThemeHints LinuxTheme::portalHints()
+{
+    const QMutexLocker locker(&g_linuxThemeData()->mutex);
+    return g_linuxThemeData()->portal;
+}
+
+QStringList LinuxTheme::configFiles()
+{
+    // Honors XDG_CONFIG_HOME.
+    const QDir config(QStandardPaths::writableLocation(QStandardPaths::GenericConfigLocation));
+    const QString kdeGlobals = config.filePath(FRAMELESSHELPER_STRING_LITERAL("kdeglobals"));
+    const QString gtk3 = config.filePath(FRAMELESSHELPER_STRING_LITERAL("gtk-3.0/settings.ini"));
+    const QString gtk4 = config.filePath(FRAMELESSHELPER_STRING_LITERAL("gtk-4.0/settings.ini"));
+    const QString dconf = config.filePath(FRAMELESSHELPER_STRING_LITERAL("dconf/user"));
+    if (isKdeSession()) {
+        return { kdeGlobals, gtk3, gtk4, dconf };
+    }
+    return { dconf, gtk3, gtk4, kdeGlobals };
+}
+
+LinuxTheme::ThemeHints LinuxTheme::current()
+{
+    ThemeHints hints = parseGtkThemeEnv(qEnvironmentVariable(GTK_THEME_NAME_ENV_VAR));
+    hints.fillFrom(portalHints());
+    if (hints.isComplete()) {
+        return hints;
+    }
+    const QStringList files = configFiles();
+    for (auto &&file : std::as_const(files)) {
+        const QByteArray data = readSmallFile(file);
+        if (data.isEmpty()) {
+            continue;
+        }
+        if (file.endsWith(FRAMELESSHELPER_STRING("kdeglobals"))) {
+            hints.fillFrom(parseKdeGlobals(data));
+        } else if (file.endsWith(FRAMELESSHELPER_STRING("dconf/user"))) {
+            hints.fillFrom(parseDconfUser(data));
+        } else {
+            hints.fillFrom(parseGtkSettingsIni(data));
+        }
+        if (hints.isComplete()) {
+            break;
+        }
+    }
+    return hints;
+}
+
+FRAMELESSHELPER_END_NAMESPACE
+
+#endif // (defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID))
@@ -0,0 +1,982 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021-2023 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "linuxwallpaper_p.h"
+
+#if (defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID))
+
+#include <QtCore/qdir.h>
+#include <QtCore/qendian.h>
+#include <QtCore/qfile.h>
+#include <QtCore/qfileinfo.h>
+#include <QtCore/qloggingcategory.h>
+#include <QtCore/qstandardpaths.h>
+#include <QtCore/qurl.h>
+#include <QtCore/qxmlstream.h>
+#include <algorithm>
+#include <iterator>
+#include <optional>
+
+FRAMELESSHELPER_BEGIN_NAMESPACE
+
+#if FRAMELESSHELPER_CONFIG(debug_output)
+[[maybe_unused]] static Q_LOGGING_CATEGORY(lcLinuxWallpaper, "wangwenx190.framelesshelper.core.linuxwallpaper")
+#  define INFO qCInfo(lcLinuxWallpaper)
+#  define DEBUG qCDebug(lcLinuxWallpaper)
+#  define WARNING qCWarning(lcLinuxWallpaper)
+#  define CRITICAL qCCritical(lcLinuxWallpaper)
+#else
+#  define INFO QT_NO_QDEBUG_MACRO()
+#  define DEBUG QT_NO_QDEBUG_MACRO()
+#  define WARNING QT_NO_QDEBUG_MACRO()
+#  define CRITICAL QT_NO_QDEBUG_MACRO()
+#endif
+
+using namespace Global;
+
+// The configuration files we read are a few kilobytes, the dconf database rarely
+// exceeds a megabyte. Anything larger than this is not what we are looking for.
+static constexpr const qint64 kMaximumFileSize = 16 * 1024 * 1024;
+
+static constexpr const char kGnomeBackgroundDir[] = "/org/gnome/desktop/background/";
+static constexpr const char kGnomeInterfaceDir[] = "/org/gnome/desktop/interface/";
+static constexpr const char kCinnamonBackgroundDir[] = "/org/cinnamon/desktop/background/";
+static constexpr const char kMateBackgroundDir[] = "/org/mate/desktop/background/";
+
+[[nodiscard]] static inline QByteArray readSmallFile(const QString &filePath)
+{
+    if (filePath.isEmpty()) {
+        return {};
+    }
+    QFile file(filePath);
+    if (!file.open(QFile::ReadOnly)) {
+        return {};
+    }
+    if (file.size() > kMaximumFileSize) {
+        WARNING << filePath << "is too large to be a configuration file.";
+        return {};
+    }
+    return file.readAll();
+}
+
+[[nodiscard]] static inline QString configHome()
+{
+    // Honors XDG_CONFIG_HOME.
+    return QStandardPaths::writableLocation(QStandardPaths::GenericConfigLocation);
+}
+
+// Accepts both "file://" URIs and plain paths, "~" is expanded as well.
+[[nodiscard]] static inline QString toLocalPath(const QString &value)
+{
+    const QString trimmed = value.trimmed();
+    if (trimmed.isEmpty()) {
+        return {};
+    }
+    if (trimmed.startsWith(FRAMELESSHELPER_STRING_LITERAL("file:"))) {
+        return QUrl(trimmed).toLocalFile();
+    }
+    if ((trimmed == u'~') || trimmed.startsWith(FRAMELESSHELPER_STRING_LITERAL("~/"))) {
+        return (QDir::homePath() + trimmed.mid(1));
+    }
+    if (trimmed.startsWith(u'/')) {
+        return trimmed;
+    }
+    return {};
+}
+
+// A (very) small subset of the shell's word splitting, enough for the lines
+// written by feh and for sway's configuration syntax.
+[[nodiscard]] static inline QList<QByteArray> splitArguments(const QByteArray &line)
+{
+    QList<QByteArray> result = {};
+    QByteArray current = {};
+    bool inWord = false;
+    char quote = '\0';
+    for (int i = 0; i != line.size(); ++i) {
+        const char ch = line.at(i);
+        if (quote != '\0') {
+            if (ch == quote) {
+                quote = '\0';
+            } else if ((ch == '\\') && (quote == '"') && ((i + 1) < line.size())) {
+                current.append(line.at(++i));
+            } else {
+                current.append(ch);
+            }
+            continue;
+        }
+        if ((ch == '\'') || (ch == '"')) {
+            quote = ch;
+            inWord = true;
+        } else if ((ch == '\\') && ((i + 1) < line.size())) {
+            current.append(line.at(++i));
+            inWord = true;
+        } else if ((ch == ' ') || (ch == '\t')) {
+            if (inWord) {
+                result.append(current);
+                current.clear();
+                inWord = false;
+            }
+        } else if ((ch == '#') && !inWord) {
+            break;
+        } else {
+            current.append(ch);
+            inWord = true;
+        }
+    }
+    if (inWord) {
+        result.append(current);
+    }
+    return result;
+}
+
+// GVariant text format, as used by dconf keyfiles: 'string', "string" or a bare value.
+[[nodiscard]] static inline QString parseGVariantText(const QByteArray &text)
+{
+    QByteArray value = text.trimmed();
+    if (value.startsWith('@')) {
+        // Type annotation, such as "@s 'foo'".
+        const int space = value.indexOf(' ');
+        value = ((space < 0) ? QByteArray{} : value.mid(space + 1).trimmed());
+    }
+    const char quote = (value.isEmpty() ? '\0' : value.at(0));
+    if ((value.size() < 2) || ((quote != '\'') && (quote != '"')) || (value.at(value.size() - 1) != quote)) {
+        return QUtf8String(value);
+    }
+    QByteArray result = {};
+    result.reserve(value.size() - 2);
+    for (int i = 1; i < (value.size() - 1); ++i) {
+        const char ch = value.at(i);
+        if ((ch == '\\') && ((i + 1) < (value.size() - 1))) {
+            const char next = value.at(++i);
+            switch (next) {
+            case 'n':
+                result.append('\n');
+                break;
+            case 't':
+                result.append('\t');
+                break;
+            default:
+                result.append(next);
+                break;
+            }
+        } else {
+            result.append(ch);
+        }
+    }
+    return QUtf8String(result);
+}
+
+/*
+    GVDB, the on-disk format of dconf databases, little-endian:
+
+    header: "GVariant" signature, version, options, root table pointer (start, end)
+    table: bloom filter header, bucket count, bloom words, buckets, then the items
+    item: hash, parent item index, key pointer (start, size), type, value pointer
+
+    Each item only stores the last component of its name, the full name is the
+    concatenation of the names of its parents. We don't need the hash buckets,
+    a linear scan over a few hundred items is fast enough.
+*/
+static constexpr const quint32 kGvdbHeaderSize = 24;
+static constexpr const quint32 kGvdbItemSize = 24;
+static constexpr const quint32 kGvdbNoParent = 0xFFFFFFFF;
+static constexpr const int kGvdbMaximumDepth = 64;
+
+[[nodiscard]] static inline quint32 gvdbRead32(const QByteArray &data, const quint32 offset)
+{
+    return qFromLittleEndian<quint32>(data.constData() + offset);
+}
+
+[[nodiscard]] static inline quint16 gvdbRead16(const QByteArray &data, const quint32 offset)
+{
+    return qFromLittleEndian<quint16>(data.constData() + offset);
+}
+
+LinuxWallpaper::StringMap LinuxWallpaper::parseDconfDatabase(const QByteArray &data, const QString &dir)
+{
+    const auto size = quint32(data.size());
+    if ((size < kGvdbHeaderSize) || !data.startsWith(FRAMELESSHELPER_BYTEARRAY_LITERAL("GVariant"))) {
+        // The byte-swapped signature belongs to databases written on big-endian
+        // machines, we don't bother with them.
+        return {};
+    }
+    const quint32 rootStart = gvdbRead32(data, 16);
+    const quint32 rootEnd = gvdbRead32(data, 20);
+    if ((rootStart > rootEnd) || (rootEnd > size) || ((rootEnd - rootStart) < 8)) {
+        return {};
+    }
+    const quint32 bloomWords = (gvdbRead32(data, rootStart) & ((1u << 27) - 1));
+    const quint32 buckets = gvdbRead32(data, rootStart + 4);
+    const quint64 itemsStart = (quint64(rootStart) + 8 + ((quint64(bloomWords) + buckets) * 4));
+    if (itemsStart > rootEnd) {
+        return {};
+    }
+    const auto itemCount = quint32((rootEnd - itemsStart) / kGvdbItemSize);
+    const auto itemOffset = [itemsStart](const quint32 index) -> quint32 {
+        return quint32(itemsStart + (quint64(index) * kGvdbItemSize));
+    };
+    const auto itemKey = [&data, size, &itemOffset](const quint32 index) -> std::optional<QByteArray> {
+        const quint32 offset = itemOffset(index);
+        const quint32 keyStart = gvdbRead32(data, offset + 8);
+        const quint16 keySize = gvdbRead16(data, offset + 12);
+        if ((quint64(keyStart) + keySize) > size) {
+            return std::nullopt;
+        }
+        return QByteArray(data.constData() + keyStart, keySize);
+    };
+    const QByteArray prefix = dir.toUtf8();
+    StringMap result = {};
+    for (quint32 index = 0; index != itemCount; ++index) {
+        const quint32 offset = itemOffset(index);
+        if (data.at(offset + 14) != 'v') {
+            // Directories ('H') and lists ('L') don't carry values.
+            continue;
+        }
+        std::optional<QByteArray> name = itemKey(index);
+        quint32 parent = gvdbRead32(data, offset + 4);
+        int depth = 0;
+        while (name.has_value() && (parent != kGvdbNoParent)) {
+            if ((parent >= itemCount) || (++depth > kGvdbMaximumDepth)) {
+                name = std::nullopt;
+                break;
+            }
+            const std::optional<QByteArray> parentName = itemKey(parent);
+            if (!parentName.has_value()) {
+                name = std::nullopt;
+                break;
+            }
+            name = parentName.value() + name.value();
+            parent = gvdbRead32(data, itemOffset(parent) + 4);
+        }
+        if (!name.has_value() || !name->startsWith(prefix) || name->indexOf('/', prefix.size()) >= 0) {
+            continue;
+        }
+        const quint32 valueStart = gvdbRead32(data, offset + 16);
+        const quint32 valueEnd = gvdbRead32(data, offset + 20);
+        if ((valueStart > valueEnd) || (valueEnd > size)) {
+            continue;
+        }
+        // A serialized variant: the child's data, a zero byte and the child's type.
+        const QByteArray variant = data.mid(valueStart, valueEnd - valueStart);
+        const int separator = variant.lastIndexOf('\0');
+        if ((separator < 1) || (variant.mid(separator + 1) != FRAMELESSHELPER_BYTEARRAY_LITERAL("s"))) {
+            continue;
+        }
+        // Strings are serialized with their terminating zero byte.
+        QByteArray value = variant.left(separator);
+        if (value.endsWith('\0')) {
+            value.chop(1);
+        }
+        result.insert(QUtf8String(name->mid(prefix.size())), QUtf8String(value));
+    }
+    return result;
+}
+
+// "/org/gnome/desktop/background/" -> "org/gnome/desktop/background"
+[[nodiscard]] static inline QByteArray trimSlashes(const QString &dir)
+{
+    QByteArray result = dir.toUtf8();
+    while (result.startsWith('/')) {
+        result.remove(0, 1);
+    }
+    while (result.endsWith('/')) {
+        result.chop(1);
+    }
+    return result;
+}
+
+// The keys of one group of a GLib keyfile, the values are in the GVariant text format.
+[[nodiscard]] static inline LinuxWallpaper::StringMap parseKeyfileGroup(const QByteArray &data, const QByteArray &group)
+{
+    LinuxWallpaper::StringMap result = {};
+    bool inGroup = false;
+    for (auto &&rawLine : data.split('\n')) {
+        const QByteArray line = rawLine.trimmed();
+        if (line.isEmpty() || line.startsWith('#')) {
+            continue;
+        }
+        if (line.startsWith('[') && line.endsWith(']')) {
+            inGroup = (line.mid(1, line.size() - 2).trimmed() == group);
+            continue;
+        }
+        if (!inGroup) {
+            continue;
+        }
+        const int equal = line.indexOf('=');
+        if (equal <= 0) {
+            continue;
+        }
+        result.insert(QUtf8String(line.left(equal).trimmed()), parseGVariantText(line.mid(equal + 1)));
+    }
+    return result;
+}
+
+LinuxWallpaper::StringMap LinuxWallpaper::parseDconfKeyfile(const QByteArray &data, const QString &dir)
+{
+    // Keyfile groups are written without the leading and the trailing slash.
+    return parseKeyfileGroup(data, trimSlashes(dir));
+}
+
+LinuxWallpaper::StringMap LinuxWallpaper::parseGSettingsOverride(const QByteArray &data,
+    const QString &schema, const QStringList &desktops)
+{
+    const QByteArray group = schema.toUtf8();
+    StringMap result = parseKeyfileGroup(data, group);
+    // Same as glib-compile-schemas: the first matching desktop wins.
+    for (auto it = desktops.crbegin(); it != desktops.crend(); ++it) {
+        const StringMap specific = parseKeyfileGroup(data, group + ':' + it->toUtf8());
+        for (auto key = specific.cbegin(); key != specific.cend(); ++key) {
+            result.insert(key.key(), key.value());
+        }
+    }
+    return result;
+}
+
+/*
+    /usr/share/glib-2.0/schemas/org.gnome.desktop.background.gschema.xml:
+
+    <schemalist>
+      <schema id="org.gnome.desktop.background" path="/org/gnome/desktop/background/">
+        <key name="picture-uri" type="s">
+          <default>'file:///usr/share/backgrounds/gnome/adwaita-l.jxl'</default>
+        </key>
+*/
+LinuxWallpaper::StringMap LinuxWallpaper::parseGSettingsSchema(const QByteArray &data, const QString &schema)
+{
+    StringMap result = {};
+    QXmlStreamReader reader(data);
+    bool inSchema = false;
+    QString key = {};
+    while (!reader.atEnd()) {
+        const QXmlStreamReader::TokenType token = reader.readNext();
+        if (token == QXmlStreamReader::StartElement) {
+            if (reader.name() == FRAMELESSHELPER_STRING("schema")) {
+                inSchema = (reader.attributes().value(FRAMELESSHELPER_STRING("id")) == schema);
+            } else if (inSchema && (reader.name() == FRAMELESSHELPER_STRING("key"))) {
+                key = reader.attributes().value(FRAMELESSHELPER_STRING("name")).toString();
+            } else if (inSchema && !key.isEmpty() && (reader.name() == FRAMELESSHELPER_STRING("default"))) {
+                result.insert(key, parseGVariantText(reader.readElementText().toUtf8()));
+            }
+        } else if (token == QXmlStreamReader::EndElement) {
+            if (reader.name() == FRAMELESSHELPER_STRING("schema")) {
+                inSchema = false;
+            } else if (reader.name() == FRAMELESSHELPER_STRING("key")) {
+                key.clear();
+            }
+        }
+    }
+    if (reader.hasError()) {
+        WARNING << "Failed to parse the GSettings schema:" << reader.errorString();
+    }
+    return result;
+}
+
+LinuxWallpaper::Wallpaper LinuxWallpaper::wallpaperFromGSettings(const StringMap &values, const bool dark)
+{
+    const QString uri = [&values, dark]() -> QString {
+        if (dark) {
+            const QString darkUri = values.value(FRAMELESSHELPER_STRING_LITERAL("picture-uri-dark"));
+            if (!darkUri.isEmpty()) {
+                return darkUri;
+            }
+        }
+        const QString lightUri = values.value(FRAMELESSHELPER_STRING_LITERAL("picture-uri"));
+        if (!lightUri.isEmpty()) {
+            return lightUri;
+        }
+        // MATE stores a plain path instead.
+        return values.value(FRAMELESSHELPER_STRING_LITERAL("picture-filename"));
+    }();
+    const QString options = values.value(FRAMELESSHELPER_STRING_LITERAL("picture-options"));
+    if (options == FRAMELESSHELPER_STRING_LITERAL("none")) {
+        // Solid color or gradient background.
+        return {};
+    }
+    Wallpaper wallpaper = {};
+    wallpaper.filePath = toLocalPath(uri);
+    wallpaper.valid = !wallpaper.filePath.isEmpty();
+    if ((options == FRAMELESSHELPER_STRING_LITERAL("wallpaper")) || (options == FRAMELESSHELPER_STRING_LITERAL("tiled"))) {
+        wallpaper.aspectStyle = WallpaperAspectStyle::Tile;
+    } else if (options == FRAMELESSHELPER_STRING_LITERAL("centered")) {
+        wallpaper.aspectStyle = WallpaperAspectStyle::Center;
+    } else if (options == FRAMELESSHELPER_STRING_LITERAL("scaled")) {
+        wallpaper.aspectStyle = WallpaperAspectStyle::Fit;
+    } else if (options == FRAMELESSHELPER_STRING_LITERAL("stretched")) {
+        wallpaper.aspectStyle = WallpaperAspectStyle::Stretch;
+    } else if (options == FRAMELESSHELPER_STRING_LITERAL("spanned")) {
+        wallpaper.aspectStyle = WallpaperAspectStyle::Span;
+    } else {
+        // "zoom", also the default value.
+        wallpaper.aspectStyle = WallpaperAspectStyle::Fill;
+    }
+    return wallpaper;
+}
+
+/*
+    ~/.config/plasma-org.kde.plasma.desktop-appletsrc, one containment per desktop:
+
+    [Containments][1]
+    wallpaperplugin=org.kde.image
+
+    [Containments][1][Wallpaper][org.kde.image][General]
+    FillMode=2
+    Image=file:///usr/share/wallpapers/Next/
+*/
+LinuxWallpaper::Wallpaper LinuxWallpaper::parsePlasmaAppletsrc(const QByteArray &data)
+{
+    struct Containment
+    {
+        QByteArray id = {};
+        QByteArray plugin = {};
+        QByteArray image = {};
+        int fillMode = 2; // Qt's Image.PreserveAspectCrop
+    };
+    QList<Containment> containments = {};
+    const auto containment = [&containments](const QByteArray &id) -> Containment & {
+        for (auto &&item : containments) {
+            if (item.id == id) {
+                return item;
+            }
+        }
+        Containment item = {};
+        item.id = id;
+        containments.append(item);
+        return containments.last();
+    };
+    QList<QByteArray> groups = {};
+    for (auto &&rawLine : data.split('\n')) {
+        const QByteArray line = rawLine.trimmed();
+        if (line.isEmpty() || line.startsWith('#')) {
+            continue;
+        }
+        if (line.startsWith('[') && line.endsWith(']')) {
+            groups = line.mid(1, line.size() - 2).split(']');
+            for (auto &&group : groups) {
+                if (group.startsWith('[')) {
+                    group.remove(0, 1);
+                }
+            }
+            continue;
+        }
+        if ((groups.size() < 2) || (groups.constFirst() != FRAMELESSHELPER_BYTEARRAY_LITERAL("Containments"))) {
+            continue;
+        }
+        const int equal = line.indexOf('=');
+        if (equal <= 0) {
+            continue;
+        }
+        QByteArray key = line.left(equal).trimmed();
+        if (const int flags = key.indexOf('['); flags > 0) {
+            // Such as "Image[$e]".
+            key.truncate(flags);
+        }
+        const QByteArray value = line.mid(equal + 1).trimmed();
+        if ((groups.size() == 2) && (key == FRAMELESSHELPER_BYTEARRAY_LITERAL("wallpaperplugin"))) {
+            containment(groups.at(1)).plugin = value;
+        } else if ((groups.size() == 5) && (groups.at(2) == FRAMELESSHELPER_BYTEARRAY_LITERAL("Wallpaper"))
+            && (groups.at(3) == FRAMELESSHELPER_BYTEARRAY_LITERAL("org.kde.image"))
+            && (groups.at(4) == FRAMELESSHELPER_BYTEARRAY_LITERAL("General"))) {
+            if (key == FRAMELESSHELPER_BYTEARRAY_LITERAL("Image")) {
+                containment(groups.at(1)).image = value;
+            } else if (key == FRAMELESSHELPER_BYTEARRAY_LITERAL("FillMode")) {
+                bool ok = false;
+                const int fillMode = value.toInt(&ok);
+                if (ok) {
+                    containment(groups.at(1)).fillMode = fillMode;
+                }
+            }
+        }
+    }
+    for (auto &&item : std::as_const(containments)) {
+        if ((item.plugin != FRAMELESSHELPER_BYTEARRAY_LITERAL("org.kde.image")) || item.image.isEmpty()) {
+            continue;
+        }
+        Wallpaper wallpaper = {};
+        wallpaper.filePath = toLocalPath(QUtf8String(item.image));
+        wallpaper.valid = !wallpaper.filePath.isEmpty();
+        switch (item.fillMode) {
+        case 0: // Stretch
+            wallpaper.aspectStyle = WallpaperAspectStyle::Stretch;
+            break;
+        case 1: // PreserveAspectFit
+            wallpaper.aspectStyle = WallpaperAspectStyle::Fit;
+            break;
+        case 3: // Tile
+        case 4: // TileVertically
+        case 5: // TileHorizontally
+            wallpaper.aspectStyle = WallpaperAspectStyle::Tile;
+            break;
+        case 6: // Pad
+            wallpaper.aspectStyle = WallpaperAspectStyle::Center;
+            break;
+        default: // PreserveAspectCrop
+            wallpaper.aspectStyle = WallpaperAspectStyle::Fill;
+            break;
+        }
+        if (wallpaper.valid) {
+            return wallpaper;
+        }
+    }
+    return {};
+}
+
+/*
+    ~/.config/xfce4/xfconf/xfce-perchannel-xml/xfce4-desktop.xml:
+
+    <channel name="xfce4-desktop" version="1.0">
+      <property name="backdrop" type="empty">
+        <property name="screen0" type="empty">
+          <property name="monitoreDP-1" type="empty">
+            <property name="workspace0" type="empty">
+              <property name="image-style" type="int" value="5"/>
+              <property name="last-image" type="string" value="/usr/share/backgrounds/xfce/xfce-blue.jpg"/>
+*/
+LinuxWallpaper::Wallpaper LinuxWallpaper::parseXfceDesktopXml(const QByteArray &data)
+{
+    struct Backdrop
+    {
+        QString path = {};
+        QString image = {};
+        int style = 5; // Zoomed
+    };
+    QList<Backdrop> backdrops = {};
+    QStringList stack = {};
+    QXmlStreamReader reader(data);
+    while (!reader.atEnd()) {
+        const QXmlStreamReader::TokenType token = reader.readNext();
+        if (token == QXmlStreamReader::EndElement) {
+            if (reader.name() == FRAMELESSHELPER_STRING("property") && !stack.isEmpty()) {
+                stack.removeLast();
+            }
+            continue;
+        }
+        if ((token != QXmlStreamReader::StartElement) || (reader.name() != FRAMELESSHELPER_STRING("property"))) {
+            continue;
+        }
+        const QXmlStreamAttributes attributes = reader.attributes();
+        const QString name = attributes.value(FRAMELESSHELPER_STRING("name")).toString();
+        const QString value = attributes.value(FRAMELESSHELPER_STRING("value")).toString();
+        if (!stack.isEmpty() && (stack.constFirst() == FRAMELESSHELPER_STRING("backdrop"))) {
+            const bool isImage = ((name == FRAMELESSHELPER_STRING("last-image")) || (name == FRAMELESSHELPER_STRING("image-path")));
+            const bool isStyle = (name == FRAMELESSHELPER_STRING("image-style"));
+            if (isImage || isStyle) {
+                const QString path = stack.join(u'/');
+                auto it = std::find_if(backdrops.begin(), backdrops.end(), [&path](const Backdrop &backdrop){
+                    return (backdrop.path == path);
+                });
+                if (it == backdrops.end()) {
+                    Backdrop backdrop = {};
+                    backdrop.path = path;
+                    backdrops.append(backdrop);
+                    it = std::prev(backdrops.end());
+                }
+                if (isImage) {
+                    it->image = value;
+                } else {
+                    bool ok = false;
+                    const int style = value.toInt(&ok);
+                    if (ok) {
+                        it->style = style;
+                    }
+                }
+            }
+        }
+        stack.append(name);
+    }
+    if (reader.hasError()) {
+        WARNING << "Failed to parse the XFCE desktop configuration:" << reader.errorString();
+    }
+    for (auto &&backdrop : std::as_const(backdrops)) {
+        if (backdrop.image.isEmpty() || (backdrop.style == 0)) {
+            // Style 0 means no image at all.
+            continue;
+        }
+        Wallpaper wallpaper = {};
+        wallpaper.filePath = toLocalPath(backdrop.image);
+        wallpaper.valid = !wallpaper.filePath.isEmpty();
+        switch (backdrop.style) {
+        case 1:
+            wallpaper.aspectStyle = WallpaperAspectStyle::Center;
+            break;
+        case 2:
+            wallpaper.aspectStyle = WallpaperAspectStyle::Tile;
+            break;
+        case 3:
+            wallpaper.aspectStyle = WallpaperAspectStyle::Stretch;
+            break;
+        case 4:
+            wallpaper.aspectStyle = WallpaperAspectStyle::Fit;
+            break;
+        case 6:
+            wallpaper.aspectStyle = WallpaperAspectStyle::Span;
+            break;
+        default:
+            wallpaper.aspectStyle = WallpaperAspectStyle::Fill;
+            break;
+        }
+        if (wallpaper.valid) {
+            return wallpaper;
+        }
+    }
+    return {};
+}
+
+/*
+    ~/.config/sway/config, either form:
+
+    set $wallpaper ~/Pictures/wallpaper.png
+    output * bg $wallpaper fill
+
+    output eDP-1 {
+        bg ~/Pictures/wallpaper.png fill
+    }
+*/
+LinuxWallpaper::Wallpaper LinuxWallpaper::parseSwayConfig(const QByteArray &data)
+{
+    QHash<QByteArray, QByteArray> variables = {};
+    bool inOutputBlock = false;
+    for (auto &&rawLine : data.split('\n')) {
+        QList<QByteArray> args = splitArguments(rawLine);
+        if (args.isEmpty()) {
+            continue;
+        }
+        if ((args.size() >= 3) && (args.constFirst() == FRAMELESSHELPER_BYTEARRAY_LITERAL("set")) && args.at(1).startsWith('$')) {
+            variables.insert(args.at(1), args.mid(2).join(' '));
+            continue;
+        }
+        for (auto &&arg : args) {
+            if (arg.startsWith('$') && variables.contains(arg)) {
+                arg = variables.value(arg);
+            }
+        }
+        if (args.constFirst() == FRAMELESSHELPER_BYTEARRAY_LITERAL("}")) {
+            inOutputBlock = false;
+            continue;
+        }
+        int bg = -1;
+        if ((args.size() >= 2) && (args.constFirst() == FRAMELESSHELPER_BYTEARRAY_LITERAL("output"))) {
+            if (args.constLast() == FRAMELESSHELPER_BYTEARRAY_LITERAL("{")) {
+                inOutputBlock = true;
+                continue;
+            }
+            bg = 2;
+        } else if (inOutputBlock) {
+            bg = 0;
+        }
+        if ((bg < 0) || ((bg + 1) >= args.size())) {
+            continue;
+        }
+        const QByteArray &command = args.at(bg);
+        if ((command != FRAMELESSHELPER_BYTEARRAY_LITERAL("bg")) && (command != FRAMELESSHELPER_BYTEARRAY_LITERAL("background"))) {
+            continue;
+        }
+        const QByteArray mode = (((bg + 2) < args.size()) ? args.at(bg + 2) : FRAMELESSHELPER_BYTEARRAY_LITERAL("fill"));
+        if (mode == FRAMELESSHELPER_BYTEARRAY_LITERAL("solid_color")) {
+            continue;
+        }
+        Wallpaper wallpaper = {};
+        wallpaper.filePath = toLocalPath(QUtf8String(args.at(bg + 1)));
+        wallpaper.valid = !wallpaper.filePath.isEmpty();
+        if (mode == FRAMELESSHELPER_BYTEARRAY_LITERAL("stretch")) {
+            wallpaper.aspectStyle = WallpaperAspectStyle::Stretch;
+        } else if (mode == FRAMELESSHELPER_BYTEARRAY_LITERAL("fit")) {
+            wallpaper.aspectStyle = WallpaperAspectStyle::Fit;
+        } else if (mode == FRAMELESSHELPER_BYTEARRAY_LITERAL("center")) {
+            wallpaper.aspectStyle = WallpaperAspectStyle::Center;
+        } else if (mode == FRAMELESSHELPER_BYTEARRAY_LITERAL("tile")) {
+            wallpaper.aspectStyle = WallpaperAspectStyle::Tile;
+        } else {
+            wallpaper.aspectStyle = WallpaperAspectStyle::Fill;
+        }
+        if (wallpaper.valid) {
+            return wallpaper;
+        }
+    }
+    return {};
+}
+
+/*
+    ~/.fehbg, written by feh itself:
+
+    #!/bin/sh
+    feh --no-fehbg --bg-fill '/home/user/Pictures/wallpaper.jpg'
+*/
+LinuxWallpaper::Wallpaper LinuxWallpaper::parseFehbg(const QByteArray &data)
+{
+    for (auto &&rawLine : data.split('\n')) {
+        const QList<QByteArray> args = splitArguments(rawLine);
+        if (args.isEmpty() || !args.constFirst().endsWith(FRAMELESSHELPER_BYTEARRAY_LITERAL("feh"))) {
+            continue;
+        }
+        std::optional<WallpaperAspectStyle> style = std::nullopt;
+        for (int i = 1; i != args.size(); ++i) {
+            const QByteArray &arg = args.at(i);
+            if (arg == FRAMELESSHELPER_BYTEARRAY_LITERAL("--bg-center")) {
+                style = WallpaperAspectStyle::Center;
+            } else if (arg == FRAMELESSHELPER_BYTEARRAY_LITERAL("--bg-fill")) {
+                style = WallpaperAspectStyle::Fill;
+            } else if (arg == FRAMELESSHELPER_BYTEARRAY_LITERAL("--bg-max")) {
+                style = WallpaperAspectStyle::Fit;
+            } else if (arg == FRAMELESSHELPER_BYTEARRAY_LITERAL("--bg-scale")) {
+                style = WallpaperAspectStyle::Stretch;
+            } else if (arg == FRAMELESSHELPER_BYTEARRAY_LITERAL("--bg-tile")) {
+                style = WallpaperAspectStyle::Tile;
+            } else if (style.has_value() && !arg.startsWith('-')) {
+                // The first image wins, the others go to the other monitors.
+                Wallpaper wallpaper = {};
+                wallpaper.filePath = toLocalPath(QUtf8String(arg));
+                wallpaper.valid = !wallpaper.filePath.isEmpty();
+                wallpaper.aspectStyle = style.value();
+                if (wallpaper.valid) {
+                    return wallpaper;
+                }
+            }
+        }
+    }
+    return {};
+}
+
+// Plasma's default wallpapers are packages, not pictures: pick the largest one.
+[[nodiscard]] static inline QString resolveWallpaperPackage(const QString &path)
+{
+    const QFileInfo info(path);
+    if (!info.isDir()) {
+        return path;
+    }
+    const QDir images(QDir(path).filePath(FRAMELESSHELPER_STRING_LITERAL("contents/images")));
+    QString best = {};
+    qint64 bestArea = -1;
+    for (auto &&entry : images.entryInfoList(QDir::Files)) {
+        // The file names are the resolutions, such as "1920x1080.png".
+        const QStringList size = entry.completeBaseName().split(u'x');
+        const qint64 area = ((size.size() == 2) ? (size.at(0).toLongLong() * size.at(1).toLongLong()) : 0);
+        if (area > bestArea) {
+            bestArea = area;
+            best = entry.absoluteFilePath();
+        }
+    }
+    return best;
+}
+
+[[nodiscard]] static inline QStringList currentDesktops()
+{
+    QStringList desktops = qEnvironmentVariable("XDG_CURRENT_DESKTOP").toLower().split(u':');
+    desktops.removeAll(QString());
+    return desktops;
+}
+
+[[nodiscard]] static inline QString gsettingsBackgroundDir()
+{
+    const QStringList desktops = currentDesktops();
+    for (auto &&desktop : std::as_const(desktops)) {
+        if (desktop.contains(FRAMELESSHELPER_STRING("cinnamon"))) {
+            return QUtf8String(kCinnamonBackgroundDir);
+        }
+        if (desktop == FRAMELESSHELPER_STRING("mate")) {
+            return QUtf8String(kMateBackgroundDir);
+        }
+    }
+    return QUtf8String(kGnomeBackgroundDir);
+}
+
+// Inserts the keys that are not there yet.
+static inline void mergeMissing(LinuxWallpaper::StringMap &values, const LinuxWallpaper::StringMap &more)
+{
+    for (auto it = more.cbegin(); it != more.cend(); ++it) {
+        if (!values.contains(it.key())) {
+            values.insert(it.key(), it.value());
+        }
+    }
+}
+
+// What GSettings falls back to for the keys that are not in dconf: the vendor
+// overrides (later files win), then the schema itself.
+[[nodiscard]] static inline LinuxWallpaper::StringMap gsettingsDefaults(const QString &dir)
+{
+    const QString schema = QUtf8String(trimSlashes(dir)).replace(u'/', u'.');
+    const QStringList desktops = currentDesktops();
+    LinuxWallpaper::StringMap result = {};
+    const QStringList dataDirs = QStandardPaths::standardLocations(QStandardPaths::GenericDataLocation);
+    // The first data directory has the highest priority.
+    for (auto it = dataDirs.crbegin(); it != dataDirs.crend(); ++it) {
+        const QDir schemas(QDir(*it).filePath(FRAMELESSHELPER_STRING_LITERAL("glib-2.0/schemas")));
+        if (!schemas.exists()) {
+            continue;
+        }
+        const QFileInfoList overrides = schemas.entryInfoList({ FRAMELESSHELPER_STRING_LITERAL("*.gschema.override") }, QDir::Files, QDir::Name);
+        for (auto &&entry : std::as_const(overrides)) {
+            const LinuxWallpaper::StringMap values = LinuxWallpaper::parseGSettingsOverride(readSmallFile(entry.absoluteFilePath()), schema, desktops);
+            for (auto value = values.cbegin(); value != values.cend(); ++value) {
+                result.insert(value.key(), value.value());
+            }
+        }
+    }
+    for (auto &&dataDir : std::as_const(dataDirs)) {
+        const QString filePath = QDir(dataDir).filePath(FRAMELESSHELPER_STRING_LITERAL("glib-2.0/schemas/") + schema + FRAMELESSHELPER_STRING_LITERAL(".gschema.xml"));
+        if (QFileInfo::exists(filePath)) {
+            mergeMissing(result, LinuxWallpaper::parseGSettingsSchema(readSmallFile(filePath), schema));
+            break;
+        }
+    }
+    return result;
+}
+
+QList<LinuxWallpaper::Source> LinuxWallpaper::currentSources()
+{
+    QList<Source> sources = {};
+    const QStringList desktops = currentDesktops();
+    for (auto &&desktop : std::as_const(desktops)) {
+        const Source source = [&desktop]() -> Source {
+            if (desktop == FRAMELESSHELPER_STRING("kde")) {
+                return Source::Plasma;
+            }
+            if (desktop == FRAMELESSHELPER_STRING("xfce")) {
+                return Source::Xfce;
+            }
+            if (desktop == FRAMELESSHELPER_STRING("sway")) {
+                return Source::Sway;
+            }
+            if (desktop.contains(FRAMELESSHELPER_STRING("gnome")) || desktop.contains(FRAMELESSHELPER_STRING("cinnamon"))
+                || desktop.contains(FRAMELESSHELPER_STRING("budgie")) || (desktop == FRAMELESSHELPER_STRING("unity"))
+                || (desktop == FRAMELESSHELPER_STRING("ubuntu")) || (desktop == FRAMELESSHELPER_STRING("pantheon"))
+                || (desktop == FRAMELESSHELPER_STRING("mate")) || (desktop == FRAMELESSHELPER_STRING("pop"))) {
+                return Source::GSettings;
+            }
+            // i3, Openbox, bspwm and the other window managers usually rely on feh.
+            return Source::Feh;
+        }();
+        if (!sources.contains(source)) {
+            sources.append(source);
+        }
+    }
+    if (sources.isEmpty() && qEnvironmentVariableIsSet("SWAYSOCK")) {
+        sources.append(Source::Sway);
+    }
+    if (sources.isEmpty()) {
+        // No idea what's running, try the usual suspects.
+        sources.append(Source::Feh);
+        sources.append(Source::GSettings);
+    }
+    return sources;
+}
+
+QStringList LinuxWallpaper::configFiles(const Source source)
+{
+    const QDir config(configHome());
+    switch (source) {
+    case Source::GSettings: {
+        QStringList files = { config.filePath(FRAMELESSHELPER_STRING_LITERAL("dconf/user")) };
+        // System wide defaults, only used for the keys the user never changed.
+        const QDir local(FRAMELESSHELPER_STRING_LITERAL("/etc/dconf/db/local.d"));
+        for (auto &&entry : local.entryInfoList(QDir::Files, QDir::Name)) {
+            files.append(entry.absoluteFilePath());
+        }
+        return files;
+    }
+    case Source::Plasma:
+        return { config.filePath(FRAMELESSHELPER_STRING_LITERAL("plasma-org.kde.plasma.desktop-appletsrc")) };
+    case Source::Xfce:
+        return { config.filePath(FRAMELESSHELPER_STRING_LITERAL("xfce4/xfconf/xfce-perchannel-xml/xfce4-desktop.xml")) };
+    case Source::Sway:
+        return { config.filePath(FRAMELESSHELPER_STRING_LITERAL("sway/config")),
+                 QDir::home().filePath(FRAMELESSHELPER_STRING_LITERAL(".sway/config")) };
+    case Source::Feh:
+        return { QDir::home().filePath(FRAMELESSHELPER_STRING_LITERAL(".fehbg")) };
+    }
+    Q_UNREACHABLE_RETURN({});
+}
+
+LinuxWallpaper::Wallpaper LinuxWallpaper::read(const Source source)
+{
+    const QStringList files = configFiles(source);
+    if (source == Source::GSettings) {
+        const QString backgroundDir = gsettingsBackgroundDir();
+        const QString interfaceDir = QUtf8String(kGnomeInterfaceDir);
+        StringMap background = {};
+        StringMap interface = {};
+        for (auto &&file : std::as_const(files)) {
+            const QByteArray data = readSmallFile(file);
+            if (data.isEmpty()) {
+                continue;
+            }
+            const bool database = data.startsWith(FRAMELESSHELPER_BYTEARRAY_LITERAL("GVariant"));
+            // The user database comes first, so the user's choices win.
+            mergeMissing(background, (database ? parseDconfDatabase(data, backgroundDir) : parseDconfKeyfile(data, backgroundDir)));
+            mergeMissing(interface, (database ? parseDconfDatabase(data, interfaceDir) : parseDconfKeyfile(data, interfaceDir)));
+        }
+        // Stock installations have nothing in dconf, the wallpaper comes from the system defaults.
+        mergeMissing(background, gsettingsDefaults(backgroundDir));
+        mergeMissing(interface, gsettingsDefaults(interfaceDir));
+        const bool dark = (interface.value(FRAMELESSHELPER_STRING_LITERAL("color-scheme")) == FRAMELESSHELPER_STRING_LITERAL("prefer-dark"));
+        return wallpaperFromGSettings(background, dark);
+    }
+    for (auto &&file : std::as_const(files)) {
+        const QByteArray data = readSmallFile(file);
+        if (data.isEmpty()) {
+            continue;
+        }
+        Wallpaper wallpaper = [source, &data]() -> Wallpaper {
+            switch (source) {
+            case Source::Plasma:
+                return parsePlasmaAppletsrc(data);
+            case Source::Xfce:
+                return parseXfceDesktopXml(data);
+            case Source::Sway:
+                return parseSwayConfig(data);
+            case Source::Feh:
+                return parseFehbg(data);
+            case Source::GSettings:
+                break;
+            }
+            return {};
+        }();
+        if (!wallpaper.valid) {
+            continue;
+        }
+        if (source == Source::Plasma) {
+            wallpaper.filePath = resolveWallpaperPackage(wallpaper.filePath);
+            wallpaper.valid = !wallpaper.filePath.isEmpty();
+        }
+        if (wallpaper.valid) {
+            return wallpaper;
+        }
+    }
+    return {};
+}
+
+LinuxWallpaper::Wallpaper LinuxWallpaper::current()
+{
+    const QList<Source> sources = currentSources();
+    for (auto &&source : std::as_const(sources)) {
+        const Wallpaper wallpaper = read(source);
+        if (wallpaper.valid) {
+            return wallpaper;
+        }
+    }
+    return {};
+}
+
+FRAMELESSHELPER_END_NAMESPACE
+
+#endif // (defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID))
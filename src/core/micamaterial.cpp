@@ -28,9 +28,12 @@
 #if FRAMELESSHELPER_CONFIG(mica_material)
 
 #include "framelessmanager.h"
+#include "framelessmanager_p.h"
 #include "utils.h"
 #include "framelessconfig_p.h"
 #include "framelesshelpercore_global_p.h"
+#include "framelessstatistics_p.h"
+#include "tracing_p.h"
 #include <optional>
 #include <memory>
 #include <QtCore/qsysinfo.h>
@@ -500,6 +503,7 @@ Q_SIGNALS:
 protected:
     void run() override
     {
+        const qint64 loadStart = Trace::now();
         const QString wallpaperFilePath = Utils::getWallpaperFilePath();
         if (wallpaperFilePath.isEmpty()) {
             WARNING << "Failed to retrieve the wallpaper file path.";
@@ -531,6 +535,9 @@ protected:
             WARNING << "The obtained image data is null.";
             return;
         }
+        const qint64 scaleStart = Trace::now();
+        Stats::record(Stats::Latency::WallpaperLoad, quint64(scaleStart - loadStart));
+        Trace::complete("MicaMaterial::loadWallpaper", loadStart, scaleStart);
         WallpaperAspectStyle aspectStyle = Utils::getWallpaperAspectStyle();
         const QSize wallpaperSize = QGuiApplication::primaryScreen()->size();
         QImage buffer(wallpaperSize, kDefaultImageFormat);
@@ -570,7 +577,12 @@ protected:
             const QRect rect = alignedRect(Qt::LeftToRight, Qt::AlignCenter, image.size(), desktopRect);
             bufferPainter.drawImage(rect.topLeft(), image);
         }
+        const qint64 blurStart = Trace::now();
+        Stats::record(Stats::Latency::WallpaperScale, quint64(blurStart - scaleStart));
+        Trace::complete("MicaMaterial::scaleWallpaper", scaleStart, blurStart);
         {
+            const Stats::ScopedLatency blurLatency(Stats::Latency::WallpaperBlur);
+            const Trace::Span blurSpan("MicaMaterial::blurWallpaper");
             const QMutexLocker locker(&g_imageData()->mutex);
             g_imageData()->blurredWallpaper = QPixmap(wallpaperSize);
             g_imageData()->blurredWallpaper.fill(kDefaultTransparentColor);
@@ -661,7 +673,7 @@ void MicaMaterialPrivate::updateMaterialBrush()
     static const QImage noiseTexture = QImage(FRAMELESSHELPER_STRING_LITERAL(":/org.wangwenx190.FramelessHelper/resources/images/noise.png"));
 #endif // FRAMELESSHELPER_CORE_NO_BUNDLE_RESOURCE
     QImage micaTexture = QImage(QSize(64, 64), kDefaultImageFormat);
-    QColor fillColor = ((FramelessManager::instance()->systemTheme() == SystemTheme::Dark) ? kDefaultSystemDarkColor : kDefaultSystemLightColor2);
+    QColor fillColor = (FramelessManagerPrivate::currentThemeSnapshot()->dark ? kDefaultSystemDarkColor : kDefaultSystemLightColor2);
     fillColor.setAlphaF(0.9f);
     micaTexture.fill(fillColor);
     QPainter painter(&micaTexture);
@@ -703,6 +715,7 @@ void MicaMaterialPrivate::initialize()
         }
     });
     g_threadData()->mutex.unlock();
+    connect(q_func(), &MicaMaterial::shouldRedraw, this, [](){ Stats::increment(Stats::Counter::MicaRepaints); });
 
     wallpaperSize = QGuiApplication::primaryScreen()->size();
 
@@ -742,7 +755,7 @@ void MicaMaterialPrivate::prepareGraphicsResources()
 
 QColor MicaMaterialPrivate::systemFallbackColor()
 {
-    return ((FramelessManager::instance()->systemTheme() == SystemTheme::Dark) ? kDefaultFallbackColorDark : kDefaultFallbackColorLight);
+    return (FramelessManagerPrivate::currentThemeSnapshot()->dark ? kDefaultFallbackColorDark : kDefaultFallbackColorLight);
 }
 
 QPoint MicaMaterialPrivate::mapToWallpaper(const QPoint &pos) const
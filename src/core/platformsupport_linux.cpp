@@ -74,6 +74,7 @@ FRAMELESSHELPER_STRING_CONSTANT(xcb_list_properties_reply)
 FRAMELESSHELPER_STRING_CONSTANT(xcb_list_properties_atoms_length)
 FRAMELESSHELPER_STRING_CONSTANT(xcb_list_properties_atoms)
 FRAMELESSHELPER_STRING_CONSTANT(xcb_get_property_unchecked)
+FRAMELESSHELPER_STRING_CONSTANT(xcb_discard_reply)
 
 extern "C" xcb_void_cookie_t
 xcb_send_event(
@@ -290,6 +291,18 @@ xcb_get_property_unchecked(
             _delete, window, property, type, long_offset, long_length);
 }
 
+extern "C" void
+xcb_discard_reply(
+    xcb_connection_t *connection,
+    unsigned int sequence
+)
+{
+    if (!API_XCB_AVAILABLE(xcb_discard_reply)) {
+        return;
+    }
+    API_CALL_FUNCTION(libxcb, xcb_discard_reply, connection, sequence);
+}
+
 #endif // FRAMELESSHELPER_HAS_XCB
 
 ///////////////////////////////////////////////////
@@ -479,6 +492,7 @@ GTKSETTINGS_IMPL(QString, const QString result = QUtf8String(g_value_get_string(
 #endif // FRAMELESSHELPER_HAS_GTK
 
 FRAMELESSHELPER_BEGIN_NAMESPACE
+
 template<typename T>
 T gtkSettings(const gchar *property)
 {
@@ -510,6 +524,56 @@ QString gtkSettings(const gchar *property)
     g_free(raw);
     return result;
 }
+
+SysApiLoader::Manifest SysApiLoader::platformManifest()
+{
+    Manifest manifest = {};
+#ifndef FRAMELESSHELPER_HAS_XCB
+    manifest.append(ManifestEntry{ klibxcb, {
+        kxcb_send_event,
+        kxcb_flush,
+        kxcb_intern_atom,
+        kxcb_intern_atom_reply,
+        kxcb_ungrab_pointer,
+        kxcb_change_property,
+        kxcb_delete_property_checked,
+        kxcb_get_property,
+        kxcb_get_property_reply,
+        kxcb_get_property_value,
+        kxcb_get_property_value_length,
+        kxcb_list_properties,
+        kxcb_list_properties_reply,
+        kxcb_list_properties_atoms_length,
+        kxcb_list_properties_atoms,
+        kxcb_get_property_unchecked,
+        kxcb_discard_reply
+    }});
+#endif // FRAMELESSHELPER_HAS_XCB
+#ifndef FRAMELESSHELPER_HAS_GTK
+    // Loading GTK is expensive, only do it for the users who asked for it. This runs
+    // before the application object exists, so FramelessConfig can't be asked yet
+    // (it would never read the configuration file afterwards). When the option comes
+    // from the configuration file, the symbols are resolved on first use instead.
+    if (qEnvironmentVariableIntValue("FRAMELESSHELPER_USE_GTK_THEME_DETECTION") != 0) {
+        manifest.append(ManifestEntry{ klibgtk, {
+            kgtk_init,
+            kg_value_init,
+            kg_value_reset,
+            kg_value_unset,
+            kg_value_get_boolean,
+            kg_value_get_string,
+            kgtk_settings_get_default,
+            kg_object_get_property,
+            kg_signal_connect_data,
+            kg_free,
+            kg_object_unref,
+            kg_clear_object
+        }});
+    }
+#endif // FRAMELESSHELPER_HAS_GTK
+    return manifest;
+}
+
 FRAMELESSHELPER_END_NAMESPACE
 
 #endif // __linux__
@@ -502,4 +502,64 @@ _AdjustWindowRectExForDpi2(LPRECT lpRect, const DWORD dwStyle,
     return pAdjustWindowRectExForDpi(lpRect, dwStyle, bMenu, dwExStyle, dpi);
 }
 
+FRAMELESSHELPER_BEGIN_NAMESPACE
+
+SysApiLoader::Manifest SysApiLoader::platformManifest()
+{
+    // Everything utils_win.cpp and this file load through SysApiLoader. The ordinal
+    // only exports of uxtheme can't be listed here and are still resolved lazily.
+    return {
+        ManifestEntry{ FRAMELESSHELPER_STRING_LITERAL("user32"), {
+            FRAMELESSHELPER_STRING_LITERAL("AreDpiAwarenessContextsEqual"),
+            FRAMELESSHELPER_STRING_LITERAL("EnableNonClientDpiScaling"),
+            FRAMELESSHELPER_STRING_LITERAL("GetAwarenessFromDpiAwarenessContext"),
+            FRAMELESSHELPER_STRING_LITERAL("GetDpiAwarenessContextForProcess"),
+            FRAMELESSHELPER_STRING_LITERAL("GetDpiForSystem"),
+            FRAMELESSHELPER_STRING_LITERAL("GetSystemDpiForProcess"),
+            FRAMELESSHELPER_STRING_LITERAL("GetThreadDpiAwarenessContext"),
+            FRAMELESSHELPER_STRING_LITERAL("GetWindowCompositionAttribute"),
+            FRAMELESSHELPER_STRING_LITERAL("SetWindowCompositionAttribute"),
+            FRAMELESSHELPER_STRING_LITERAL("IsProcessDPIAware"),
+            FRAMELESSHELPER_STRING_LITERAL("SetProcessDPIAware"),
+            FRAMELESSHELPER_STRING_LITERAL("SetProcessDpiAwarenessContext"),
+            FRAMELESSHELPER_STRING_LITERAL("GetDpiForWindow"),
+            FRAMELESSHELPER_STRING_LITERAL("GetSystemMetricsForDpi"),
+            FRAMELESSHELPER_STRING_LITERAL("AdjustWindowRectExForDpi")
+        }},
+        ManifestEntry{ FRAMELESSHELPER_STRING_LITERAL("dwmapi"), {
+            FRAMELESSHELPER_STRING_LITERAL("DwmEnableBlurBehindWindow"),
+            FRAMELESSHELPER_STRING_LITERAL("DwmExtendFrameIntoClientArea"),
+            FRAMELESSHELPER_STRING_LITERAL("DwmFlush"),
+            FRAMELESSHELPER_STRING_LITERAL("DwmGetColorizationColor"),
+            FRAMELESSHELPER_STRING_LITERAL("DwmGetCompositionTimingInfo"),
+            FRAMELESSHELPER_STRING_LITERAL("DwmGetWindowAttribute"),
+            FRAMELESSHELPER_STRING_LITERAL("DwmIsCompositionEnabled"),
+            FRAMELESSHELPER_STRING_LITERAL("DwmSetWindowAttribute")
+        }},
+        ManifestEntry{ FRAMELESSHELPER_STRING_LITERAL("shcore"), {
+            FRAMELESSHELPER_STRING_LITERAL("GetDpiForMonitor"),
+            FRAMELESSHELPER_STRING_LITERAL("GetProcessDpiAwareness"),
+            FRAMELESSHELPER_STRING_LITERAL("GetScaleFactorForMonitor"),
+            FRAMELESSHELPER_STRING_LITERAL("SetProcessDpiAwareness")
+        }},
+        ManifestEntry{ FRAMELESSHELPER_STRING_LITERAL("uxtheme"), {
+            FRAMELESSHELPER_STRING_LITERAL("SetWindowTheme"),
+            FRAMELESSHELPER_STRING_LITERAL("SetWindowThemeAttribute")
+        }},
+        ManifestEntry{ FRAMELESSHELPER_STRING_LITERAL("winmm"), {
+            FRAMELESSHELPER_STRING_LITERAL("timeBeginPeriod"),
+            FRAMELESSHELPER_STRING_LITERAL("timeEndPeriod"),
+            FRAMELESSHELPER_STRING_LITERAL("timeGetDevCaps")
+        }},
+        ManifestEntry{ FRAMELESSHELPER_STRING_LITERAL("d2d1"), {
+            FRAMELESSHELPER_STRING_LITERAL("D2D1CreateFactory")
+        }},
+        ManifestEntry{ FRAMELESSHELPER_STRING_LITERAL("ntdll"), {
+            FRAMELESSHELPER_STRING_LITERAL("RtlGetVersion")
+        }}
+    };
+}
+
+FRAMELESSHELPER_END_NAMESPACE
+
 #endif // Q_OS_WINDOWS
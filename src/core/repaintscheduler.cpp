@@ -0,0 +1,125 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021-2023 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "repaintscheduler_p.h"
+#include "framelessstatistics_p.h"
+#include "tracing_p.h"
+#include <utility>
+#include <QtCore/qloggingcategory.h>
+#include <QtCore/qmath.h>
+#include <QtGui/qguiapplication.h>
+#include <QtGui/qscreen.h>
+
+FRAMELESSHELPER_BEGIN_NAMESPACE
+
+#if FRAMELESSHELPER_CONFIG(debug_output)
+[[maybe_unused]] static Q_LOGGING_CATEGORY(lcRepaintScheduler, "wangwenx190.framelesshelper.core.repaintscheduler")
+#  define INFO qCInfo(lcRepaintScheduler)
+#  define DEBUG qCDebug(lcRepaintScheduler)
+#  define WARNING qCWarning(lcRepaintScheduler)
+#  define CRITICAL qCCritical(lcRepaintScheduler)
+#else
+#  define INFO QT_NO_QDEBUG_MACRO()
+#  define DEBUG QT_NO_QDEBUG_MACRO()
+#  define WARNING QT_NO_QDEBUG_MACRO()
+#  define CRITICAL QT_NO_QDEBUG_MACRO()
+#endif
+
+using namespace Global;
+
+[[nodiscard]] static inline int frameInterval()
+{
+    const QScreen * const screen = QGuiApplication::primaryScreen();
+    const qreal refreshRate = (screen ? screen->refreshRate() : qreal(0));
+    return ((refreshRate > qreal(0)) ? qMax(1, qFloor(qreal(1000) / refreshRate)) : 16);
+}
+
+RepaintScheduler::RepaintScheduler(QObject *parent) : QObject(parent)
+{
+    m_timer.setSingleShot(true);
+    m_timer.setTimerType(Qt::PreciseTimer);
+    connect(&m_timer, &QTimer::timeout, this, &RepaintScheduler::flush);
+}
+
+RepaintScheduler::~RepaintScheduler() = default;
+
+RepaintScheduler *RepaintScheduler::instance()
+{
+    static RepaintScheduler scheduler;
+    return &scheduler;
+}
+
+void RepaintScheduler::schedule(QObject *target, const Callback &callback)
+{
+    Q_ASSERT(target);
+    Q_ASSERT(callback);
+    if (!target || !callback) {
+        return;
+    }
+    ++m_requestCount;
+    // Requesting the same target more than once within a frame only keeps the last callback.
+    m_pending.insert(target, Entry{ target, callback });
+    if (m_timer.isActive()) {
+        return;
+    }
+    // Don't repaint more than once per frame: if we have just flushed, wait for the
+    // rest of the current frame, otherwise flush in the next event loop iteration.
+    const int interval = (m_lastFlush.isValid() ? qMax(0, frameInterval() - int(m_lastFlush.elapsed())) : 0);
+    m_timer.start(interval);
+}
+
+void RepaintScheduler::flush()
+{
+    const Trace::Span span("RepaintScheduler::flush");
+    m_timer.stop();
+    if (m_pending.isEmpty()) {
+        return;
+    }
+    // The callbacks may schedule new repaints, they will go to the next frame.
+    const QHash<QObject *, Entry> pending = std::exchange(m_pending, {});
+    m_lastFlush.start();
+    for (auto it = pending.cbegin(); it != pending.cend(); ++it) {
+        const Entry &entry = it.value();
+        if (!entry.target) {
+            continue;
+        }
+        ++m_repaintCount;
+        Stats::increment(Stats::Counter::PaletteRepaints);
+        entry.callback();
+    }
+    DEBUG << "Flushed" << pending.size() << "repaint requests, total repaints:" << m_repaintCount
+          << ", total requests:" << m_requestCount;
+}
+
+quint64 RepaintScheduler::requestCount() const
+{
+    return m_requestCount;
+}
+
+quint64 RepaintScheduler::repaintCount() const
+{
+    return m_repaintCount;
+}
+
+FRAMELESSHELPER_END_NAMESPACE
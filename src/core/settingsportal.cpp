@@ -0,0 +1,201 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021-2023 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "settingsportal_p.h"
+
+#if (defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID))
+
+#include "linuxtheme_p.h"
+#include <QtCore/qloggingcategory.h>
+#ifdef FRAMELESSHELPER_HAS_DBUS
+#  include <QtDBus/qdbusargument.h>
+#  include <QtDBus/qdbusconnection.h>
+#  include <QtDBus/qdbuserror.h>
+#  include <QtDBus/qdbusextratypes.h>
+#  include <QtDBus/qdbusmessage.h>
+#  include <QtDBus/qdbusmetatype.h>
+#  include <QtDBus/qdbuspendingcall.h>
+#  include <QtDBus/qdbuspendingreply.h>
+#endif // FRAMELESSHELPER_HAS_DBUS
+
+FRAMELESSHELPER_BEGIN_NAMESPACE
+
+#if FRAMELESSHELPER_CONFIG(debug_output)
+[[maybe_unused]] static Q_LOGGING_CATEGORY(lcSettingsPortal, "wangwenx190.framelesshelper.core.settingsportal")
+#  define INFO qCInfo(lcSettingsPortal)
+#  define DEBUG qCDebug(lcSettingsPortal)
+#  define WARNING qCWarning(lcSettingsPortal)
+#  define CRITICAL qCCritical(lcSettingsPortal)
+#else
+#  define INFO QT_NO_QDEBUG_MACRO()
+#  define DEBUG QT_NO_QDEBUG_MACRO()
+#  define WARNING QT_NO_QDEBUG_MACRO()
+#  define CRITICAL QT_NO_QDEBUG_MACRO()
+#endif
+
+using namespace Global;
+
+#ifdef FRAMELESSHELPER_HAS_DBUS
+// https://flatpak.github.io/xdg-desktop-portal/docs/doc-org.freedesktop.portal.Settings.html
+// The portal is looked up on the session bus, so a test can point DBUS_SESSION_BUS_ADDRESS
+// to a private bus with a stand-in service.
+FRAMELESSHELPER_STRING_CONSTANT2(PortalService, "org.freedesktop.portal.Desktop")
+FRAMELESSHELPER_STRING_CONSTANT2(PortalPath, "/org/freedesktop/portal/desktop")
+FRAMELESSHELPER_STRING_CONSTANT2(PortalInterface, "org.freedesktop.portal.Settings")
+FRAMELESSHELPER_STRING_CONSTANT2(ReadAll, "ReadAll")
+FRAMELESSHELPER_STRING_CONSTANT2(SettingChanged, "SettingChanged")
+FRAMELESSHELPER_STRING_CONSTANT2(AppearanceNamespace, "org.freedesktop.appearance")
+FRAMELESSHELPER_STRING_CONSTANT2(ColorSchemeKey, "color-scheme")
+FRAMELESSHELPER_STRING_CONSTANT2(AccentColorKey, "accent-color")
+
+using PortalSettings = QMap<QString, QVariantMap>;
+
+// The accent color is a (ddd) structure, which Qt hands over undecoded.
+[[nodiscard]] static inline std::optional<std::array<qreal, 3>> decodeAccentColor(const QVariant &value)
+{
+    if (!value.canConvert<QDBusArgument>()) {
+        return std::nullopt;
+    }
+    const auto argument = value.value<QDBusArgument>();
+    if (argument.currentType() != QDBusArgument::StructureType) {
+        return std::nullopt;
+    }
+    double red = -1;
+    double green = -1;
+    double blue = -1;
+    argument.beginStructure();
+    argument >> red >> green >> blue;
+    argument.endStructure();
+    return std::array<qreal, 3>{ red, green, blue };
+}
+#endif // FRAMELESSHELPER_HAS_DBUS
+
+SettingsPortal::SettingsPortal(QObject *parent) : QObject(parent)
+{
+}
+
+SettingsPortal::~SettingsPortal() = default;
+
+bool SettingsPortal::isSupported()
+{
+#ifdef FRAMELESSHELPER_HAS_DBUS
+    return true;
+#else // !FRAMELESSHELPER_HAS_DBUS
+    return false;
+#endif // FRAMELESSHELPER_HAS_DBUS
+}
+
+void SettingsPortal::start()
+{
+#ifdef FRAMELESSHELPER_HAS_DBUS
+    static const bool registered = [](){
+        qDBusRegisterMetaType<PortalSettings>();
+        return true;
+    }();
+    Q_UNUSED(registered);
+    if (m_started) {
+        return;
+    }
+    QDBusConnection bus = QDBusConnection::sessionBus();
+    if (!bus.isConnected()) {
+        DEBUG << "No D-Bus session bus, the settings portal won't be used.";
+        return;
+    }
+    m_started = true;
+    // Subscribe first, so that nothing can slip through between the answer and the subscription.
+    // Matching on the sender also means a portal that starts later is still picked up.
+    if (!bus.connect(kPortalService, kPortalPath, kPortalInterface, kSettingChanged,
+            this, SLOT(handleSettingChanged(QDBusMessage)))) {
+        WARNING << "Failed to subscribe to the changes of the settings portal:" << bus.lastError().message();
+    }
+    QDBusMessage message = QDBusMessage::createMethodCall(kPortalService, kPortalPath, kPortalInterface, kReadAll);
+    message << QStringList{ kAppearanceNamespace };
+    const QDBusPendingCall call = bus.asyncCall(message);
+    const auto watcher = new QDBusPendingCallWatcher(call, this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [this](QDBusPendingCallWatcher *self){
+        self->deleteLater();
+        const QDBusPendingReply<PortalSettings> reply = *self;
+        if (reply.isError()) {
+            // Most likely there's simply no portal, which is fine.
+            DEBUG << "The settings portal is not available:" << reply.error().message();
+            return;
+        }
+        apply(reply.value().value(kAppearanceNamespace));
+    });
+#endif // FRAMELESSHELPER_HAS_DBUS
+}
+
+#ifdef FRAMELESSHELPER_HAS_DBUS
+void SettingsPortal::handleSettingChanged(const QDBusMessage &message)
+{
+    const QVariantList arguments = message.arguments();
+    if ((arguments.size() != 3) || (arguments.at(0).toString() != kAppearanceNamespace)) {
+        return;
+    }
+    const QString key = arguments.at(1).toString();
+    const QVariant value = arguments.at(2).value<QDBusVariant>().variant();
+    if (key == kColorSchemeKey) {
+        bool ok = false;
+        const quint32 colorScheme = value.toUInt(&ok);
+        m_colorScheme = (ok ? std::optional<quint32>(colorScheme) : std::nullopt);
+    } else if (key == kAccentColorKey) {
+        m_accentColor = decodeAccentColor(value);
+    } else {
+        // contrast, reduced-motion ... nothing we care about.
+        return;
+    }
+    DEBUG << "The settings portal reported a change of" << key;
+    publish();
+}
+#endif // FRAMELESSHELPER_HAS_DBUS
+
+void SettingsPortal::apply(const QVariantMap &appearance)
+{
+#ifdef FRAMELESSHELPER_HAS_DBUS
+    if (const auto it = appearance.constFind(kColorSchemeKey); it != appearance.constEnd()) {
+        bool ok = false;
+        const quint32 value = it.value().toUInt(&ok);
+        if (ok) {
+            m_colorScheme = value;
+        }
+    }
+    if (const auto it = appearance.constFind(kAccentColorKey); it != appearance.constEnd()) {
+        m_accentColor = decodeAccentColor(it.value());
+    }
+    DEBUG << "Received the appearance settings from the settings portal.";
+    publish();
+#else // !FRAMELESSHELPER_HAS_DBUS
+    Q_UNUSED(appearance);
+#endif // FRAMELESSHELPER_HAS_DBUS
+}
+
+void SettingsPortal::publish()
+{
+    LinuxTheme::setPortalHints(LinuxTheme::parsePortalAppearance(m_colorScheme, m_accentColor));
+    Q_EMIT updated();
+}
+
+FRAMELESSHELPER_END_NAMESPACE
+
+#endif // (defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID))
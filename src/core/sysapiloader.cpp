@@ -23,6 +23,8 @@
  */
 
 #include "sysapiloader_p.h"
+#include "framelessstatistics_p.h"
+#include "flightrecorder_p.h"
 
 #ifndef SYSAPILOADER_FORCE_QLIBRARY
 #  define SYSAPILOADER_FORCE_QLIBRARY (0)
@@ -47,7 +49,11 @@
 #include <QtCore/qhash.h>
 #include <QtCore/qloggingcategory.h>
 #include <QtCore/qdir.h>
+#include <QtCore/qmutex.h>
 #include <QtCore/qvarlengtharray.h>
+#include <QtCore/qelapsedtimer.h>
+#include <future>
+#include <memory>
 #if SYSAPILOADER_QSYSTEMLIBRARY
 #  include <QtCore/private/qsystemlibrary_p.h>
 #endif // SYSAPILOADER_QSYSTEMLIBRARY
@@ -70,7 +76,26 @@ FRAMELESSHELPER_BEGIN_NAMESPACE
 #  define CRITICAL QT_NO_QDEBUG_MACRO()
 #endif
 
-using SysApiLoaderData = QHash<QString, QFunctionPointer>;
+#if SYSAPILOADER_QSYSTEMLIBRARY
+using SysApiLibrary = QSystemLibrary;
+#endif // SYSAPILOADER_QSYSTEMLIBRARY
+#if SYSAPILOADER_QLIBRARY
+using SysApiLibrary = QLibrary;
+#endif // SYSAPILOADER_QLIBRARY
+
+struct SysApiLoaderData
+{
+    // The slots make this the slow path only, but it can still be hit from any thread.
+    QMutex mutex{};
+    QHash<QString, QFunctionPointer> functions = {};
+    // Separate lock: loading a library can take a while, the lookups of the functions
+    // resolved already shouldn't wait for that. The libraries are loaded once and
+    // never unloaded, exactly like the system would do for us.
+    QMutex libraryMutex{};
+    QHash<QString, std::shared_ptr<SysApiLibrary>> libraries = {};
+    // Declared last so that it's destroyed (and thus waited for) first.
+    std::future<void> prefetch = {};
+};
 
 Q_GLOBAL_STATIC(SysApiLoaderData, g_sysApiLoaderData)
 
@@ -160,12 +185,27 @@ QFunctionPointer SysApiLoader::resolve(const QString &library, const char *funct
     if (library.isEmpty() || !function) {
         return nullptr;
     }
-#if SYSAPILOADER_QSYSTEMLIBRARY
-    return QSystemLibrary::resolve(library, function);
-#endif // SYSAPILOADER_QSYSTEMLIBRARY
+    Stats::increment(Stats::Counter::SysApiResolutions);
+    const Stats::ScopedLatency latency(Stats::Latency::SysApiResolve);
+    // The static QLibrary::resolve() would construct and load a new library object
+    // for each and every symbol, keep one handle per library instead.
+    std::shared_ptr<SysApiLibrary> handle = nullptr;
+    {
+        const QMutexLocker locker(&g_sysApiLoaderData()->libraryMutex);
+        auto &cached = g_sysApiLoaderData()->libraries[library];
+        if (!cached) {
+            cached = std::make_shared<SysApiLibrary>(library);
+            if (!cached->load()) {
 #if SYSAPILOADER_QLIBRARY
-    return QLibrary::resolve(library, function);
-#endif // SYSAPILOADER_QLIBRARY
+                WARNING << "Failed to load" << library << ':' << cached->errorString();
+#else
+                WARNING << "Failed to load" << library;
+#endif
+            }
+        }
+        handle = cached;
+    }
+    return handle->resolve(function);
 }
 
 QFunctionPointer SysApiLoader::resolve(const QString &library, const QString &function)
@@ -186,29 +226,40 @@ bool SysApiLoader::isAvailable(const QString &library, const QString &function)
         return false;
     }
     const QString key = generateUniqueKey(library, function);
-    const auto it = g_sysApiLoaderData()->constFind(key);
-    if (it != g_sysApiLoaderData()->constEnd()) {
+    {
+        const QMutexLocker locker(&g_sysApiLoaderData()->mutex);
+        const auto it = g_sysApiLoaderData()->functions.constFind(key);
+        if (it != g_sysApiLoaderData()->functions.constEnd()) {
 #if FRAMELESSHELPER_CONFIG(debug_output)
-        if (isDebug()) {
-            DEBUG << Q_FUNC_INFO << "Function cache found:" << key;
-        }
+            if (isDebug()) {
+                DEBUG << Q_FUNC_INFO << "Function cache found:" << key;
+            }
 #endif
-        return (it.value() != nullptr);
-    } else {
-        const QFunctionPointer symbol = SysApiLoader::resolve(library, function);
-        g_sysApiLoaderData()->insert(key, symbol);
-#if FRAMELESSHELPER_CONFIG(debug_output)
-        if (isDebug()) {
-            DEBUG << Q_FUNC_INFO << "New function cache:" << key << (symbol ? "[VALID]" : "[NULL]");
+            Stats::increment(Stats::Counter::SysApiCacheHits);
+            return (it.value() != nullptr);
         }
+    }
+    // Resolved without holding the lock, so a library being loaded (by the
+    // prefetch thread, for example) doesn't block the lookups of other functions.
+    // Racing threads resolve the same symbol, it doesn't matter which one wins.
+    const QFunctionPointer symbol = SysApiLoader::resolve(library, function);
+    {
+        const QMutexLocker locker(&g_sysApiLoaderData()->mutex);
+        g_sysApiLoaderData()->functions.insert(key, symbol);
+    }
+#if FRAMELESSHELPER_CONFIG(debug_output)
+    if (isDebug()) {
+        DEBUG << Q_FUNC_INFO << "New function cache:" << key << (symbol ? "[VALID]" : "[NULL]");
+    }
 #endif
-        if (symbol) {
-            DEBUG << "Successfully loaded" << function << "from" << library;
-            return true;
-        } else {
-            WARNING << "Failed to load" << function << "from" << library;
-            return false;
-        }
+    if (symbol) {
+        DEBUG << "Successfully loaded" << function << "from" << library;
+        return true;
+    } else {
+        FlightRecorder::record(FlightRecorder::Event::SysApiFailure, 0,
+            FlightRecorder::internSymbolName(library + u'!' + function));
+        WARNING << "Failed to load" << function << "from" << library;
+        return false;
     }
 }
 
@@ -220,13 +271,15 @@ QFunctionPointer SysApiLoader::get(const QString &library, const QString &functi
         return nullptr;
     }
     const QString key = generateUniqueKey(library, function);
-    const auto it = g_sysApiLoaderData()->constFind(key);
-    if (it != g_sysApiLoaderData()->constEnd()) {
+    const QMutexLocker locker(&g_sysApiLoaderData()->mutex);
+    const auto it = g_sysApiLoaderData()->functions.constFind(key);
+    if (it != g_sysApiLoaderData()->functions.constEnd()) {
 #if FRAMELESSHELPER_CONFIG(debug_output)
         if (isDebug()) {
             DEBUG << Q_FUNC_INFO << "Function cache found:" << key;
         }
 #endif
+        Stats::increment(Stats::Counter::SysApiCacheHits);
         return it.value();
     } else {
 #if FRAMELESSHELPER_CONFIG(debug_output)
@@ -238,4 +291,56 @@ QFunctionPointer SysApiLoader::get(const QString &library, const QString &functi
     }
 }
 
+#if (!defined(Q_OS_WINDOWS) && !defined(__linux__))
+SysApiLoader::Manifest SysApiLoader::platformManifest()
+{
+    // Nothing is loaded dynamically on this platform.
+    return {};
+}
+#endif
+
+void SysApiLoader::prefetch(const Manifest &manifest)
+{
+    if (manifest.isEmpty()) {
+        return;
+    }
+    // Created on the calling thread: the prefetch thread exits right away and the
+    // instance must not be left with its thread affinity.
+    SysApiLoader * const loader = instance();
+    const QMutexLocker locker(&g_sysApiLoaderData()->mutex);
+    std::future<void> &future = g_sysApiLoaderData()->prefetch;
+    if (future.valid() && (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready)) {
+        DEBUG << "A prefetch is still running, ignoring the new manifest.";
+        return;
+    }
+    future = std::async(std::launch::async, [loader, manifest](){
+        QElapsedTimer timer = {};
+        timer.start();
+        int total = 0;
+        int failed = 0;
+        for (auto &&entry : std::as_const(manifest)) {
+            for (auto &&function : std::as_const(entry.functions)) {
+                ++total;
+                if (!loader->isAvailable(entry.library, function)) {
+                    ++failed;
+                }
+            }
+        }
+        const qint64 elapsed = timer.nsecsElapsed();
+        Stats::record(Stats::Latency::SysApiPrefetch, quint64(elapsed));
+        DEBUG << "Prefetched" << total << "symbols in" << (qreal(elapsed) / qreal(1000000)) << "ms," << failed << "of them unavailable.";
+    });
+}
+
+quintptr SysApiLoader::resolveSlot(Slot &slot, const QString &library, const QString &function)
+{
+    // Racing threads all end up here with the same library and function, the shared
+    // cache gives them the same answer so it doesn't matter which store wins.
+    SysApiLoader * const loader = instance();
+    const QFunctionPointer symbol = (loader->isAvailable(library, function) ? loader->get(library, function) : nullptr);
+    const quintptr value = (symbol ? reinterpret_cast<quintptr>(symbol) : Slot::Missing);
+    slot.value.store(value, std::memory_order_release);
+    return value;
+}
+
 FRAMELESSHELPER_END_NAMESPACE
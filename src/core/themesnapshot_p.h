@@ -0,0 +1 @@
+#include "../../include/FramelessHelper/Core/private/themesnapshot_p.h"
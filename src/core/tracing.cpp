@@ -0,0 +1,359 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021-2023 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "tracing_p.h"
+#include "framelessconfig_p.h"
+#include <QtCore/qcoreapplication.h>
+#include <QtCore/qdir.h>
+#include <QtCore/qelapsedtimer.h>
+#include <QtCore/qfile.h>
+#include <QtCore/qloggingcategory.h>
+#include <QtCore/qmutex.h>
+#include <QtCore/qthread.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+FRAMELESSHELPER_BEGIN_NAMESPACE
+
+#if FRAMELESSHELPER_CONFIG(debug_output)
+[[maybe_unused]] static Q_LOGGING_CATEGORY(lcTracing, "wangwenx190.framelesshelper.core.tracing")
+#  define INFO qCInfo(lcTracing)
+#  define DEBUG qCDebug(lcTracing)
+#  define WARNING qCWarning(lcTracing)
+#  define CRITICAL qCCritical(lcTracing)
+#else
+#  define INFO QT_NO_QDEBUG_MACRO()
+#  define DEBUG QT_NO_QDEBUG_MACRO()
+#  define WARNING QT_NO_QDEBUG_MACRO()
+#  define CRITICAL QT_NO_QDEBUG_MACRO()
+#endif
+
+using namespace Global;
+
+// 32K events per thread is enough for several minutes of normal usage, anything
+// beyond that is dropped (and counted) instead of growing the buffer.
+static constexpr const quint32 kThreadBufferCapacity = (1u << 15);
+
+// The buffers of exited threads kept for reuse, the others are freed.
+static constexpr const std::size_t kMaximumSpareBuffers = 2;
+
+// The events kept from exited threads, the oldest threads are dropped (and counted)
+// first, so that an application spawning lots of workers doesn't grow without bound.
+static constexpr const std::size_t kMaximumExitedEvents = (4 * kThreadBufferCapacity);
+
+struct TraceEvent
+{
+    const char *name = nullptr;
+    qint64 start = 0; // ns
+    qint64 duration = -1; // ns, negative for instant events
+};
+
+struct ThreadBuffer
+{
+    quint32 threadIndex = 0;
+    QByteArray threadName = {};
+    std::array<TraceEvent, kThreadBufferCapacity> events = {};
+    // Only the owning thread writes, the release store publishes the new event.
+    std::atomic<quint32> size{ 0 };
+    std::atomic<quint64> dropped{ 0 };
+};
+
+// What's left of a thread once it has exited: just the events it recorded.
+struct ExitedThread
+{
+    quint32 threadIndex = 0;
+    QByteArray threadName = {};
+    std::vector<TraceEvent> events = {};
+    quint64 dropped = 0;
+};
+
+struct TraceData
+{
+    QMutex mutex{};
+    quint32 threadCount = 0;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers = {}; // Of the running threads.
+    std::vector<std::unique_ptr<ThreadBuffer>> spareBuffers = {}; // Left behind by exited threads, for reuse.
+    std::deque<ExitedThread> exitedThreads = {};
+    std::size_t exitedEventCount = 0;
+    quint64 exitedDropped = 0; // Events of exited threads that no longer fit.
+};
+
+Q_GLOBAL_STATIC(TraceData, g_traceData)
+
+// Called on the owning thread when it exits, so nothing is appended concurrently.
+// The buffer is far too large to keep around for every short-lived worker thread:
+// its events are copied out and the buffer is either handed to the next thread
+// or freed.
+static inline void releaseThreadBuffer(ThreadBuffer * const buffer)
+{
+    Q_ASSERT(buffer);
+    if (!buffer || g_traceData.isDestroyed()) {
+        return;
+    }
+    const quint32 size = buffer->size.load(std::memory_order_relaxed);
+    ExitedThread thread = {};
+    thread.threadIndex = buffer->threadIndex;
+    thread.threadName = buffer->threadName;
+    thread.events.assign(buffer->events.cbegin(), buffer->events.cbegin() + size);
+    thread.dropped = buffer->dropped.load(std::memory_order_relaxed);
+    TraceData * const data = g_traceData();
+    const QMutexLocker locker(&data->mutex);
+    const auto it = std::find_if(data->buffers.begin(), data->buffers.end(), [buffer](const std::unique_ptr<ThreadBuffer> &item){
+        return (item.get() == buffer);
+    });
+    Q_ASSERT(it != data->buffers.end());
+    if (it == data->buffers.end()) {
+        return;
+    }
+    if (!thread.events.empty() || (thread.dropped > 0)) {
+        data->exitedEventCount += thread.events.size();
+        data->exitedThreads.push_back(std::move(thread));
+        while (data->exitedEventCount > kMaximumExitedEvents) {
+            const ExitedThread &oldest = data->exitedThreads.front();
+            data->exitedEventCount -= oldest.events.size();
+            data->exitedDropped += (oldest.events.size() + oldest.dropped);
+            data->exitedThreads.pop_front();
+        }
+    }
+    if (data->spareBuffers.size() < kMaximumSpareBuffers) {
+        data->spareBuffers.push_back(std::move(*it));
+    }
+    data->buffers.erase(it);
+}
+
+struct ThreadBufferOwner
+{
+    ThreadBuffer *buffer = nullptr;
+
+    ~ThreadBufferOwner()
+    {
+        if (buffer) {
+            releaseThreadBuffer(buffer);
+        }
+    }
+};
+
+static thread_local ThreadBufferOwner t_threadBuffer = {};
+
+[[nodiscard]] static inline const QElapsedTimer &traceClock()
+{
+    static const auto clock = []() -> QElapsedTimer {
+        QElapsedTimer timer = {};
+        timer.start();
+        return timer;
+    }();
+    return clock;
+}
+
+[[nodiscard]] static inline ThreadBuffer *threadBuffer()
+{
+    if (t_threadBuffer.buffer) {
+        return t_threadBuffer.buffer;
+    }
+    if (g_traceData.isDestroyed()) {
+        return nullptr;
+    }
+    // Only happens once per thread.
+    const QThread * const thread = QThread::currentThread();
+    const QCoreApplication * const app = QCoreApplication::instance();
+    TraceData * const data = g_traceData();
+    const QMutexLocker locker(&data->mutex);
+    std::unique_ptr<ThreadBuffer> buffer = nullptr;
+    if (data->spareBuffers.empty()) {
+        buffer = std::make_unique<ThreadBuffer>();
+    } else {
+        buffer = std::move(data->spareBuffers.back());
+        data->spareBuffers.pop_back();
+        buffer->size.store(0, std::memory_order_relaxed);
+        buffer->dropped.store(0, std::memory_order_relaxed);
+    }
+    buffer->threadIndex = ++data->threadCount;
+    if (app && (thread == app->thread())) {
+        buffer->threadName = QByteArrayLiteral("GUI");
+    } else if (thread && !thread->objectName().isEmpty()) {
+        buffer->threadName = thread->objectName().toUtf8();
+    } else {
+        buffer->threadName = QByteArrayLiteral("Thread ") + QByteArray::number(buffer->threadIndex);
+    }
+    t_threadBuffer.buffer = buffer.get();
+    data->buffers.push_back(std::move(buffer));
+    return t_threadBuffer.buffer;
+}
+
+static inline void append(const TraceEvent &event)
+{
+    ThreadBuffer * const buffer = threadBuffer();
+    if (!buffer) {
+        return;
+    }
+    const quint32 index = buffer->size.load(std::memory_order_relaxed);
+    if (index >= kThreadBufferCapacity) {
+        buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    buffer->events.at(index) = event;
+    buffer->size.store(index + 1, std::memory_order_release);
+}
+
+[[nodiscard]] static inline QByteArray escaped(const QByteArray &value)
+{
+    QByteArray result = value;
+    result.replace('\\', "\\\\");
+    result.replace('"', "\\\"");
+    return result;
+}
+
+[[nodiscard]] static inline QString defaultTraceFilePath()
+{
+    const QString path = qEnvironmentVariable(kTraceFileVar);
+    if (!path.isEmpty()) {
+        return path;
+    }
+    return QDir::temp().filePath(FRAMELESSHELPER_STRING_LITERAL("framelesshelper-trace-%1.json").arg(QCoreApplication::applicationPid()));
+}
+
+static void dumpAtExit()
+{
+    std::ignore = Trace::dump();
+}
+
+bool Trace::isEnabled()
+{
+    // The configuration belongs to the GUI thread. A worker thread getting here
+    // first must not create it, tracing is just off until it has been loaded.
+    if (!FramelessConfig::isLoaded()) {
+        const QCoreApplication * const app = QCoreApplication::instance();
+        if (!app || (QThread::currentThread() != app->thread())) {
+            return false;
+        }
+    }
+    // Re-evaluated whenever the configuration has been reloaded.
+    static ConfigDerivedFlag result;
+    return result.value([]() -> bool {
+        const bool enabled = FramelessConfig::instance()->isSet(Option::EnableTracing);
+        if (enabled) {
+            static std::once_flag once = {};
+            std::call_once(once, [](){
+                std::ignore = traceClock();
+                qAddPostRoutine(dumpAtExit);
+            });
+        }
+        return enabled;
+    });
+}
+
+qint64 Trace::now()
+{
+    return traceClock().nsecsElapsed();
+}
+
+void Trace::complete(const char *name, const qint64 start, const qint64 end)
+{
+    Q_ASSERT(name);
+    if (!name || !isEnabled()) {
+        return;
+    }
+    append(TraceEvent{ name, start, qMax(qint64(0), end - start) });
+}
+
+void Trace::instant(const char *name)
+{
+    Q_ASSERT(name);
+    if (!name || !isEnabled()) {
+        return;
+    }
+    append(TraceEvent{ name, now(), -1 });
+}
+
+bool Trace::dump(const QString &filePath)
+{
+    if (!isEnabled() || g_traceData.isDestroyed()) {
+        return false;
+    }
+    const QString path = (filePath.isEmpty() ? defaultTraceFilePath() : filePath);
+    QFile file(path);
+    if (!file.open(QFile::WriteOnly | QFile::Truncate | QFile::Text)) {
+        WARNING << "Failed to open" << path << "to write the trace:" << file.errorString();
+        return false;
+    }
+    const QByteArray pid = QByteArray::number(QCoreApplication::applicationPid());
+    QByteArray json = QByteArrayLiteral("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    bool first = true;
+    const auto separator = [&json, &first](){
+        if (!first) {
+            json.append(",\n");
+        }
+        first = false;
+    };
+    const auto appendThread = [&json, &separator, &pid](const quint32 threadIndex, const QByteArray &threadName,
+                                                        const TraceEvent *events, const quint32 size){
+        const QByteArray tid = QByteArray::number(threadIndex);
+        separator();
+        json.append("{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":" + pid + ",\"tid\":" + tid
+            + ",\"args\":{\"name\":\"" + escaped(threadName) + "\"}}");
+        for (quint32 i = 0; i != size; ++i) {
+            const TraceEvent &event = events[i];
+            separator();
+            // The trace-event format uses microseconds.
+            json.append("{\"cat\":\"framelesshelper\",\"name\":\"" + escaped(QByteArray(event.name))
+                + "\",\"pid\":" + pid + ",\"tid\":" + tid + ",\"ts\":" + QByteArray::number(qreal(event.start) / qreal(1000), 'f', 3));
+            if (event.duration < 0) {
+                json.append(",\"ph\":\"i\",\"s\":\"t\"}");
+            } else {
+                json.append(",\"ph\":\"X\",\"dur\":" + QByteArray::number(qreal(event.duration) / qreal(1000), 'f', 3) + '}');
+            }
+        }
+    };
+    const QMutexLocker locker(&g_traceData()->mutex);
+    quint64 dropped = g_traceData()->exitedDropped;
+    for (auto &&thread : std::as_const(g_traceData()->exitedThreads)) {
+        appendThread(thread.threadIndex, thread.threadName, thread.events.data(), quint32(thread.events.size()));
+        dropped += thread.dropped;
+    }
+    for (auto &&buffer : std::as_const(g_traceData()->buffers)) {
+        // Events appended after this point simply won't be part of this dump.
+        appendThread(buffer->threadIndex, buffer->threadName, buffer->events.data(), buffer->size.load(std::memory_order_acquire));
+        dropped += buffer->dropped.load(std::memory_order_relaxed);
+    }
+    json.append("]}\n");
+    if (file.write(json) != json.size()) {
+        WARNING << "Failed to write the trace to" << path << ':' << file.errorString();
+        return false;
+    }
+    INFO << "Trace written to" << path << ", dropped events:" << dropped;
+    return true;
+}
+
+bool FramelessHelperDumpTrace(const QString &filePath)
+{
+    return Trace::dump(filePath);
+}
+
+FRAMELESSHELPER_END_NAMESPACE
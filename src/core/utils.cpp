@@ -23,7 +23,10 @@
  */
 
 #include "utils.h"
+#include "framelessmanager.h"
+#include "framelessmanager_p.h"
 #include "framelesshelpercore_global_p.h"
+#include "hittest_p.h"
 #ifdef Q_OS_WINDOWS
 #  include "winverhelper_p.h"
 #endif // Q_OS_WINDOWS
@@ -101,6 +104,23 @@ static constexpr const std::array<FONT_ICON, static_cast<int>(SystemButtonType::
 }
 #endif // !FRAMELESSHELPER_CONFIG(private_qt)
 
+[[nodiscard]] static inline HitTestResult hitTestWindow(const QWindow *window, const QPoint &pos)
+{
+    Q_ASSERT(window);
+    if (!window) {
+        return HitTestResult::Client;
+    }
+    // No per-window settings are known here, the defaults apply. A DPR of 1 keeps
+    // the bands in the same (logical) coordinate space as the point.
+    ResizeBorderBands bands = {};
+    bands.update({}, window->size(), 1);
+    HitTestSnapshot snapshot = {};
+    snapshot.resizeBorder = &bands;
+    // Only a normal window can be resized.
+    snapshot.maximized = (window->visibility() != QWindow::Windowed);
+    return HitTest::evaluate(snapshot, pos);
+}
+
 Qt::CursorShape Utils::calculateCursorShape(const QWindow *window, const QPoint &pos)
 {
 #ifdef Q_OS_MACOS
@@ -112,28 +132,7 @@ Qt::CursorShape Utils::calculateCursorShape(const QWindow *window, const QPoint
     if (!window) {
         return Qt::ArrowCursor;
     }
-    if (window->visibility() != QWindow::Windowed) {
-        return Qt::ArrowCursor;
-    }
-    const int x = pos.x();
-    const int y = pos.y();
-    const int w = window->width();
-    const int h = window->height();
-    if (((x < kDefaultResizeBorderThickness) && (y < kDefaultResizeBorderThickness))
-        || ((x >= (w - kDefaultResizeBorderThickness)) && (y >= (h - kDefaultResizeBorderThickness)))) {
-        return Qt::SizeFDiagCursor;
-    }
-    if (((x >= (w - kDefaultResizeBorderThickness)) && (y < kDefaultResizeBorderThickness))
-        || ((x < kDefaultResizeBorderThickness) && (y >= (h - kDefaultResizeBorderThickness)))) {
-        return Qt::SizeBDiagCursor;
-    }
-    if ((x < kDefaultResizeBorderThickness) || (x >= (w - kDefaultResizeBorderThickness))) {
-        return Qt::SizeHorCursor;
-    }
-    if ((y < kDefaultResizeBorderThickness) || (y >= (h - kDefaultResizeBorderThickness))) {
-        return Qt::SizeVerCursor;
-    }
-    return Qt::ArrowCursor;
+    return HitTest::toCursorShape(hitTestWindow(window, pos));
 #endif
 }
 
@@ -148,25 +147,7 @@ Qt::Edges Utils::calculateWindowEdges(const QWindow *window, const QPoint &pos)
     if (!window) {
         return {};
     }
-    if (window->visibility() != QWindow::Windowed) {
-        return {};
-    }
-    Qt::Edges edges = {};
-    const int x = pos.x();
-    const int y = pos.y();
-    if (x < kDefaultResizeBorderThickness) {
-        edges |= Qt::LeftEdge;
-    }
-    if (x >= (window->width() - kDefaultResizeBorderThickness)) {
-        edges |= Qt::RightEdge;
-    }
-    if (y < kDefaultResizeBorderThickness) {
-        edges |= Qt::TopEdge;
-    }
-    if (y >= (window->height() - kDefaultResizeBorderThickness)) {
-        edges |= Qt::BottomEdge;
-    }
-    return edges;
+    return HitTest::toWindowEdges(hitTestWindow(window, pos));
 #endif
 }
 
@@ -265,28 +246,8 @@ bool Utils::isThemeChangeEvent(const QEvent * const event)
 
 QColor Utils::calculateSystemButtonBackgroundColor(const SystemButtonType button, const ButtonState state)
 {
-    if (state == ButtonState::Normal) {
-        return kDefaultTransparentColor;
-    }
-    const bool isClose = (button == SystemButtonType::Close);
-    const bool isTitleColor = isTitleBarColorized();
-    const bool isHovered = (state == ButtonState::Hovered);
-    const auto result = [isClose, isTitleColor]() -> QColor {
-        if (isClose) {
-            return kDefaultSystemCloseButtonBackgroundColor;
-        }
-        if (isTitleColor) {
-            return getAccentColor();
-        }
-        return kDefaultSystemButtonBackgroundColor;
-    }();
-    if (isClose) {
-        return (isHovered ? result.lighter(110) : result.lighter(140));
-    }
-    if (!isTitleColor) {
-        return (isHovered ? result.lighter(110) : result);
-    }
-    return (isHovered ? result.lighter(150) : result.lighter(120));
+    // Computed once per theme change, see FramelessManagerPrivate::themeSnapshot().
+    return FramelessManagerPrivate::currentThemeSnapshot()->systemButtonBackgroundColor(button, state);
 }
 
 bool Utils::shouldAppsUseDarkMode()
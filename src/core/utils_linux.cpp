@@ -29,13 +29,24 @@
 #include "framelessconfig_p.h"
 #include "framelessmanager.h"
 #include "framelessmanager_p.h"
-#include <cstring> // for std::memcpy
+#include "linuxtheme_p.h"
+#include "linuxwallpaper_p.h"
+#include "tracing_p.h"
+#include "x11backend_p.h"
+#include "x11capabilities_p.h"
+#include "x11requestbatcher_p.h"
+#include <cmath>
+#include <cstring> // for memset
+#include <optional>
+#include <vector>
 #include <QtCore/qloggingcategory.h>
+#include <QtCore/qpointer.h>
 #include <QtGui/qevent.h>
 #include <QtGui/qwindow.h>
 #include <QtGui/qscreen.h>
 #include <QtGui/qpalette.h>
 #include <QtGui/qguiapplication.h>
+#include <QtGui/qregion.h>
 #if FRAMELESSHELPER_CONFIG(private_qt)
 #  include <QtGui/qpa/qplatformnativeinterface.h>
 #  include <QtGui/qpa/qplatformwindow.h>
@@ -84,8 +95,20 @@ FRAMELESSHELPER_BYTEARRAY_CONSTANT(startupid)
 FRAMELESSHELPER_BYTEARRAY_CONSTANT(display)
 FRAMELESSHELPER_BYTEARRAY_CONSTANT(connection)
 
-static constexpr const auto _XCB_SEND_EVENT_MASK =
-    (XCB_EVENT_MASK_SUBSTRUCTURE_REDIRECT | XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY);
+struct BlurRegionData
+{
+    QPointer<QWindow> window = nullptr;
+    QRegion region = {}; // In logical pixels.
+    quint32 radius = 0;
+    // The property data sent last time, in device pixels. Resizing a window often
+    // doesn't change the clipped region at all, so there's nothing to send then.
+    std::optional<std::vector<quint32>> lastData = std::nullopt;
+    QList<QMetaObject::Connection> connections = {};
+};
+
+using BlurRegionHash = QHash<WId, BlurRegionData>;
+
+Q_GLOBAL_STATIC(BlurRegionHash, g_blurRegions)
 
 extern template bool gtkSettings<bool>(const gchar *);
 extern QString gtkSettings(const gchar *);
@@ -143,6 +166,27 @@ extern QString gtkSettings(const gchar *);
     QGuiApplication::sendEvent(window, event.get());
 }
 
+bool Utils::isXcbPlatform()
+{
+    // The platform plugin is only known once the application object exists,
+    // and it can't change afterwards.
+    if (!qGuiApp) {
+        return false;
+    }
+    static const bool result = (QGuiApplication::platformName() == FRAMELESSHELPER_STRING("xcb"));
+    return result;
+}
+
+bool Utils::isWaylandPlatform()
+{
+    if (!qGuiApp) {
+        return false;
+    }
+    // Also matches "wayland-egl" and friends.
+    static const bool result = QGuiApplication::platformName().startsWith(FRAMELESSHELPER_STRING("wayland"));
+    return result;
+}
+
 QScreen *Utils::x11_findScreenForVirtualDesktop(const int virtualDesktopNumber)
 {
 #if FRAMELESSHELPER_CONFIG(private_qt)
@@ -311,6 +355,9 @@ QByteArray Utils::x11_nextStartupId()
 
 Display *Utils::x11_display()
 {
+    if (!isXcbPlatform()) {
+        return nullptr;
+    }
 #ifdef FRAMELESSHELPER_HAS_X11EXTRAS
     return QX11Info::display();
 #else // !FRAMELESSHELPER_HAS_X11EXTRAS
@@ -340,6 +387,9 @@ Display *Utils::x11_display()
 
 xcb_connection_t *Utils::x11_connection()
 {
+    if (!isXcbPlatform()) {
+        return nullptr;
+    }
 #ifdef FRAMELESSHELPER_HAS_X11EXTRAS
     return QX11Info::connection();
 #else // !FRAMELESSHELPER_HAS_X11EXTRAS
@@ -369,6 +419,7 @@ xcb_connection_t *Utils::x11_connection()
 
 bool Utils::startSystemMove(QWindow *window, const QPoint &globalPos)
 {
+    const Trace::Span span("Utils::startSystemMove");
     Q_ASSERT(window);
     if (!window) {
         return false;
@@ -378,6 +429,9 @@ bool Utils::startSystemMove(QWindow *window, const QPoint &globalPos)
     generateMouseReleaseEvent(window, globalPos);
     return true;
 #else // (QT_VERSION < QT_VERSION_CHECK(5, 15, 0))
+    if (!isXcbPlatform()) {
+        return false;
+    }
     const QPoint nativeGlobalPos = Utils::toNativeGlobalPosition(window, globalPos);
     sendMoveResizeMessage(window->winId(), _NET_WM_MOVERESIZE_MOVE, nativeGlobalPos);
     return true;
@@ -386,6 +440,7 @@ bool Utils::startSystemMove(QWindow *window, const QPoint &globalPos)
 
 bool Utils::startSystemResize(QWindow *window, const Qt::Edges edges, const QPoint &globalPos)
 {
+    const Trace::Span span("Utils::startSystemResize");
     Q_ASSERT(window);
     if (!window) {
         return false;
@@ -398,6 +453,9 @@ bool Utils::startSystemResize(QWindow *window, const Qt::Edges edges, const QPoi
     generateMouseReleaseEvent(window, globalPos);
     return true;
 #else // (QT_VERSION < QT_VERSION_CHECK(5, 15, 0))
+    if (!isXcbPlatform()) {
+        return false;
+    }
     const QPoint nativeGlobalPos = Utils::toNativeGlobalPosition(window, globalPos);
     const int netWmOperation = qtEdgesToWmMoveOrResizeOperation(edges);
     sendMoveResizeMessage(window->winId(), netWmOperation, nativeGlobalPos);
@@ -407,34 +465,29 @@ bool Utils::startSystemResize(QWindow *window, const Qt::Edges edges, const QPoi
 
 bool Utils::isTitleBarColorized()
 {
-    // ### TODO
-    return false;
+    return LinuxTheme::current().titleBarColorized.value_or(false);
 }
 
 QColor Utils::getAccentColor_linux()
 {
-    // ### TODO
+    if (const std::optional<QColor> accentColor = LinuxTheme::current().accentColor) {
+        return accentColor.value();
+    }
     return QGuiApplication::palette().color(QPalette::Highlight);
 }
 
 bool Utils::shouldAppsUseDarkMode_linux()
 {
     /*
-        https://docs.gtk.org/gtk3/running.html
-
-        It's possible to set a theme variant after the theme name when using GTK_THEME:
-
-            GTK_THEME=Adwaita:dark
-
-        Some themes also have "-dark" as part of their name.
-
-        We test this environment variable first because the documentation says
-        it's mainly used for easy debugging, so it should be possible to use it
-        to override any other settings.
+        GTK_THEME, the settings portal and the GTK/KDE settings files, see
+        linuxtheme.cpp. None of them needs GTK to be loaded.
     */
-    const QString envThemeName = qEnvironmentVariable(GTK_THEME_NAME_ENV_VAR);
-    if (!envThemeName.isEmpty()) {
-        return envThemeName.contains(kdark, Qt::CaseInsensitive);
+    if (const std::optional<bool> dark = LinuxTheme::current().dark) {
+        return dark.value();
+    }
+
+    if (!FramelessConfig::snapshot().isSet(Option::UseGtkThemeDetection)) {
+        return false;
     }
 
     /*
@@ -460,6 +513,86 @@ bool Utils::shouldAppsUseDarkMode_linux()
     return false;
 }
 
+static inline void forgetBlurRegion(const WId windowId)
+{
+    const auto it = g_blurRegions()->find(windowId);
+    if (it == g_blurRegions()->end()) {
+        return;
+    }
+    for (auto &&connection : std::as_const(it->connections)) {
+        QObject::disconnect(connection);
+    }
+    g_blurRegions()->erase(it);
+}
+
+// The KDE atom if KWin's blur effect is loaded, the Deepin atom if the Deepin window
+// manager is running, XCB_NONE otherwise.
+[[nodiscard]] static inline std::pair<xcb_atom_t, xcb_atom_t> blurRegionAtoms()
+{
+    static const xcb_atom_t kdeAtom = Utils::internAtom(ATOM_KDE_NET_WM_BLUR_BEHIND_REGION);
+    static const xcb_atom_t deepinAtom = Utils::internAtom(ATOM_NET_WM_DEEPIN_BLUR_REGION_ROUNDED);
+    return std::make_pair(
+        (((kdeAtom != XCB_NONE) && Utils::isSupportedByRootWindow(kdeAtom)) ? kdeAtom : XCB_NONE),
+        (((deepinAtom != XCB_NONE) && Utils::isSupportedByWindowManager(deepinAtom)) ? deepinAtom : XCB_NONE));
+}
+
+// KDE wants a list of (x, y, width, height), Deepin a list of (x, y, width, height,
+// x radius, y radius), all in device pixels.
+[[nodiscard]] static inline std::vector<quint32> blurRegionData(const QWindow *window,
+    const QRegion &region, const quint32 radius, const bool rounded)
+{
+    Q_ASSERT(window);
+    if (!window) {
+        return {};
+    }
+    const qreal dpr = window->devicePixelRatio();
+    const QRegion clipped = region.intersected(QRect(QPoint(0, 0), window->size()));
+    const auto deviceRadius = quint32(std::round(qreal(radius) * dpr));
+    // Must be contiguous, it's handed to xcb as is.
+    std::vector<quint32> data = {};
+    data.reserve(clipped.rectCount() * (rounded ? 6 : 4));
+    for (auto &&rect : clipped) {
+        const QRect deviceRect = QRectF(QPointF(rect.topLeft()) * dpr, QSizeF(rect.size()) * dpr).toAlignedRect();
+        data.insert(data.end(), {quint32(deviceRect.x()), quint32(deviceRect.y()),
+            quint32(deviceRect.width()), quint32(deviceRect.height())});
+        if (rounded) {
+            data.insert(data.end(), {deviceRadius, deviceRadius});
+        }
+    }
+    return data;
+}
+
+[[nodiscard]] static inline bool applyBlurRegion(const WId windowId, BlurRegionData &blur)
+{
+    Q_ASSERT(windowId);
+    if (!windowId) {
+        return false;
+    }
+    const auto [kdeAtom, deepinAtom] = blurRegionAtoms();
+    // Deepin's window manager is based on KWin, prefer its own protocol when both exist.
+    const xcb_atom_t atom = ((deepinAtom != XCB_NONE) ? deepinAtom : kdeAtom);
+    if (atom == XCB_NONE) {
+        return false;
+    }
+    std::vector<quint32> data = blurRegionData(blur.window, blur.region, blur.radius, (atom == deepinAtom));
+    if (blur.lastData == data) {
+        return true;
+    }
+    const xcb_atom_t otherAtom = ((atom == deepinAtom) ? kdeAtom : deepinAtom);
+    if (otherAtom != XCB_NONE) {
+        Utils::clearWindowProperty(windowId, otherAtom);
+    }
+    if (data.empty()) {
+        // An empty list means "the whole window" to KWin, which is the opposite of
+        // what a region that lies completely outside of the window should do.
+        Utils::clearWindowProperty(windowId, atom);
+    } else {
+        Utils::setWindowProperty(windowId, atom, XCB_ATOM_CARDINAL, data.data(), quint32(data.size()), sizeof(quint32) * 8);
+    }
+    blur.lastData = std::move(data);
+    return true;
+}
+
 bool Utils::setBlurBehindWindowEnabled(const WId windowId, const BlurMode mode, const QColor &color)
 {
     Q_UNUSED(color);
@@ -467,6 +600,12 @@ bool Utils::setBlurBehindWindowEnabled(const WId windowId, const BlurMode mode,
     if (!windowId) {
         return false;
     }
+    // Only the xcb platform has a backend, unless a recording one has been installed.
+    if (!X11::backend()) {
+        // The blur protocols of KWin and friends are not exposed by QtWaylandClient.
+        WARNING << "Blur behind window is only supported on the xcb platform.";
+        return false;
+    }
     static const xcb_atom_t atom = internAtom(ATOM_KDE_NET_WM_BLUR_BEHIND_REGION);
     if ((atom == XCB_NONE) || !isSupportedByRootWindow(atom)) {
         WARNING << "Current window manager doesn't support blur behind window.";
@@ -483,8 +622,13 @@ bool Utils::setBlurBehindWindowEnabled(const WId windowId, const BlurMode mode,
         WARNING << "The BlurMode::Windows_* enum values are not supported on Linux.";
         return BlurMode::Default;
     }();
+    // Whole window blur replaces any region set before.
+    forgetBlurRegion(windowId);
     if (blurMode == BlurMode::Disable) {
         clearWindowProperty(windowId, atom);
+        if (const xcb_atom_t deepinRegionAtom = blurRegionAtoms().second; deepinRegionAtom != XCB_NONE) {
+            clearWindowProperty(windowId, deepinRegionAtom);
+        }
     } else {
         const quint32 value = true;
         setWindowProperty(windowId, atom, XCB_ATOM_CARDINAL, &value, 1, sizeof(quint32) * 8);
@@ -492,65 +636,87 @@ bool Utils::setBlurBehindWindowEnabled(const WId windowId, const BlurMode mode,
     return true;
 }
 
-QString Utils::getWallpaperFilePath()
+bool Utils::setBlurBehindWindowRegion(QWindow *window, const QRegion &region, const quint32 radius)
 {
-#if 0
-    GConfClient * const client = gconf_client_get_default();
-    Q_ASSERT(client);
-    if (!client) {
-        return {};
+    Q_ASSERT(window);
+    if (!window) {
+        return false;
+    }
+    if (!X11::backend()) {
+        WARNING << "Blur behind window is only supported on the xcb platform.";
+        return false;
+    }
+    const WId windowId = window->winId();
+    Q_ASSERT(windowId);
+    if (!windowId) {
+        return false;
     }
-    const gchararray rawPath = gconf_client_get_string(client, "/desktop/gnome/background/picture_filename", nullptr);
-    if (!rawPath || (*rawPath == '\0')) {
+    if (region.isEmpty()) {
+        forgetBlurRegion(windowId);
+        const auto [kde, deepin] = blurRegionAtoms();
+        if (kde != XCB_NONE) {
+            clearWindowProperty(windowId, kde);
+        }
+        if (deepin != XCB_NONE) {
+            clearWindowProperty(windowId, deepin);
+        }
+        return true;
+    }
+    BlurRegionData &blur = (*g_blurRegions())[windowId];
+    blur.window = window;
+    blur.region = region;
+    blur.radius = radius;
+    if (blur.connections.isEmpty()) {
+        const auto update = [windowId](){
+            const auto it = g_blurRegions()->find(windowId);
+            if ((it == g_blurRegions()->end()) || !it->window) {
+                return;
+            }
+            std::ignore = applyBlurRegion(windowId, *it);
+        };
+        // Both signals fire for a diagonal resize, but the second one usually finds
+        // nothing new to send, and the writes are merged by the X11 request batcher anyway.
+        blur.connections.append(QObject::connect(window, &QWindow::widthChanged, window, update));
+        blur.connections.append(QObject::connect(window, &QWindow::heightChanged, window, update));
+        blur.connections.append(QObject::connect(window, &QWindow::screenChanged, window, update));
+        blur.connections.append(QObject::connect(window, &QObject::destroyed, [windowId](){
+            g_blurRegions()->remove(windowId);
+        }));
+    }
+    if (!applyBlurRegion(windowId, blur)) {
+        WARNING << "Current window manager doesn't support blur behind window.";
+        forgetBlurRegion(windowId);
+        return false;
+    }
+    return true;
+}
+
+QString Utils::getWallpaperFilePath()
+{
+    // Parsed from the desktop's own configuration files, see linuxwallpaper.cpp.
+    const LinuxWallpaper::Wallpaper wallpaper = LinuxWallpaper::current();
+    if (!wallpaper.valid) {
         WARNING << "Failed to retrieve the wallpaper file path.";
         return {};
     }
-    return QUtf8String(rawPath);
-#else
-    // ### TODO
-    return {};
-#endif
+    return wallpaper.filePath;
 }
 
 WallpaperAspectStyle Utils::getWallpaperAspectStyle()
 {
-#if 0
-    static constexpr const auto defaultAspectStyle = WallpaperAspectStyle::Fill;
-    GConfClient * const client = gconf_client_get_default();
-    Q_ASSERT(client);
-    if (!client) {
-        return defaultAspectStyle;
-    }
-    const gchararray rawOptions = gconf_client_get_string(client, "/desktop/gnome/background/picture_options", nullptr);
-    if (!rawOptions || (*rawOptions == '\0')) {
-        WARNING << "Failed to retrieve the wallpaper tile options.";
-        return defaultAspectStyle;
-    }
-    const QString options = QUtf8String(rawOptions);
-    if (options.isEmpty()) {
-        return defaultAspectStyle;
-    } else {
-        if ((options == u"wallpaper"_s) || (options == u"tiled"_s)) {
-            return WallpaperAspectStyle::Tile;
-        } else if (options == u"centered"_s) {
-            return WallpaperAspectStyle::Center;
-        } else if (options == u"stretched"_s) {
-            return WallpaperAspectStyle::Stretch;
-        } else if (options == u"scaled"_s) {
-            return WallpaperAspectStyle::Fit;
-        } else {
-            return defaultAspectStyle;
-        }
-    }
-#else
-    // ### TODO
-    return WallpaperAspectStyle::Fill;
-#endif
+    const LinuxWallpaper::Wallpaper wallpaper = LinuxWallpaper::current();
+    return (wallpaper.valid ? wallpaper.aspectStyle : WallpaperAspectStyle::Fill);
 }
 
 bool Utils::isBlurBehindWindowSupported()
 {
-    static const auto result = []() -> bool {
+    // Re-evaluated whenever the configuration has been reloaded.
+    static ConfigDerivedFlag result;
+    return result.value([]() -> bool {
+        if (!isXcbPlatform()) {
+            // Nothing to blur with natively, see setBlurBehindWindowEnabled().
+            return false;
+        }
         if (FramelessConfig::instance()->isSet(Option::ForceNativeBackgroundBlur)) {
             return true;
         }
@@ -571,8 +737,7 @@ bool Utils::isBlurBehindWindowSupported()
         }
 #endif
         return false;
-    }();
-    return result;
+    });
 }
 
 static inline void themeChangeNotificationCallback()
@@ -587,6 +752,10 @@ static inline void themeChangeNotificationCallback()
 
 bool Utils::registerThemeChangeNotification()
 {
+    if (!FramelessConfig::snapshot().isSet(Option::UseGtkThemeDetection)) {
+        // FramelessManager watches the settings files and the settings portal instead.
+        return true;
+    }
     GtkSettings * const settings = gtk_settings_get_default();
     Q_ASSERT(settings);
     if (!settings) {
@@ -609,82 +778,20 @@ xcb_atom_t Utils::internAtom(const char *name)
     if (!name || (*name == '\0')) {
         return XCB_NONE;
     }
-    xcb_connection_t * const connection = x11_connection();
-    Q_ASSERT(connection);
-    if (!connection) {
+    X11::Backend * const backend = X11::backend();
+    if (!backend) {
         return XCB_NONE;
     }
-    const xcb_intern_atom_cookie_t cookie = xcb_intern_atom(connection, false, qstrlen(name), name);
-    xcb_intern_atom_reply_t * const reply = xcb_intern_atom_reply(connection, cookie, nullptr);
-    if (!reply) {
-        return XCB_NONE;
+    // The atoms we know about have all been interned by the capability probe already.
+    if (const xcb_atom_t atom = X11::knownAtom(name); atom != XCB_NONE) {
+        return atom;
     }
-    const xcb_atom_t atom = reply->atom;
-    std::free(reply);
-    return atom;
+    return backend->internAtom(name);
 }
 
 QString Utils::getWindowManagerName()
 {
-    static const auto result = []() -> QString {
-        xcb_connection_t * const connection = x11_connection();
-        Q_ASSERT(connection);
-        if (!connection) {
-            return {};
-        }
-        const quint32 rootWindow = x11_appRootWindow(x11_appScreen());
-        Q_ASSERT(rootWindow);
-        if (!rootWindow) {
-            return {};
-        }
-        static const xcb_atom_t wmCheckAtom = internAtom(ATOM_NET_SUPPORTING_WM_CHECK);
-        if (wmCheckAtom == XCB_NONE) {
-            WARNING << "Failed to retrieve the atom of _NET_SUPPORTING_WM_CHECK.";
-            return {};
-        }
-        const xcb_get_property_cookie_t cookie = xcb_get_property_unchecked(connection, false, rootWindow, wmCheckAtom, XCB_ATOM_WINDOW, 0, 1024);
-        xcb_get_property_reply_t * const reply = xcb_get_property_reply(connection, cookie, nullptr);
-        if (!reply) {
-            return {};
-        }
-        if (!((reply->format == 32) && (reply->type == XCB_ATOM_WINDOW))) {
-            std::free(reply);
-            return {};
-        }
-        const auto windowManager = *static_cast<xcb_window_t *>(xcb_get_property_value(reply));
-        if (windowManager == XCB_WINDOW_NONE) {
-            std::free(reply);
-            return {};
-        }
-        static const xcb_atom_t wmNameAtom = internAtom(ATOM_NET_WM_NAME);
-        if (wmNameAtom == XCB_NONE) {
-            WARNING << "Failed to retrieve the atom of _NET_WM_NAME.";
-            return {};
-        }
-        static const xcb_atom_t strAtom = internAtom(ATOM_UTF8_STRING);
-        if (strAtom == XCB_NONE) {
-            WARNING << "Failed to retrieve the atom of UTF8_STRING.";
-            return {};
-        }
-        const xcb_get_property_cookie_t wmCookie = xcb_get_property_unchecked(connection, false, windowManager, wmNameAtom, strAtom, 0, 1024);
-        xcb_get_property_reply_t * const wmReply = xcb_get_property_reply(connection, wmCookie, nullptr);
-        if (!wmReply) {
-            std::free(reply);
-            return {};
-        }
-        if (!((wmReply->format == 8) && (wmReply->type == strAtom))) {
-            std::free(wmReply);
-            std::free(reply);
-            return {};
-        }
-        const auto data = static_cast<const char *>(xcb_get_property_value(wmReply));
-        const int len = xcb_get_property_value_length(wmReply);
-        const QString wmName = QString::fromUtf8(data, len);
-        std::free(wmReply);
-        std::free(reply);
-        return wmName;
-    }();
-    return result;
+    return X11::capabilities()->windowManagerName;
 }
 
 void Utils::openSystemMenu(const WId windowId, const QPoint &globalPos)
@@ -694,13 +801,14 @@ void Utils::openSystemMenu(const WId windowId, const QPoint &globalPos)
         return;
     }
 
-    xcb_connection_t * const connection = x11_connection();
-    Q_ASSERT(connection);
-    if (!connection) {
+    X11::Backend * const backend = X11::backend();
+    if (!backend) {
+        // The window menu of xdg-shell needs the private QtWaylandClient APIs.
+        DEBUG << "Showing the window menu is only supported on the xcb platform.";
         return;
     }
 
-    const quint32 rootWindow = x11_appRootWindow(x11_appScreen());
+    const xcb_window_t rootWindow = backend->rootWindow();
     Q_ASSERT(rootWindow);
     if (!rootWindow) {
         return;
@@ -721,9 +829,13 @@ void Utils::openSystemMenu(const WId windowId, const QPoint &globalPos)
     xev.data.data32[1] = globalPos.x();
     xev.data.data32[2] = globalPos.y();
 
-    xcb_ungrab_pointer(connection, XCB_CURRENT_TIME);
-    xcb_send_event(connection, false, rootWindow, _XCB_SEND_EVENT_MASK, reinterpret_cast<const char *>(&xev));
-    xcb_flush(connection);
+    // Keep the queued property writes ahead of the message, the window manager
+    // must see the window as the application last left it.
+    X11::submitPendingRequests();
+    backend->ungrabPointer();
+    backend->sendClientMessage(rootWindow, xev);
+    // The user is waiting for this, don't wait for the end of the event loop iteration.
+    X11::flushNow();
 }
 
 QByteArray Utils::getWindowProperty(const WId windowId, const xcb_atom_t prop, const xcb_atom_t type, const quint32 data_len)
@@ -734,22 +846,14 @@ QByteArray Utils::getWindowProperty(const WId windowId, const xcb_atom_t prop, c
     if (!windowId || (prop == XCB_NONE) || (type == XCB_NONE)) {
         return {};
     }
-    xcb_connection_t * const connection = x11_connection();
-    Q_ASSERT(connection);
-    if (!connection) {
+    X11::Backend * const backend = X11::backend();
+    if (!backend) {
         return {};
     }
-    const xcb_get_property_cookie_t cookie = xcb_get_property(connection, false, windowId, prop, type, 0, data_len);
-    xcb_get_property_reply_t * const reply = xcb_get_property_reply(connection, cookie, nullptr);
-    if (!reply) {
-        return {};
-    }
-    QByteArray data = {};
-    const int len = xcb_get_property_value_length(reply);
-    const auto buf = static_cast<const char *>(xcb_get_property_value(reply));
-    data.append(buf, len);
-    std::free(reply);
-    return data;
+    // Requests are processed in order, so the reply will reflect our own queued writes.
+    X11::submitPendingRequests();
+    // Has to copy, X11::Backend::getProperty() gives access to the reply itself.
+    return backend->getProperty(windowId, prop, type, data_len).toByteArray();
 }
 
 void Utils::setWindowProperty(const WId windowId, const xcb_atom_t prop, const xcb_atom_t type, const void *data, const quint32 data_len, const uint8_t format)
@@ -760,13 +864,11 @@ void Utils::setWindowProperty(const WId windowId, const xcb_atom_t prop, const x
     if (!windowId || (prop == XCB_NONE) || (type == XCB_NONE)) {
         return;
     }
-    xcb_connection_t * const connection = x11_connection();
-    Q_ASSERT(connection);
-    if (!connection) {
+    if (!X11::backend()) {
         return;
     }
-    xcb_change_property(connection, XCB_PROP_MODE_REPLACE, windowId, prop, type, format, data_len, data);
-    xcb_flush(connection);
+    // Sent together with everything else changed during this event loop iteration.
+    X11::queuePropertyChange(windowId, prop, type, format, data, data_len);
 }
 
 void Utils::clearWindowProperty(const WId windowId, const xcb_atom_t prop)
@@ -776,12 +878,10 @@ void Utils::clearWindowProperty(const WId windowId, const xcb_atom_t prop)
     if (!windowId || (prop == XCB_NONE)) {
         return;
     }
-    xcb_connection_t * const connection = x11_connection();
-    Q_ASSERT(connection);
-    if (!connection) {
+    if (!X11::backend()) {
         return;
     }
-    xcb_delete_property_checked(connection, windowId, prop);
+    X11::queuePropertyDeletion(windowId, prop);
 }
 
 bool Utils::isSupportedByWindowManager(const xcb_atom_t atom)
@@ -790,51 +890,7 @@ bool Utils::isSupportedByWindowManager(const xcb_atom_t atom)
     if (atom == XCB_NONE) {
         return false;
     }
-#if (QT_VERSION >= QT_VERSION_CHECK(6, 0, 0))
-    using result_type = QList<xcb_atom_t>;
-#else // (QT_VERSION < QT_VERSION_CHECK(6, 0, 0))
-    using result_type = QVector<xcb_atom_t>;
-#endif // (QT_VERSION >= QT_VERSION_CHECK(6, 0, 0))
-    static const auto netWmAtoms = []() -> result_type {
-        xcb_connection_t * const connection = x11_connection();
-        Q_ASSERT(connection);
-        if (!connection) {
-            return {};
-        }
-        const quint32 rootWindow = x11_appRootWindow(x11_appScreen());
-        Q_ASSERT(rootWindow);
-        if (!rootWindow) {
-            return {};
-        }
-        static const xcb_atom_t netSupportedAtom = internAtom(ATOM_NET_SUPPORTED);
-        if (netSupportedAtom == XCB_NONE) {
-            WARNING << "Failed to retrieve the atom of _NET_SUPPORTED.";
-            return {};
-        }
-        result_type result = {};
-        int offset = 0;
-        int remaining = 0;
-        do {
-            const xcb_get_property_cookie_t cookie = xcb_get_property(connection, false, rootWindow, netSupportedAtom, XCB_ATOM_ATOM, offset, 1024);
-            xcb_get_property_reply_t * const reply = xcb_get_property_reply(connection, cookie, nullptr);
-            if (!reply) {
-                break;
-            }
-            remaining = 0;
-            if ((reply->type == XCB_ATOM_ATOM) && (reply->format == 32)) {
-                const int len = (xcb_get_property_value_length(reply) / sizeof(xcb_atom_t));
-                const auto atoms = static_cast<xcb_atom_t *>(xcb_get_property_value(reply));
-                const int size = result.size();
-                result.resize(size + len);
-                std::memcpy(result.data() + size, atoms, len * sizeof(xcb_atom_t));
-                remaining = reply->bytes_after;
-                offset += len;
-            }
-            std::free(reply);
-        } while (remaining > 0);
-        return result;
-    }();
-    return netWmAtoms.contains(atom);
+    return X11::capabilities()->isSupportedByWindowManager(atom);
 }
 
 bool Utils::isSupportedByRootWindow(const xcb_atom_t atom)
@@ -843,36 +899,7 @@ bool Utils::isSupportedByRootWindow(const xcb_atom_t atom)
     if (atom == XCB_NONE) {
         return false;
     }
-#if (QT_VERSION >= QT_VERSION_CHECK(6, 0, 0))
-    using result_type = QList<xcb_atom_t>;
-#else // (QT_VERSION < QT_VERSION_CHECK(6, 0, 0))
-    using result_type = QVector<xcb_atom_t>;
-#endif // (QT_VERSION >= QT_VERSION_CHECK(6, 0, 0))
-    static const auto rootWindowProperties = []() -> result_type {
-        xcb_connection_t * const connection = x11_connection();
-        Q_ASSERT(connection);
-        if (!connection) {
-            return {};
-        }
-        const quint32 rootWindow = x11_appRootWindow(x11_appScreen());
-        Q_ASSERT(rootWindow);
-        if (!rootWindow) {
-            return {};
-        }
-        result_type result = {};
-        const xcb_list_properties_cookie_t cookie = xcb_list_properties(connection, rootWindow);
-        xcb_list_properties_reply_t * const reply = xcb_list_properties_reply(connection, cookie, nullptr);
-        if (!reply) {
-            return {};
-        }
-        const int len = xcb_list_properties_atoms_length(reply);
-        const auto atoms = static_cast<xcb_atom_t *>(xcb_list_properties_atoms(reply));
-        result.resize(len);
-        std::memcpy(result.data(), atoms, len * sizeof(xcb_atom_t));
-        std::free(reply);
-        return result;
-    }();
-    return rootWindowProperties.contains(atom);
+    return X11::capabilities()->hasRootWindowProperty(atom);
 }
 
 bool Utils::tryHideSystemTitleBar(const WId windowId, const bool hide)
@@ -881,6 +908,11 @@ bool Utils::tryHideSystemTitleBar(const WId windowId, const bool hide)
     if (!windowId) {
         return false;
     }
+    if (!isXcbPlatform()) {
+        // Qt negotiates the decoration mode through xdg-decoration by itself, a frameless
+        // window asks the compositor for client side decorations.
+        return false;
+    }
     static const xcb_atom_t deepinNoTitleBarAtom = internAtom(ATOM_DEEPIN_NO_TITLEBAR);
     if ((deepinNoTitleBarAtom == XCB_NONE) || !isSupportedByWindowManager(deepinNoTitleBarAtom)) {
         WARNING << "Current window manager doesn't support hiding title bar natively.";
@@ -907,12 +939,11 @@ void Utils::sendMoveResizeMessage(const WId windowId, const uint32_t action, con
         return;
     }
 
-    xcb_connection_t * const connection = x11_connection();
-    Q_ASSERT(connection);
-    if (!connection) {
+    X11::Backend * const backend = X11::backend();
+    if (!backend) {
         return;
     }
-    const quint32 rootWindow = x11_appRootWindow(x11_appScreen());
+    const xcb_window_t rootWindow = backend->rootWindow();
     Q_ASSERT(rootWindow);
     if (!rootWindow) {
         return;
@@ -944,15 +975,20 @@ void Utils::sendMoveResizeMessage(const WId windowId, const uint32_t action, con
     }();
     xev.data.data32[4] = 0;
 
+    X11::submitPendingRequests();
     if (action != _NET_WM_MOVERESIZE_CANCEL) {
-        xcb_ungrab_pointer(connection, XCB_CURRENT_TIME);
+        backend->ungrabPointer();
     }
-    xcb_send_event(connection, false, rootWindow, _XCB_SEND_EVENT_MASK, reinterpret_cast<const char *>(&xev));
-    xcb_flush(connection);
+    backend->sendClientMessage(rootWindow, xev);
+    // The pointer grab is handed over to the window manager, it must not be delayed.
+    X11::flushNow();
 }
 
 bool Utils::isCustomDecorationSupported()
 {
+    if (!isXcbPlatform()) {
+        return false;
+    }
     static const xcb_atom_t atom = internAtom(ATOM_DEEPIN_NO_TITLEBAR);
     return ((atom != XCB_NONE) && isSupportedByWindowManager(atom));
 }
@@ -30,6 +30,7 @@
 #include "framelessmanager_p.h"
 #include "framelessconfig_p.h"
 #include "framelesshelpercore_global_p.h"
+#include "tracing_p.h"
 #include <functional>
 #include <memory>
 #include <QtCore/qhash.h>
@@ -591,6 +592,7 @@ void Utils::setSystemTitleBarVisible(const WId windowId, const bool visible)
 
 bool Utils::startSystemMove(QWindow *window, const QPoint &globalPos)
 {
+    const Trace::Span span("Utils::startSystemMove");
     Q_ASSERT(window);
     if (!window) {
         return false;
@@ -620,6 +622,7 @@ bool Utils::startSystemMove(QWindow *window, const QPoint &globalPos)
 
 bool Utils::startSystemResize(QWindow *window, const Qt::Edges edges, const QPoint &globalPos)
 {
+    const Trace::Span span("Utils::startSystemResize");
     Q_ASSERT(window);
     if (!window) {
         return false;
@@ -715,7 +718,9 @@ WallpaperAspectStyle Utils::getWallpaperAspectStyle()
 
 bool Utils::isBlurBehindWindowSupported()
 {
-    static const auto result = []() -> bool {
+    // Re-evaluated whenever the configuration has been reloaded.
+    static ConfigDerivedFlag result;
+    return result.value([]() -> bool {
         if (FramelessConfig::instance()->isSet(Option::ForceNonNativeBackgroundBlur)) {
             return false;
         }
@@ -724,8 +729,7 @@ bool Utils::isBlurBehindWindowSupported()
 #else
         return (QSysInfo::macVersion() >= QSysInfo::MV_YOSEMITE);
 #endif
-    }();
-    return result;
+    });
 }
 
 bool Utils::registerThemeChangeNotification()
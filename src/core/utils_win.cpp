@@ -35,6 +35,7 @@
 #include "framelesshelpercore_global_p.h"
 #include "versionnumber_p.h"
 #include "scopeguard_p.h"
+#include "tracing_p.h"
 #include <optional>
 #include <QtCore/qhash.h>
 #include <QtCore/qloggingcategory.h>
@@ -196,6 +197,7 @@ FRAMELESSHELPER_STRING_CONSTANT(GetCursorPos)
 struct Win32UtilsData
 {
     SystemParameters params = {};
+    bool pureQt = false; // Latched when the hook is installed, see FramelessManager::addWindow().
 };
 
 struct Win32UtilsInternal
@@ -956,12 +958,6 @@ static constexpr const std::array<Win32Message, 333> g_win32MessageMap =
     }
 }
 
-[[nodiscard]] static inline bool usePureQtImplementation()
-{
-    static const bool result = FramelessConfig::instance()->isSet(Option::UseCrossPlatformQtImplementation);
-    return result;
-}
-
 [[nodiscard]] static inline LRESULT CALLBACK FramelessHelperHookWindowProc
     (const HWND hWnd, const UINT uMsg, const WPARAM wParam, const LPARAM lParam)
 {
@@ -1004,7 +1000,7 @@ static constexpr const std::array<Win32Message, 333> g_win32MessageMap =
     // (and correct client area size, especially when the window is maximized/fullscreen). So we still go through
     // the normal code path of the original qWindowsWndProc() function, but only for this specific message. It should
     // be OK because Qt won't prevent us from handling WM_NCCALCSIZE.
-    if (!usePureQtImplementation() && (uMsg != WM_NCCALCSIZE)) {
+    if (!it->pureQt && (uMsg != WM_NCCALCSIZE)) {
         MSG message;
         SecureZeroMemory(&message, sizeof(message));
         message.hwnd = hWnd;
@@ -1936,6 +1932,7 @@ bool Utils::maybeFixupQtInternals(const WId windowId)
 
 bool Utils::startSystemMove(QWindow *window, const QPoint &globalPos)
 {
+    const Trace::Span span("Utils::startSystemMove");
     Q_UNUSED(globalPos);
     Q_ASSERT(window);
     if (!window) {
@@ -1959,6 +1956,7 @@ bool Utils::startSystemMove(QWindow *window, const QPoint &globalPos)
 
 bool Utils::startSystemResize(QWindow *window, const Qt::Edges edges, const QPoint &globalPos)
 {
+    const Trace::Span span("Utils::startSystemResize");
     Q_UNUSED(globalPos);
     Q_ASSERT(window);
     if (!window) {
@@ -2038,6 +2036,7 @@ bool Utils::installWindowProcHook(const WId windowId, FramelessParamsConst param
     if (it == g_win32UtilsData()->data.constEnd()) {
         Win32UtilsData data = {};
         data.params = *params;
+        data.pureQt = FramelessConfig::instance()->isSet(Option::UseCrossPlatformQtImplementation);
         g_win32UtilsData()->data.insert(windowId, data);
         ::SetLastError(ERROR_SUCCESS);
         if (::SetWindowLongPtrW(hwnd, GWLP_WNDPROC, reinterpret_cast<LONG_PTR>(FramelessHelperHookWindowProc)) == 0) {
@@ -2623,7 +2622,9 @@ WallpaperAspectStyle Utils::getWallpaperAspectStyle()
 
 bool Utils::isBlurBehindWindowSupported()
 {
-    static const auto result = []() -> bool {
+    // Re-evaluated whenever the configuration has been reloaded.
+    static ConfigDerivedFlag result;
+    return result.value([]() -> bool {
         if (FramelessConfig::instance()->isSet(Option::ForceNativeBackgroundBlur)) {
             return true;
         }
@@ -2634,8 +2635,7 @@ bool Utils::isBlurBehindWindowSupported()
         // and enabling Acrylic on Win10 makes the window very laggy during moving and resizing.
         //return WindowsVersionHelper::isWin10OrGreater();
         return false;
-    }();
-    return result;
+    });
 }
 
 bool Utils::hideOriginalTitleBarElements(const WId windowId, const bool disable)
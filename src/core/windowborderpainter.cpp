@@ -29,6 +29,8 @@
 
 #include "utils.h"
 #include "framelessmanager.h"
+#include "framelessmanager_p.h"
+#include "framelessstatistics_p.h"
 #ifdef Q_OS_WINDOWS
 #  include "winverhelper_p.h"
 #endif
@@ -88,6 +90,7 @@ WindowBorderPainter::WindowBorderPainter(QObject *parent)
 {
     connect(FramelessManager::instance(), &FramelessManager::systemThemeChanged, this, &WindowBorderPainter::nativeBorderChanged);
     connect(this, &WindowBorderPainter::nativeBorderChanged, this, &WindowBorderPainter::shouldRepaint);
+    connect(this, &WindowBorderPainter::shouldRepaint, this, [](){ Stats::increment(Stats::Counter::BorderRepaints); });
 }
 
 WindowBorderPainter::~WindowBorderPainter() = default;
@@ -139,12 +142,12 @@ WindowEdges WindowBorderPainter::nativeEdges() const
 
 QColor WindowBorderPainter::nativeActiveColor() const
 {
-    return Utils::getFrameBorderColor(true);
+    return FramelessManagerPrivate::currentThemeSnapshot()->frameBorderActiveColor;
 }
 
 QColor WindowBorderPainter::nativeInactiveColor() const
 {
-    return Utils::getFrameBorderColor(false);
+    return FramelessManagerPrivate::currentThemeSnapshot()->frameBorderInactiveColor;
 }
 
 void WindowBorderPainter::paint(QPainter *painter, const QSize &size, const bool active)
@@ -0,0 +1,497 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021-2023 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "x11backend_p.h"
+#include "x11capabilities_p.h"
+
+#if (defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID))
+
+#include "utils.h"
+#include "framelessstatistics_p.h"
+#include <QtCore/qloggingcategory.h>
+#include <cstring>
+#include <utility>
+
+FRAMELESSHELPER_BEGIN_NAMESPACE
+
+#if FRAMELESSHELPER_CONFIG(debug_output)
+[[maybe_unused]] static Q_LOGGING_CATEGORY(lcX11Backend, "wangwenx190.framelesshelper.core.x11backend")
+#  define INFO qCInfo(lcX11Backend)
+#  define DEBUG qCDebug(lcX11Backend)
+#  define WARNING qCWarning(lcX11Backend)
+#  define CRITICAL qCCritical(lcX11Backend)
+#else
+#  define INFO QT_NO_QDEBUG_MACRO()
+#  define DEBUG QT_NO_QDEBUG_MACRO()
+#  define WARNING QT_NO_QDEBUG_MACRO()
+#  define CRITICAL QT_NO_QDEBUG_MACRO()
+#endif
+
+using namespace Global;
+
+static constexpr const auto _XCB_SEND_EVENT_MASK =
+    (XCB_EVENT_MASK_SUBSTRUCTURE_REDIRECT | XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY);
+
+// Leaves some room after the predefined atoms, like a real server does.
+static constexpr const xcb_atom_t kFirstRecordedAtom = 0x100;
+
+class XcbBackend final : public X11::Backend
+{
+    Q_DISABLE_COPY_MOVE(XcbBackend)
+
+public:
+    explicit XcbBackend(xcb_connection_t *connection, const xcb_window_t rootWindow)
+        : X11::Backend(true), m_connection(connection), m_rootWindow(rootWindow)
+    {
+        Q_ASSERT(m_connection);
+    }
+
+    ~XcbBackend() override = default;
+
+    Q_NODISCARD xcb_window_t rootWindow() const override
+    {
+        return m_rootWindow;
+    }
+
+protected:
+    Q_NODISCARD xcb_atom_t doInternAtom(const char *name) override
+    {
+        const xcb_intern_atom_cookie_t cookie = xcb_intern_atom(m_connection, false, qstrlen(name), name);
+        const X11::ReplyPtr<xcb_intern_atom_reply_t> reply(xcb_intern_atom_reply(m_connection, cookie, nullptr));
+        return (reply ? reply->atom : xcb_atom_t(XCB_NONE));
+    }
+
+    Q_NODISCARD X11::AtomsAndProperties doInternAtomsAndListProperties(const char * const *names,
+        const int count, const xcb_window_t window) override
+    {
+        // Nothing here depends on anything else, send it all at once.
+        std::vector<xcb_intern_atom_cookie_t> atomCookies(count);
+        for (int i = 0; i != count; ++i) {
+            atomCookies.at(i) = xcb_intern_atom(m_connection, false, qstrlen(names[i]), names[i]);
+        }
+        xcb_list_properties_cookie_t propertiesCookie = {};
+        if (window != XCB_WINDOW_NONE) {
+            propertiesCookie = xcb_list_properties(m_connection, window);
+        }
+        // Waiting for the first reply costs one round trip, the rest has arrived by then.
+        X11::AtomsAndProperties result = {};
+        result.atoms.resize(count, XCB_NONE);
+        for (int i = 0; i != count; ++i) {
+            if (const X11::ReplyPtr<xcb_intern_atom_reply_t> reply(xcb_intern_atom_reply(m_connection, atomCookies.at(i), nullptr)); reply) {
+                result.atoms.at(i) = reply->atom;
+            } else {
+                WARNING << "Failed to retrieve the atom of" << names[i];
+            }
+        }
+        if (window == XCB_WINDOW_NONE) {
+            return result;
+        }
+        if (const X11::ReplyPtr<xcb_list_properties_reply_t> reply(xcb_list_properties_reply(m_connection, propertiesCookie, nullptr)); reply) {
+            const xcb_atom_t * const atoms = xcb_list_properties_atoms(reply.get());
+            result.properties.assign(atoms, atoms + xcb_list_properties_atoms_length(reply.get()));
+        }
+        return result;
+    }
+
+    Q_NODISCARD X11::PropertyFuture doRequestProperty(const xcb_window_t window, const xcb_atom_t prop,
+        const xcb_atom_t type, const quint32 offset, const quint32 length) override
+    {
+        return X11::requestProperty(m_connection, window, prop, type, offset, length);
+    }
+
+    void doChangeProperty(const xcb_window_t window, const xcb_atom_t prop, const xcb_atom_t type,
+        const quint8 format, const void *data, const quint32 count) override
+    {
+        xcb_change_property(m_connection, XCB_PROP_MODE_REPLACE, window, prop, type, format, count, data);
+    }
+
+    void doDeleteProperty(const xcb_window_t window, const xcb_atom_t prop) override
+    {
+        xcb_delete_property_checked(m_connection, window, prop);
+    }
+
+    void doSendClientMessage(const xcb_window_t destination, const xcb_client_message_event_t &event) override
+    {
+        xcb_send_event(m_connection, false, destination, _XCB_SEND_EVENT_MASK, reinterpret_cast<const char *>(&event));
+    }
+
+    void doUngrabPointer() override
+    {
+        xcb_ungrab_pointer(m_connection, XCB_CURRENT_TIME);
+    }
+
+    void doFlush() override
+    {
+        xcb_flush(m_connection);
+    }
+
+private:
+    xcb_connection_t *m_connection = nullptr;
+    xcb_window_t m_rootWindow = XCB_WINDOW_NONE;
+};
+
+struct X11BackendData
+{
+    QMutex mutex{};
+    std::unique_ptr<X11::Backend> installed = nullptr; // From setBackend().
+    std::unique_ptr<X11::Backend> xcb = nullptr; // The application's own connection.
+};
+
+Q_GLOBAL_STATIC(X11BackendData, g_x11BackendData)
+
+X11::Backend::Backend(const bool realServer) : m_realServer(realServer)
+{
+}
+
+X11::Backend::~Backend() = default;
+
+void X11::Backend::record(const Operation operation)
+{
+    record(operation, 1, (isRoundTrip(operation) ? 1 : 0));
+}
+
+void X11::Backend::record(const Operation operation, const quint64 requests, const quint64 roundTrips)
+{
+    m_requests.at(static_cast<int>(operation)).fetch_add(requests, std::memory_order_relaxed);
+    m_roundTrips.at(static_cast<int>(operation)).fetch_add(roundTrips, std::memory_order_relaxed);
+    // Keep the simulated traffic out of the numbers about the real connection.
+    if (!m_realServer) {
+        return;
+    }
+    if (roundTrips > 0) {
+        Stats::increment(Stats::Counter::X11RoundTrips, roundTrips);
+    }
+    if (operation == Operation::Flush) {
+        Stats::increment(Stats::Counter::X11Flushes, requests);
+    }
+}
+
+xcb_atom_t X11::Backend::internAtom(const char *name)
+{
+    Q_ASSERT(name);
+    Q_ASSERT(*name != '\0');
+    if (!name || (*name == '\0')) {
+        return XCB_NONE;
+    }
+    record(Operation::InternAtom);
+    return doInternAtom(name);
+}
+
+X11::AtomsAndProperties X11::Backend::internAtomsAndListProperties(const char * const *names,
+    const int count, const xcb_window_t window)
+{
+    Q_ASSERT(names);
+    Q_ASSERT(count >= 0);
+    if (!names || (count < 0)) {
+        return {};
+    }
+    // The whole batch waits for the server only once, the round trip is
+    // accounted to the atoms.
+    record(Operation::InternAtom, count, 1);
+    if (window != XCB_WINDOW_NONE) {
+        record(Operation::ListProperties, 1, 0);
+    }
+    return doInternAtomsAndListProperties(names, count, window);
+}
+
+X11::PropertyFuture X11::Backend::requestProperty(const xcb_window_t window, const xcb_atom_t prop,
+    const xcb_atom_t type, const quint32 offset, const quint32 length)
+{
+    Q_ASSERT(window);
+    Q_ASSERT(prop != XCB_NONE);
+    if (!window || (prop == XCB_NONE)) {
+        return {};
+    }
+    record(Operation::GetProperty);
+    return doRequestProperty(window, prop, type, offset, length);
+}
+
+X11::PropertyReply X11::Backend::getProperty(const xcb_window_t window, const xcb_atom_t prop,
+    const xcb_atom_t type, const quint32 length)
+{
+    return requestProperty(window, prop, type, 0, length).get();
+}
+
+void X11::Backend::changeProperty(const xcb_window_t window, const xcb_atom_t prop, const xcb_atom_t type,
+    const quint8 format, const void *data, const quint32 count)
+{
+    Q_ASSERT(window);
+    Q_ASSERT(prop != XCB_NONE);
+    Q_ASSERT(type != XCB_NONE);
+    Q_ASSERT((format == 8) || (format == 16) || (format == 32));
+    if (!window || (prop == XCB_NONE) || (type == XCB_NONE)
+        || ((format != 8) && (format != 16) && (format != 32))) {
+        return;
+    }
+    record(Operation::ChangeProperty);
+    doChangeProperty(window, prop, type, format, data, (data ? count : 0));
+}
+
+void X11::Backend::deleteProperty(const xcb_window_t window, const xcb_atom_t prop)
+{
+    Q_ASSERT(window);
+    Q_ASSERT(prop != XCB_NONE);
+    if (!window || (prop == XCB_NONE)) {
+        return;
+    }
+    record(Operation::DeleteProperty);
+    doDeleteProperty(window, prop);
+}
+
+void X11::Backend::sendClientMessage(const xcb_window_t destination, const xcb_client_message_event_t &event)
+{
+    Q_ASSERT(destination);
+    if (!destination) {
+        return;
+    }
+    record(Operation::SendEvent);
+    doSendClientMessage(destination, event);
+}
+
+void X11::Backend::ungrabPointer()
+{
+    record(Operation::UngrabPointer);
+    doUngrabPointer();
+}
+
+void X11::Backend::flush()
+{
+    record(Operation::Flush);
+    doFlush();
+}
+
+X11::OperationCount X11::Backend::count(const Operation operation) const
+{
+    OperationCount result = {};
+    result.requests = m_requests.at(static_cast<int>(operation)).load(std::memory_order_relaxed);
+    result.roundTrips = m_roundTrips.at(static_cast<int>(operation)).load(std::memory_order_relaxed);
+    return result;
+}
+
+X11::OperationCounts X11::Backend::counts() const
+{
+    OperationCounts result = {};
+    for (int i = 0; i != kOperationCount; ++i) {
+        result.at(i) = count(static_cast<Operation>(i));
+    }
+    return result;
+}
+
+void X11::Backend::resetCounts()
+{
+    for (auto &&requests : m_requests) {
+        requests.store(0, std::memory_order_relaxed);
+    }
+    for (auto &&roundTrips : m_roundTrips) {
+        roundTrips.store(0, std::memory_order_relaxed);
+    }
+}
+
+X11::RecordingBackend::RecordingBackend(const xcb_window_t rootWindow) : m_rootWindow(rootWindow)
+{
+    Q_ASSERT(m_rootWindow);
+}
+
+X11::RecordingBackend::~RecordingBackend() = default;
+
+xcb_window_t X11::RecordingBackend::rootWindow() const
+{
+    return m_rootWindow;
+}
+
+std::optional<X11::RecordingBackend::Property> X11::RecordingBackend::property(const xcb_window_t window, const xcb_atom_t prop) const
+{
+    const QMutexLocker locker(&m_mutex);
+    const auto it = m_properties.constFind(qMakePair(window, prop));
+    if (it == m_properties.constEnd()) {
+        return std::nullopt;
+    }
+    return it.value();
+}
+
+QList<X11::RecordingBackend::Message> X11::RecordingBackend::messages() const
+{
+    const QMutexLocker locker(&m_mutex);
+    return m_messages;
+}
+
+quint32 X11::RecordingBackend::pointerUngrabs() const
+{
+    const QMutexLocker locker(&m_mutex);
+    return m_pointerUngrabs;
+}
+
+quint32 X11::RecordingBackend::flushes() const
+{
+    const QMutexLocker locker(&m_mutex);
+    return m_flushes;
+}
+
+void X11::RecordingBackend::clear()
+{
+    const QMutexLocker locker(&m_mutex);
+    m_atoms.clear();
+    m_properties.clear();
+    m_messages.clear();
+    m_pointerUngrabs = 0;
+    m_flushes = 0;
+}
+
+xcb_atom_t X11::RecordingBackend::doInternAtom(const char *name)
+{
+    const QMutexLocker locker(&m_mutex);
+    const QByteArray key(name);
+    const auto it = m_atoms.constFind(key);
+    if (it != m_atoms.constEnd()) {
+        return it.value();
+    }
+    const auto atom = xcb_atom_t(kFirstRecordedAtom + m_atoms.size());
+    m_atoms.insert(key, atom);
+    return atom;
+}
+
+X11::AtomsAndProperties X11::RecordingBackend::doInternAtomsAndListProperties(const char * const *names,
+    const int count, const xcb_window_t window)
+{
+    AtomsAndProperties result = {};
+    result.atoms.reserve(count);
+    for (int i = 0; i != count; ++i) {
+        result.atoms.push_back(doInternAtom(names[i]));
+    }
+    if (window == XCB_WINDOW_NONE) {
+        return result;
+    }
+    const QMutexLocker locker(&m_mutex);
+    for (auto it = m_properties.constBegin(); it != m_properties.constEnd(); ++it) {
+        if (it.key().first == window) {
+            result.properties.push_back(it.key().second);
+        }
+    }
+    return result;
+}
+
+X11::PropertyFuture X11::RecordingBackend::doRequestProperty(const xcb_window_t window, const xcb_atom_t prop,
+    const xcb_atom_t type, const quint32 offset, const quint32 length)
+{
+    const QMutexLocker locker(&m_mutex);
+    const auto it = m_properties.constFind(qMakePair(window, prop));
+    if (it == m_properties.constEnd()) {
+        return PropertyFuture(PropertyReply::create(XCB_NONE, 0, nullptr, 0));
+    }
+    const auto size = quint32(it->data.size());
+    // Like the server: no value if the type doesn't match (XCB_NONE is AnyPropertyType),
+    // but the actual type, format and size are reported.
+    if ((type != XCB_NONE) && (type != it->type)) {
+        return PropertyFuture(PropertyReply::create(it->type, it->format, nullptr, 0, size));
+    }
+    const quint32 begin = qMin(quint64(offset) * 4, quint64(size));
+    const quint32 end = qMin(quint64(begin) + quint64(length) * 4, quint64(size));
+    const quint32 unit = qMax(it->format / 8, 1);
+    return PropertyFuture(PropertyReply::create(it->type, it->format,
+        it->data.constData() + begin, ((end - begin) / unit), (size - end)));
+}
+
+void X11::RecordingBackend::doChangeProperty(const xcb_window_t window, const xcb_atom_t prop, const xcb_atom_t type,
+    const quint8 format, const void *data, const quint32 count)
+{
+    Property property = {};
+    property.type = type;
+    property.format = format;
+    property.count = count;
+    if (data && (count > 0)) {
+        property.data = QByteArray(static_cast<const char *>(data), int(count * (format / 8)));
+    }
+    const QMutexLocker locker(&m_mutex);
+    m_properties.insert(qMakePair(window, prop), std::move(property));
+}
+
+void X11::RecordingBackend::doDeleteProperty(const xcb_window_t window, const xcb_atom_t prop)
+{
+    const QMutexLocker locker(&m_mutex);
+    m_properties.remove(qMakePair(window, prop));
+}
+
+void X11::RecordingBackend::doSendClientMessage(const xcb_window_t destination, const xcb_client_message_event_t &event)
+{
+    Message message = {};
+    message.destination = destination;
+    std::memcpy(&message.event, &event, sizeof(event));
+    const QMutexLocker locker(&m_mutex);
+    m_messages.append(message);
+}
+
+void X11::RecordingBackend::doUngrabPointer()
+{
+    const QMutexLocker locker(&m_mutex);
+    ++m_pointerUngrabs;
+}
+
+void X11::RecordingBackend::doFlush()
+{
+    const QMutexLocker locker(&m_mutex);
+    ++m_flushes;
+}
+
+std::unique_ptr<X11::Backend> X11::createXcbBackend(xcb_connection_t *connection, const xcb_window_t rootWindow)
+{
+    Q_ASSERT(connection);
+    if (!connection) {
+        return nullptr;
+    }
+    return std::make_unique<XcbBackend>(connection, rootWindow);
+}
+
+X11::Backend *X11::backend()
+{
+    const QMutexLocker locker(&g_x11BackendData()->mutex);
+    if (g_x11BackendData()->installed) {
+        return g_x11BackendData()->installed.get();
+    }
+    if (g_x11BackendData()->xcb) {
+        return g_x11BackendData()->xcb.get();
+    }
+    // Don't cache the failure, the application may not have a connection yet.
+    xcb_connection_t * const connection = Utils::x11_connection();
+    if (!connection) {
+        return nullptr;
+    }
+    g_x11BackendData()->xcb = createXcbBackend(connection, Utils::x11_appRootWindow(Utils::x11_appScreen()));
+    return g_x11BackendData()->xcb.get();
+}
+
+std::unique_ptr<X11::Backend> X11::setBackend(std::unique_ptr<X11::Backend> value)
+{
+    std::unique_ptr<Backend> previous = nullptr;
+    {
+        const QMutexLocker locker(&g_x11BackendData()->mutex);
+        previous = std::exchange(g_x11BackendData()->installed, std::move(value));
+    }
+    // The atoms and the window manager may be completely different behind the new backend.
+    resetCapabilities();
+    return previous;
+}
+
+FRAMELESSHELPER_END_NAMESPACE
+
+#endif // (defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID))
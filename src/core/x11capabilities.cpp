@@ -0,0 +1,334 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021-2023 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "x11capabilities_p.h"
+#include "x11property_p.h"
+#include "x11backend_p.h"
+
+#if (defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID))
+
+#include "utils.h"
+#include "framelessmanager.h"
+#include <QtCore/qabstractnativeeventfilter.h>
+#include <QtCore/qcoreapplication.h>
+#include <QtCore/qloggingcategory.h>
+#include <QtCore/qmutex.h>
+#include <QtCore/qtimer.h>
+#include <cstring>
+
+FRAMELESSHELPER_BEGIN_NAMESPACE
+
+#if FRAMELESSHELPER_CONFIG(debug_output)
+[[maybe_unused]] static Q_LOGGING_CATEGORY(lcX11Capabilities, "wangwenx190.framelesshelper.core.x11capabilities")
+#  define INFO qCInfo(lcX11Capabilities)
+#  define DEBUG qCDebug(lcX11Capabilities)
+#  define WARNING qCWarning(lcX11Capabilities)
+#  define CRITICAL qCCritical(lcX11Capabilities)
+#else
+#  define INFO QT_NO_QDEBUG_MACRO()
+#  define DEBUG QT_NO_QDEBUG_MACRO()
+#  define WARNING QT_NO_QDEBUG_MACRO()
+#  define CRITICAL QT_NO_QDEBUG_MACRO()
+#endif
+
+using namespace Global;
+
+// In 32-bit units. Real window managers advertise a few hundred atoms at most,
+// so _NET_SUPPORTED almost always arrives in one piece.
+static constexpr const quint32 kNetSupportedChunkSize = 4096;
+
+// A restarting window manager rewrites several root window properties in a row,
+// probe once after the burst instead of once per property.
+static constexpr const int kRefreshDelay = 200; // ms
+
+class CapabilityWatcher : public QAbstractNativeEventFilter
+{
+public:
+    CapabilityWatcher() = default;
+    ~CapabilityWatcher() override = default;
+
+    Q_NODISCARD bool nativeEventFilter(const QByteArray &eventType, void *message, QT_NATIVE_EVENT_RESULT_TYPE *result) override;
+};
+
+struct X11CapabilitiesData
+{
+    QMutex mutex{};
+    X11::CapabilitiesPtr current = nullptr;
+    bool refreshPending = false;
+    std::unique_ptr<CapabilityWatcher> watcher = nullptr;
+};
+
+Q_GLOBAL_STATIC(X11CapabilitiesData, g_x11CapabilitiesData)
+
+static inline void appendAtoms(X11::AtomList &list, const xcb_atom_t *atoms, const int count)
+{
+    if (!atoms || (count <= 0)) {
+        return;
+    }
+    const auto size = list.size();
+    list.resize(size + count);
+    std::memcpy(list.data() + size, atoms, count * sizeof(xcb_atom_t));
+}
+
+static inline void appendAtoms(X11::AtomList &list, const X11::PropertyValues<xcb_atom_t> &atoms)
+{
+    appendAtoms(list, atoms.data(), atoms.size());
+}
+
+X11::Capabilities X11::probeCapabilities(Backend &backend)
+{
+    const xcb_window_t rootWindow = backend.rootWindow();
+    Q_ASSERT(rootWindow);
+    if (!rootWindow) {
+        return {};
+    }
+    Capabilities caps = {};
+    caps.rootWindow = rootWindow;
+
+    // Stage 1: nothing here depends on anything else, send it all at once.
+    const AtomsAndProperties stage1 = backend.internAtomsAndListProperties(kAtomNames.data(), kAtomCount, rootWindow);
+    ++caps.roundTrips;
+    std::copy_n(stage1.atoms.cbegin(), qMin(int(stage1.atoms.size()), kAtomCount), caps.atoms.begin());
+    appendAtoms(caps.rootWindowProperties, stage1.properties.data(), int(stage1.properties.size()));
+
+    // Stage 2: the root window properties, now that we know their atoms.
+    const xcb_atom_t netSupportedAtom = caps.atom(Atom::NetSupported);
+    const xcb_atom_t wmCheckAtom = caps.atom(Atom::NetSupportingWmCheck);
+    PropertyFuture netSupportedFuture = {};
+    PropertyFuture wmCheckFuture = {};
+    if (netSupportedAtom != XCB_NONE) {
+        netSupportedFuture = backend.requestProperty(rootWindow, netSupportedAtom, XCB_ATOM_ATOM, 0, kNetSupportedChunkSize);
+    }
+    if (wmCheckAtom != XCB_NONE) {
+        wmCheckFuture = backend.requestProperty(rootWindow, wmCheckAtom, XCB_ATOM_WINDOW, 0, 1);
+    }
+    xcb_window_t windowManager = XCB_WINDOW_NONE;
+    // Backends without a server fulfill the requests right away, but it's still one wait.
+    if ((netSupportedAtom != XCB_NONE) || (wmCheckAtom != XCB_NONE)) {
+        ++caps.roundTrips;
+    }
+    if (netSupportedAtom != XCB_NONE) {
+        PropertyReply reply = netSupportedFuture.get();
+        quint32 offset = 0;
+        // The first page tells how much is left, so the list is allocated only once.
+        if (const PropertyValues<xcb_atom_t> atoms = reply.values<xcb_atom_t>(XCB_ATOM_ATOM); !atoms.isEmpty()) {
+            caps.netSupported.reserve(atoms.size() + int(reply.bytesAfter() / sizeof(xcb_atom_t)));
+        }
+        while (reply.isValid()) {
+            const PropertyValues<xcb_atom_t> atoms = reply.values<xcb_atom_t>(XCB_ATOM_ATOM);
+            appendAtoms(caps.netSupported, atoms);
+            offset += atoms.size();
+            const quint32 remaining = (atoms.isEmpty() ? 0 : reply.bytesAfter());
+            reply = {};
+            if (remaining > 0) {
+                // Only for unusually large lists: every further page is another round trip.
+                ++caps.roundTrips;
+                reply = backend.requestProperty(rootWindow, netSupportedAtom, XCB_ATOM_ATOM, offset, kNetSupportedChunkSize).get();
+            }
+        }
+    }
+    if (wmCheckAtom != XCB_NONE) {
+        const PropertyReply reply = wmCheckFuture.get();
+        if (const PropertyValues<xcb_window_t> windows = reply.values<xcb_window_t>(XCB_ATOM_WINDOW); !windows.isEmpty()) {
+            windowManager = windows.at(0);
+        }
+    }
+
+    // Stage 3: the window manager's name lives on its own check window.
+    const xcb_atom_t wmNameAtom = caps.atom(Atom::NetWmName);
+    const xcb_atom_t strAtom = caps.atom(Atom::Utf8String);
+    if ((windowManager != XCB_WINDOW_NONE) && (wmNameAtom != XCB_NONE) && (strAtom != XCB_NONE)) {
+        ++caps.roundTrips;
+        const PropertyReply reply = backend.requestProperty(windowManager, wmNameAtom, strAtom, 0, 1024).get();
+        // Decoded straight from the reply, the name is the only string we keep.
+        if (const PropertyValues<char> name = reply.values<char>(strAtom); !name.isEmpty()) {
+            caps.windowManagerName = QString::fromUtf8(name.data(), name.size());
+        }
+    }
+
+    // Sorted once here, so that every lookup afterwards can be a binary search.
+    for (auto &&list : {&caps.netSupported, &caps.rootWindowProperties}) {
+        std::sort(list->begin(), list->end());
+        list->erase(std::unique(list->begin(), list->end()), list->end());
+    }
+    caps.valid = true;
+    DEBUG << "X11 capabilities probed with" << caps.roundTrips << "round trips. Window manager:"
+          << caps.windowManagerName << ", supported atoms:" << caps.netSupported.size()
+          << ", root window properties:" << caps.rootWindowProperties.size();
+    return caps;
+}
+
+// The application's own connection, unless a test or a benchmark has installed
+// another backend.
+[[nodiscard]] static inline X11::Capabilities probeCurrentBackend()
+{
+    X11::Backend * const backend = X11::backend();
+    if (!backend) {
+        return {};
+    }
+    return X11::probeCapabilities(*backend);
+}
+
+static inline void publish(X11::Capabilities &&caps)
+{
+    const QMutexLocker locker(&g_x11CapabilitiesData()->mutex);
+    const X11::CapabilitiesPtr &current = g_x11CapabilitiesData()->current;
+    caps.generation = (current ? (current->generation + 1) : 1);
+    g_x11CapabilitiesData()->current = std::make_shared<const X11::Capabilities>(std::move(caps));
+}
+
+static inline void refresh()
+{
+    {
+        const QMutexLocker locker(&g_x11CapabilitiesData()->mutex);
+        g_x11CapabilitiesData()->refreshPending = false;
+    }
+    const X11::CapabilitiesPtr previous = X11::capabilities();
+    X11::Capabilities caps = probeCurrentBackend();
+    const bool changed = ((caps.windowManagerName != previous->windowManagerName)
+        || (caps.netSupported != previous->netSupported));
+    publish(std::move(caps));
+    if (!changed) {
+        return;
+    }
+    INFO << "The window manager has changed, current window manager:" << X11::capabilities()->windowManagerName;
+    Q_EMIT FramelessManager::instance()->windowManagerCapabilitiesChanged();
+}
+
+static inline void scheduleRefresh()
+{
+    {
+        const QMutexLocker locker(&g_x11CapabilitiesData()->mutex);
+        if (g_x11CapabilitiesData()->refreshPending) {
+            return;
+        }
+        g_x11CapabilitiesData()->refreshPending = true;
+    }
+    QTimer::singleShot(kRefreshDelay, qApp, [](){ refresh(); });
+}
+
+// Keeps the sorted root window property list in sync without asking the server.
+static inline void updateRootWindowProperty(const xcb_atom_t atom, const bool exists)
+{
+    const QMutexLocker locker(&g_x11CapabilitiesData()->mutex);
+    const X11::CapabilitiesPtr &current = g_x11CapabilitiesData()->current;
+    if (!current || (current->hasRootWindowProperty(atom) == exists)) {
+        // Most notifications are about existing properties getting new values.
+        return;
+    }
+    auto caps = std::make_shared<X11::Capabilities>(*current);
+    X11::AtomList &list = caps->rootWindowProperties;
+    const auto it = std::lower_bound(list.begin(), list.end(), atom);
+    if (exists) {
+        list.insert(it, atom);
+    } else {
+        list.erase(it);
+    }
+    g_x11CapabilitiesData()->current = std::move(caps);
+}
+
+bool CapabilityWatcher::nativeEventFilter(const QByteArray &eventType, void *message, QT_NATIVE_EVENT_RESULT_TYPE *result)
+{
+    Q_UNUSED(result);
+    if (!message || (eventType != QByteArrayLiteral("xcb_generic_event_t"))) {
+        return false;
+    }
+    const auto event = static_cast<const xcb_generic_event_t *>(message);
+    if ((event->response_type & ~0x80) != XCB_PROPERTY_NOTIFY) {
+        return false;
+    }
+    const auto notify = reinterpret_cast<const xcb_property_notify_event_t *>(event);
+    const X11::CapabilitiesPtr caps = X11::capabilities();
+    if (!caps->valid || (notify->window != caps->rootWindow)) {
+        return false;
+    }
+    if ((notify->atom == caps->atom(X11::Atom::NetSupported))
+        || (notify->atom == caps->atom(X11::Atom::NetSupportingWmCheck))) {
+        scheduleRefresh();
+    } else {
+        updateRootWindowProperty(notify->atom, (notify->state == XCB_PROPERTY_NEW_VALUE));
+    }
+    // Never swallow anything, Qt needs these events as well.
+    return false;
+}
+
+X11::CapabilitiesPtr X11::capabilities()
+{
+    {
+        const QMutexLocker locker(&g_x11CapabilitiesData()->mutex);
+        if (g_x11CapabilitiesData()->current) {
+            return g_x11CapabilitiesData()->current;
+        }
+    }
+    // First use. Racing threads may probe twice, which is harmless.
+    Capabilities caps = probeCurrentBackend();
+    if (!caps.valid) {
+        // Don't cache the failure, the application may not have a connection yet.
+        static const auto invalid = std::make_shared<const Capabilities>();
+        return invalid;
+    }
+    publish(std::move(caps));
+    const QMutexLocker locker(&g_x11CapabilitiesData()->mutex);
+    return g_x11CapabilitiesData()->current;
+}
+
+void X11::resetCapabilities()
+{
+    const QMutexLocker locker(&g_x11CapabilitiesData()->mutex);
+    g_x11CapabilitiesData()->current = nullptr;
+}
+
+void X11::watchCapabilities()
+{
+    if (!qApp || !Utils::isXcbPlatform() || !capabilities()->valid) {
+        return;
+    }
+    // Relies on Qt selecting PropertyChangeMask on the root window, which it does
+    // for its own needs. Changing the root window's event mask ourselves would
+    // replace Qt's mask, as event masks are per client.
+    const QMutexLocker locker(&g_x11CapabilitiesData()->mutex);
+    if (g_x11CapabilitiesData()->watcher) {
+        return;
+    }
+    g_x11CapabilitiesData()->watcher = std::make_unique<CapabilityWatcher>();
+    qApp->installNativeEventFilter(g_x11CapabilitiesData()->watcher.get());
+}
+
+xcb_atom_t X11::knownAtom(const char *name)
+{
+    Q_ASSERT(name);
+    if (!name) {
+        return XCB_NONE;
+    }
+    for (int i = 0; i != kAtomCount; ++i) {
+        if (std::strcmp(name, kAtomNames.at(i)) == 0) {
+            return capabilities()->atoms.at(i);
+        }
+    }
+    return XCB_NONE;
+}
+
+FRAMELESSHELPER_END_NAMESPACE
+
+#endif // (defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID))
@@ -0,0 +1,165 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021-2023 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "x11property_p.h"
+
+#if (defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID))
+
+#include <QtCore/qloggingcategory.h>
+#include <cstring>
+#include <utility>
+
+FRAMELESSHELPER_BEGIN_NAMESPACE
+
+#if FRAMELESSHELPER_CONFIG(debug_output)
+[[maybe_unused]] static Q_LOGGING_CATEGORY(lcX11Property, "wangwenx190.framelesshelper.core.x11property")
+#  define INFO qCInfo(lcX11Property)
+#  define DEBUG qCDebug(lcX11Property)
+#  define WARNING qCWarning(lcX11Property)
+#  define CRITICAL qCCritical(lcX11Property)
+#else
+#  define INFO QT_NO_QDEBUG_MACRO()
+#  define DEBUG QT_NO_QDEBUG_MACRO()
+#  define WARNING QT_NO_QDEBUG_MACRO()
+#  define CRITICAL QT_NO_QDEBUG_MACRO()
+#endif
+
+using namespace Global;
+
+X11::PropertyReply::PropertyReply(xcb_get_property_reply_t *reply) noexcept : m_reply(reply)
+{
+}
+
+X11::PropertyReply::~PropertyReply() = default;
+
+X11::PropertyReply X11::PropertyReply::create(const xcb_atom_t type, const quint8 format,
+    const void *data, const quint32 count, const quint32 bytesAfter)
+{
+    Q_ASSERT((format == 0) || (format == 8) || (format == 16) || (format == 32));
+    const quint32 size = ((data && (format != 0)) ? (count * (format / 8)) : 0);
+    // The same layout as the replies of xcb: the value directly follows the header.
+    const auto reply = static_cast<xcb_get_property_reply_t *>(std::calloc(1, sizeof(xcb_get_property_reply_t) + size));
+    if (!reply) {
+        return {};
+    }
+    reply->response_type = 1; // XCB_REPLY
+    reply->format = format;
+    reply->length = ((size + 3) / 4);
+    reply->type = type;
+    reply->bytes_after = bytesAfter;
+    reply->value_len = ((size > 0) ? count : 0);
+    if (size > 0) {
+        std::memcpy(reply + 1, data, size);
+    }
+    return PropertyReply(reply);
+}
+
+int X11::PropertyReply::byteSize() const noexcept
+{
+    if (!m_reply) {
+        return 0;
+    }
+    return int(m_reply->value_len * (m_reply->format / 8));
+}
+
+const char *X11::PropertyReply::rawData() const noexcept
+{
+    // What xcb_get_property_value() does, without going through the loaded library.
+    return (m_reply ? reinterpret_cast<const char *>(m_reply.get() + 1) : nullptr);
+}
+
+QByteArray X11::PropertyReply::toByteArray() const
+{
+    const int size = byteSize();
+    if (size <= 0) {
+        return {};
+    }
+    return QByteArray(rawData(), size);
+}
+
+X11::PropertyFuture::PropertyFuture(xcb_connection_t *connection, const xcb_get_property_cookie_t cookie) noexcept
+    : m_connection(connection), m_cookie(cookie)
+{
+}
+
+X11::PropertyFuture::PropertyFuture(PropertyReply &&reply) noexcept : m_reply(std::move(reply))
+{
+}
+
+X11::PropertyFuture::PropertyFuture(PropertyFuture &&other) noexcept
+    : m_connection(std::exchange(other.m_connection, nullptr))
+    , m_cookie(other.m_cookie)
+    , m_reply(std::move(other.m_reply))
+{
+}
+
+X11::PropertyFuture &X11::PropertyFuture::operator=(PropertyFuture &&other) noexcept
+{
+    if (this != &other) {
+        discard();
+        m_connection = std::exchange(other.m_connection, nullptr);
+        m_cookie = other.m_cookie;
+        m_reply = std::move(other.m_reply);
+    }
+    return *this;
+}
+
+X11::PropertyFuture::~PropertyFuture()
+{
+    discard();
+}
+
+void X11::PropertyFuture::discard() noexcept
+{
+    if (!m_connection) {
+        return;
+    }
+    // Otherwise the reply would stay in the connection's queue forever.
+    xcb_discard_reply(m_connection, m_cookie.sequence);
+    m_connection = nullptr;
+}
+
+X11::PropertyReply X11::PropertyFuture::get()
+{
+    if (m_connection) {
+        m_reply = PropertyReply(xcb_get_property_reply(std::exchange(m_connection, nullptr), m_cookie, nullptr));
+    }
+    return std::move(m_reply);
+}
+
+X11::PropertyFuture X11::requestProperty(xcb_connection_t *connection, const xcb_window_t window,
+    const xcb_atom_t prop, const xcb_atom_t type, const quint32 offset, const quint32 length)
+{
+    Q_ASSERT(connection);
+    Q_ASSERT(window);
+    Q_ASSERT(prop != XCB_NONE);
+    if (!connection || !window || (prop == XCB_NONE)) {
+        return {};
+    }
+    return PropertyFuture(connection, xcb_get_property(connection, false, window, prop, type, offset, length));
+}
+
+FRAMELESSHELPER_END_NAMESPACE
+
+#endif // (defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID))
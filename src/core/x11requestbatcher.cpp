@@ -0,0 +1,208 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021-2023 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "x11requestbatcher_p.h"
+
+#if (defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID))
+
+#include "framelessstatistics_p.h"
+#include "x11backend_p.h"
+#include <QtCore/qcoreapplication.h>
+#include <QtCore/qloggingcategory.h>
+#include <QtCore/qmutex.h>
+#include <QtCore/qtimer.h>
+#include <algorithm>
+#include <utility>
+
+FRAMELESSHELPER_BEGIN_NAMESPACE
+
+#if FRAMELESSHELPER_CONFIG(debug_output)
+[[maybe_unused]] static Q_LOGGING_CATEGORY(lcX11RequestBatcher, "wangwenx190.framelesshelper.core.x11requestbatcher")
+#  define INFO qCInfo(lcX11RequestBatcher)
+#  define DEBUG qCDebug(lcX11RequestBatcher)
+#  define WARNING qCWarning(lcX11RequestBatcher)
+#  define CRITICAL qCCritical(lcX11RequestBatcher)
+#else
+#  define INFO QT_NO_QDEBUG_MACRO()
+#  define DEBUG QT_NO_QDEBUG_MACRO()
+#  define WARNING QT_NO_QDEBUG_MACRO()
+#  define CRITICAL QT_NO_QDEBUG_MACRO()
+#endif
+
+using namespace Global;
+
+struct PendingPropertyWrite
+{
+    WId windowId = 0;
+    xcb_atom_t prop = XCB_NONE;
+    bool remove = false;
+    xcb_atom_t type = XCB_NONE;
+    quint8 format = 0;
+    quint32 count = 0;
+    QByteArray data = {};
+};
+
+struct X11RequestBatcherData
+{
+    QMutex mutex{};
+    // Usually only a handful of entries, a linear search beats any hash here.
+    QList<PendingPropertyWrite> queue = {};
+    bool flushScheduled = false;
+};
+
+Q_GLOBAL_STATIC(X11RequestBatcherData, g_x11RequestBatcherData)
+
+// Must be called with the mutex locked. Returns whether anything was sent.
+[[nodiscard]] static inline bool submitLocked(X11::Backend *backend)
+{
+    Q_ASSERT(backend);
+    if (!backend) {
+        return false;
+    }
+    QList<PendingPropertyWrite> &queue = g_x11RequestBatcherData()->queue;
+    if (queue.isEmpty()) {
+        return false;
+    }
+    for (auto &&write : std::as_const(queue)) {
+        if (write.remove) {
+            backend->deleteProperty(write.windowId, write.prop);
+        } else {
+            backend->changeProperty(write.windowId, write.prop, write.type,
+                write.format, write.data.constData(), write.count);
+        }
+    }
+    queue.clear();
+    return true;
+}
+
+static inline void flushPending()
+{
+    X11::Backend * const backend = X11::backend();
+    const QMutexLocker locker(&g_x11RequestBatcherData()->mutex);
+    g_x11RequestBatcherData()->flushScheduled = false;
+    if (!backend) {
+        g_x11RequestBatcherData()->queue.clear();
+        return;
+    }
+    if (!submitLocked(backend)) {
+        return;
+    }
+    backend->flush();
+}
+
+static inline void enqueue(PendingPropertyWrite &&write)
+{
+    bool schedule = false;
+    {
+        const QMutexLocker locker(&g_x11RequestBatcherData()->mutex);
+        X11RequestBatcherData * const data = g_x11RequestBatcherData();
+        const auto it = std::find_if(data->queue.begin(), data->queue.end(), [&write](const PendingPropertyWrite &pending){
+            return ((pending.windowId == write.windowId) && (pending.prop == write.prop));
+        });
+        if (it == data->queue.end()) {
+            data->queue.append(std::move(write));
+        } else {
+            // Only the final value of a property is observable, drop the earlier one.
+            *it = std::move(write);
+            Stats::increment(Stats::Counter::X11RequestsMerged);
+        }
+        schedule = !std::exchange(data->flushScheduled, true);
+    }
+    if (!schedule) {
+        return;
+    }
+    if (!qApp) {
+        // No event loop to wait for.
+        flushPending();
+        return;
+    }
+    // Runs on the next pass of the event loop, after everything the current
+    // iteration has queued.
+    QTimer::singleShot(0, qApp, [](){ flushPending(); });
+}
+
+void X11::queuePropertyChange(const WId windowId, const xcb_atom_t prop,
+    const xcb_atom_t type, const quint8 format, const void *data, const quint32 count)
+{
+    Q_ASSERT(windowId);
+    Q_ASSERT(prop != XCB_NONE);
+    Q_ASSERT(type != XCB_NONE);
+    Q_ASSERT((format == 8) || (format == 16) || (format == 32));
+    if (!windowId || (prop == XCB_NONE) || (type == XCB_NONE)
+        || ((format != 8) && (format != 16) && (format != 32))) {
+        return;
+    }
+    PendingPropertyWrite write = {};
+    write.windowId = windowId;
+    write.prop = prop;
+    write.type = type;
+    write.format = format;
+    write.count = (data ? count : 0);
+    if (data && (count > 0)) {
+        write.data = QByteArray(static_cast<const char *>(data), int(count * (format / 8)));
+    }
+    enqueue(std::move(write));
+}
+
+void X11::queuePropertyDeletion(const WId windowId, const xcb_atom_t prop)
+{
+    Q_ASSERT(windowId);
+    Q_ASSERT(prop != XCB_NONE);
+    if (!windowId || (prop == XCB_NONE)) {
+        return;
+    }
+    PendingPropertyWrite write = {};
+    write.windowId = windowId;
+    write.prop = prop;
+    write.remove = true;
+    enqueue(std::move(write));
+}
+
+void X11::submitPendingRequests()
+{
+    Backend * const backend = X11::backend();
+    if (!backend) {
+        return;
+    }
+    const QMutexLocker locker(&g_x11RequestBatcherData()->mutex);
+    std::ignore = submitLocked(backend);
+}
+
+void X11::flushNow()
+{
+    Backend * const backend = X11::backend();
+    if (!backend) {
+        return;
+    }
+    {
+        const QMutexLocker locker(&g_x11RequestBatcherData()->mutex);
+        std::ignore = submitLocked(backend);
+    }
+    // The scheduled flush, if any, will find an empty queue and do nothing.
+    backend->flush();
+}
+
+FRAMELESSHELPER_END_NAMESPACE
+
+#endif // (defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID))
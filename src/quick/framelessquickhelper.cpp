@@ -34,6 +34,7 @@
 #include <FramelessHelper/Core/utils.h>
 #include <FramelessHelper/Core/private/framelessconfig_p.h>
 #include <FramelessHelper/Core/private/framelesshelpercore_global_p.h>
+#include <FramelessHelper/Core/private/tracing_p.h>
 #ifdef Q_OS_WINDOWS
 #  include <FramelessHelper/Core/private/winverhelper_p.h>
 #endif // Q_OS_WINDOWS
@@ -72,6 +73,9 @@ FRAMELESSHELPER_BEGIN_NAMESPACE
 
 using namespace Global;
 
+// How long a window that is being shown may take to be exposed for the first time.
+static constexpr const quint32 kExposeTimeout = 500; // ms
+
 struct FramelessQuickHelperData
 {
     bool ready = false;
@@ -84,6 +88,7 @@ struct FramelessQuickHelperData
     QPointer<QQuickItem> maximizeButton = nullptr;
     QPointer<QQuickItem> closeButton = nullptr;
     QList<QRect> hitTestVisibleRects = {};
+    QList<QPointer<QQuickItem>> forceRepaintOnDprChangeItems = {};
 };
 
 using FramelessQuickHelperInternal = QHash<WId, FramelessQuickHelperData>;
@@ -178,21 +183,69 @@ void FramelessQuickHelperPrivate::attach()
     data->params = params;
     data->ready = true;
 
-    // We have to wait for a little time before moving the top level window
-    // , because the platform window may not finish initializing by the time
-    // we reach here, and all the modifications from the Qt side will be lost
-    // due to QPA will reset the position and size of the window during it's
-    // initialization process.
-    QTimer::singleShot(qpaWaitTime, this, [this, q](){
-        qpaReady = true;
-        if (FramelessConfig::instance()->isSet(Option::CenterWindowBeforeShow)) {
+    // Place the window before the platform window gets mapped, so that it shows up at
+    // the right position directly instead of jumping there after being shown.
+    if (!window->isVisible() && FramelessConfig::instance()->isSet(Option::CenterWindowBeforeShow)) {
+        const QSize windowSize = window->size();
+        if (!windowSize.isEmpty() && (windowSize != kDefaultWindowSize)) {
             q->moveWindowToDesktopCenter();
+            centeredBeforeShow = true;
         }
-        if (FramelessConfig::instance()->isSet(Option::EnableBlurBehindWindow)) {
-            q->setBlurBehindWindowEnabled(true);
+    }
+
+    // The platform window may not finish initializing by the time we reach here, and
+    // all the modifications from the Qt side will be lost due to QPA will reset the
+    // position and size of the window during it's initialization process. So if the
+    // window is being shown right now, we wait until it has been exposed for the first
+    // time, but never longer than the timeout (the window manager may keep it unmapped).
+    // There's nothing to wait for if it's exposed already, or not shown at all (yet).
+    const bool showing = (window->isVisible() && !window->isExposed()
+        && (window->visibility() != QWindow::Minimized));
+    if (showing) {
+        window->installEventFilter(this);
+    }
+    const quint32 timeout = (showing ? qMax(qpaWaitTime, kExposeTimeout) : qpaWaitTime);
+    QTimer::singleShot(timeout, this, [this](){ markReady(); });
+}
+
+void FramelessQuickHelperPrivate::markReady()
+{
+    if (qpaReady) {
+        return;
+    }
+    const Trace::Span span("FramelessQuickHelper::markReady");
+    Q_Q(FramelessQuickHelper);
+    QQuickWindow * const window = q->window();
+    if (!window) {
+        return;
+    }
+    qpaReady = true;
+    window->removeEventFilter(this);
+    if (!centeredBeforeShow && FramelessConfig::instance()->isSet(Option::CenterWindowBeforeShow)) {
+        q->moveWindowToDesktopCenter();
+    }
+    if (FramelessConfig::instance()->isSet(Option::EnableBlurBehindWindow)) {
+        q->setBlurBehindWindowEnabled(true);
+    }
+    emitSignalForAllInstances("ready");
+}
+
+bool FramelessQuickHelperPrivate::eventFilter(QObject *object, QEvent *event)
+{
+    Q_ASSERT(object);
+    Q_ASSERT(event);
+    if (!object || !event) {
+        return false;
+    }
+    if (object->isWindowType()) {
+        const QEvent::Type type = event->type();
+        // Don't do anything heavy inside the expose event itself. A window that
+        // gets hidden again before being exposed won't be exposed any time soon.
+        if (((type == QEvent::Expose) && static_cast<QWindow *>(object)->isExposed()) || (type == QEvent::Hide)) {
+            QTimer::singleShot(0, this, [this](){ markReady(); });
         }
-        emitSignalForAllInstances("ready");
-    });
+    }
+    return QObject::eventFilter(object, event);
 }
 
 void FramelessQuickHelperPrivate::detach()
@@ -369,7 +422,7 @@ void FramelessQuickHelperPrivate::repaintAllChildren(const quint32 delay) const
     if (!window) {
         return;
     }
-    const auto update = [window]() -> void {
+    const auto update = [this, window]() -> void {
 #ifdef Q_OS_WINDOWS
         // Sync the internal window frame margins with the latest DPI, otherwise
         // we will get wrong window sizes after the DPI change.
@@ -379,15 +432,17 @@ void FramelessQuickHelperPrivate::repaintAllChildren(const quint32 delay) const
         if (!window->isVisible()) {
             return;
         }
+        // The whole scene will be re-rendered in the next frame, only the items
+        // registered through setForceRepaintOnDprChange() need an extra "update()" call.
         window->requestUpdate();
-        const QList<QQuickItem *> items = window->findChildren<QQuickItem *>();
-        if (items.isEmpty()) {
+        const FramelessQuickHelperData * const data = getWindowData();
+        if (!data) {
             return;
         }
-        for (auto &&item : std::as_const(items)) {
+        for (auto &&item : std::as_const(data->forceRepaintOnDprChangeItems)) {
             // Only items with the "QQuickItem::ItemHasContents" flag enabled are allowed to call "update()".
             // And don't repaint the item if it's hidden.
-            if ((item->flags() & QQuickItem::ItemHasContents) && item->isVisible()) {
+            if (item && (item->flags() & QQuickItem::ItemHasContents) && item->isVisible()) {
                 item->update();
             }
         }
@@ -680,6 +735,23 @@ void FramelessQuickHelper::setHitTestVisible_item(QQuickItem *item, const bool v
     }
 }
 
+void FramelessQuickHelper::setForceRepaintOnDprChange(QQuickItem *item, const bool value)
+{
+    Q_ASSERT(item);
+    if (!item) {
+        return;
+    }
+    Q_D(FramelessQuickHelper);
+    FramelessQuickHelperData *data = d->getWindowDataMutable();
+    if (!data) {
+        return;
+    }
+    data->forceRepaintOnDprChangeItems.removeAll(item);
+    if (value) {
+        data->forceRepaintOnDprChangeItems.append(item);
+    }
+}
+
 void FramelessQuickHelper::setHitTestVisible_rect(const QRect &rect, const bool visible)
 {
     Q_ASSERT(rect.isValid());
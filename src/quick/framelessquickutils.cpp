@@ -25,6 +25,7 @@
 #include "framelessquickutils.h"
 #include <FramelessHelper/Core/framelessmanager.h>
 #include <FramelessHelper/Core/utils.h>
+#include <FramelessHelper/Core/private/framelessmanager_p.h>
 #ifdef Q_OS_WINDOWS
 #  include <FramelessHelper/Core/private/winverhelper_p.h>
 #endif // Q_OS_WINDOWS
@@ -93,12 +94,12 @@ void FramelessQuickUtils::setOverrideTheme(const QuickGlobal::SystemTheme theme)
 
 QColor FramelessQuickUtils::systemAccentColor() const
 {
-    return Utils::getAccentColor();
+    return FramelessManagerPrivate::currentThemeSnapshot()->accentColor;
 }
 
 bool FramelessQuickUtils::titleBarColorized() const
 {
-    return Utils::isTitleBarColorized();
+    return FramelessManagerPrivate::currentThemeSnapshot()->titleBarColorized;
 }
 
 QColor FramelessQuickUtils::defaultSystemLightColor() const
@@ -134,7 +135,7 @@ QColor FramelessQuickUtils::defaultSystemCloseButtonBackgroundColor() const
 QColor FramelessQuickUtils::getSystemButtonBackgroundColor(const QuickGlobal::SystemButtonType button,
                                                            const QuickGlobal::ButtonState state)
 {
-    return Utils::calculateSystemButtonBackgroundColor(
+    return FramelessManagerPrivate::currentThemeSnapshot()->systemButtonBackgroundColor(
         FRAMELESSHELPER_ENUM_QUICK_TO_CORE(SystemButtonType, button),
         FRAMELESSHELPER_ENUM_QUICK_TO_CORE(ButtonState, state));
 }
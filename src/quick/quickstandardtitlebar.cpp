@@ -492,10 +492,17 @@ void QuickStandardTitleBar::initialize()
     setAntialiasing(true);
 
     m_chromePalette = new QuickChromePalette(this);
-    connect(m_chromePalette, &ChromePalette::titleBarColorChanged,
-        this, &QuickStandardTitleBar::updateTitleBarColor);
-    connect(m_chromePalette, &ChromePalette::chromeButtonColorChanged,
-        this, &QuickStandardTitleBar::updateChromeButtonColor);
+    // One notification per palette change, no matter how many colors have changed.
+    // The scene graph already renders at most once per frame, so no need to schedule anything.
+    connect(m_chromePalette, &ChromePalette::changed, this, [this](const ChromePalette::Changes changes){
+        using Flag = ChromePalette::ChangeFlag;
+        if (!!(changes & Flag::TitleBarColors)) {
+            updateTitleBarColor();
+        }
+        if (!!(changes & (Flag::ChromeButtonColors | Flag::TitleBarActiveForegroundColor | Flag::TitleBarInactiveForegroundColor))) {
+            updateChromeButtonColor();
+        }
+    });
 
     QQuickPen * const b = border();
     b->setWidth(0.0);
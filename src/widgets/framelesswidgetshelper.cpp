@@ -37,6 +37,7 @@
 #include <FramelessHelper/Core/utils.h>
 #include <FramelessHelper/Core/private/framelessconfig_p.h>
 #include <FramelessHelper/Core/private/framelesshelpercore_global_p.h>
+#include <FramelessHelper/Core/private/tracing_p.h>
 #include <QtCore/qhash.h>
 #include <QtCore/qtimer.h>
 #include <QtCore/qeventloop.h>
@@ -47,6 +48,7 @@
 #include <QtGui/qevent.h>
 #include <QtWidgets/qwidget.h>
 #include <QtWidgets/qapplication.h>
+#include <QtWidgets/qstyle.h>
 
 #ifndef QWIDGETSIZE_MAX
 #  define QWIDGETSIZE_MAX ((1 << 24) - 1)
@@ -71,6 +73,9 @@ FRAMELESSHELPER_BEGIN_NAMESPACE
 
 using namespace Global;
 
+// How long a window that is being shown may take to be exposed for the first time.
+static constexpr const quint32 kExposeTimeout = 500; // ms
+
 struct FramelessWidgetsHelperData
 {
     bool ready = false;
@@ -83,6 +88,8 @@ struct FramelessWidgetsHelperData
     QPointer<QWidget> maximizeButton = nullptr;
     QPointer<QWidget> closeButton = nullptr;
     QList<QRect> hitTestVisibleRects = {};
+    QList<QPointer<QWidget>> repolishOnDprChangeWidgets = {};
+    QList<QPointer<QWidget>> forceRepaintOnDprChangeWidgets = {};
 };
 
 using FramelessWidgetsHelperInternal = QHash<WId, FramelessWidgetsHelperData>;
@@ -159,8 +166,24 @@ static inline void forceWidgetRepaint(QWidget * const widget)
     }
     // Let's try again with the ordinary way.
     widget->update();
-    // ### TODO: I observed the font size is often wrong after DPI changes,
-    // do we need to refresh the font settings here as well?
+}
+
+// For widgets whose style metrics depend on the DPR, such as pixmap based styles.
+static inline void repolishWidget(QWidget * const widget)
+{
+    Q_ASSERT(widget);
+    if (!widget) {
+        return;
+    }
+    // Hidden widgets will be repolished anyway once they become visible.
+    if (!widget->isVisible()) {
+        return;
+    }
+    QStyle * const style = widget->style();
+    style->unpolish(widget);
+    style->polish(widget);
+    widget->updateGeometry();
+    widget->update();
 }
 
 FramelessWidgetsHelperPrivate::FramelessWidgetsHelperPrivate(FramelessWidgetsHelper *q) : QObject(q)
@@ -329,13 +352,36 @@ void FramelessWidgetsHelperPrivate::repaintAllChildren(const quint32 delay) cons
         return;
     }
     const auto update = [this]() -> void {
-        forceWidgetRepaint(window);
-        const QList<QWidget *> widgets = window->findChildren<QWidget *>();
-        if (widgets.isEmpty()) {
+#ifdef Q_OS_WINDOWS
+        // Don't crash if the QWindow instance has not been created yet.
+        if (QWindow * const windowHandle = window->windowHandle()) {
+            // Sync the internal window frame margins with the latest DPI, otherwise
+            // we will get wrong window sizes after the DPI change.
+            std::ignore = Utils::updateInternalWindowFrameMargins(windowHandle, true);
+        }
+#endif // Q_OS_WINDOWS
+        // Don't do unnecessary repaints if the window is hidden.
+        if (!window->isVisible()) {
             return;
         }
-        for (auto &&widget : std::as_const(widgets)) {
-            forceWidgetRepaint(widget);
+        // Updating the top level window repaints all its children as well, there's
+        // no need to touch every single widget (and trigger relayouts) anymore.
+        window->update();
+        // Only the widgets registered through setRepolishOnDprChange() and
+        // setForceRepaintOnDprChange() need more than that.
+        const FramelessWidgetsHelperData * const data = getWindowData();
+        if (!data) {
+            return;
+        }
+        for (auto &&widget : std::as_const(data->repolishOnDprChangeWidgets)) {
+            if (widget) {
+                repolishWidget(widget);
+            }
+        }
+        for (auto &&widget : std::as_const(data->forceRepaintOnDprChangeWidgets)) {
+            if (widget && widget->isVisible()) {
+                forceWidgetRepaint(widget);
+            }
         }
     };
     if (delay > 0) {
@@ -441,22 +487,69 @@ void FramelessWidgetsHelperPrivate::attach()
     data->params = params;
     data->ready = true;
 
-    // We have to wait for a little time before moving the top level window
-    // , because the platform window may not finish initializing by the time
-    // we reach here, and all the modifications from the Qt side will be lost
-    // due to QPA will reset the position and size of the window during it's
-    // initialization process.
-    QTimer::singleShot(qpaWaitTime, this, [this, q](){
-        qpaReady = true;
-        if (FramelessConfig::instance()->isSet(Option::CenterWindowBeforeShow)) {
+    // Place the window before the platform window gets mapped, so that it shows up at
+    // the right position directly instead of jumping there after being shown.
+    if (!window->isVisible() && FramelessConfig::instance()->isSet(Option::CenterWindowBeforeShow)) {
+        const QSize windowSize = window->size();
+        if (!windowSize.isEmpty() && (windowSize != kDefaultWindowSize)) {
             q->moveWindowToDesktopCenter();
+            centeredBeforeShow = true;
         }
-        if (FramelessConfig::instance()->isSet(Option::EnableBlurBehindWindow)) {
-            q->setBlurBehindWindowEnabled(true);
+    }
+
+    // The platform window may not finish initializing by the time we reach here, and
+    // all the modifications from the Qt side will be lost due to QPA will reset the
+    // position and size of the window during it's initialization process. So if the
+    // window is being shown right now, we wait until it has been exposed for the first
+    // time, but never longer than the timeout (the window manager may keep it unmapped).
+    // There's nothing to wait for if it's exposed already, or not shown at all (yet).
+    QWindow * const windowHandle = window->windowHandle();
+    const bool showing = (windowHandle && window->isVisible() && !windowHandle->isExposed()
+        && !window->isMinimized());
+    if (showing) {
+        windowHandle->installEventFilter(this);
+    }
+    const quint32 timeout = (showing ? qMax(qpaWaitTime, kExposeTimeout) : qpaWaitTime);
+    QTimer::singleShot(timeout, this, [this](){ markReady(); });
+}
+
+void FramelessWidgetsHelperPrivate::markReady()
+{
+    if (qpaReady || !window) {
+        return;
+    }
+    const Trace::Span span("FramelessWidgetsHelper::markReady");
+    qpaReady = true;
+    if (QWindow * const windowHandle = window->windowHandle()) {
+        windowHandle->removeEventFilter(this);
+    }
+    Q_Q(FramelessWidgetsHelper);
+    if (!centeredBeforeShow && FramelessConfig::instance()->isSet(Option::CenterWindowBeforeShow)) {
+        q->moveWindowToDesktopCenter();
+    }
+    if (FramelessConfig::instance()->isSet(Option::EnableBlurBehindWindow)) {
+        q->setBlurBehindWindowEnabled(true);
+    }
+    emitSignalForAllInstances("windowChanged");
+    emitSignalForAllInstances("ready");
+}
+
+bool FramelessWidgetsHelperPrivate::eventFilter(QObject *object, QEvent *event)
+{
+    Q_ASSERT(object);
+    Q_ASSERT(event);
+    if (!object || !event) {
+        return false;
+    }
+    if (object->isWindowType()) {
+        const QEvent::Type type = event->type();
+        // Don't do anything heavy inside the expose event itself. A window that
+        // gets hidden again before being exposed won't be exposed any time soon.
+        if (((type == QEvent::Expose) && static_cast<QWindow *>(object)->isExposed()) || (type == QEvent::Hide)) {
+            QTimer::singleShot(0, this, [this](){ markReady(); });
         }
-        emitSignalForAllInstances("windowChanged");
-        emitSignalForAllInstances("ready");
-    });
+    }
+    return QObject::eventFilter(object, event);
 }
 
 void FramelessWidgetsHelperPrivate::detach()
@@ -939,6 +1032,40 @@ void FramelessWidgetsHelper::setHitTestVisible(QWidget *widget, const bool visib
     }
 }
 
+void FramelessWidgetsHelper::setRepolishOnDprChange(QWidget *widget, const bool value)
+{
+    Q_ASSERT(widget);
+    if (!widget) {
+        return;
+    }
+    Q_D(FramelessWidgetsHelper);
+    FramelessWidgetsHelperData *data = d->getWindowDataMutable();
+    if (!data) {
+        return;
+    }
+    data->repolishOnDprChangeWidgets.removeAll(widget);
+    if (value) {
+        data->repolishOnDprChangeWidgets.append(widget);
+    }
+}
+
+void FramelessWidgetsHelper::setForceRepaintOnDprChange(QWidget *widget, const bool value)
+{
+    Q_ASSERT(widget);
+    if (!widget) {
+        return;
+    }
+    Q_D(FramelessWidgetsHelper);
+    FramelessWidgetsHelperData *data = d->getWindowDataMutable();
+    if (!data) {
+        return;
+    }
+    data->forceRepaintOnDprChangeWidgets.removeAll(widget);
+    if (value) {
+        data->forceRepaintOnDprChangeWidgets.append(widget);
+    }
+}
+
 void FramelessWidgetsHelper::setHitTestVisible(const QRect &rect, const bool visible)
 {
     Q_ASSERT(rect.isValid());
@@ -85,6 +85,44 @@ QSize StandardSystemButtonPrivate::getRecommendedButtonSize()
     return kDefaultSystemButtonSize;
 }
 
+bool StandardSystemButtonPrivate::setColors(const QColor &activeForeground, const QColor &inactiveForeground,
+    const QColor &normal, const QColor &hover, const QColor &press, const bool isActive)
+{
+    Q_Q(StandardSystemButton);
+    bool changed = false;
+    if (activeForeground.isValid() && (activeForegroundColor != activeForeground)) {
+        activeForegroundColor = activeForeground;
+        changed = true;
+        Q_EMIT q->activeForegroundColorChanged();
+    }
+    if (inactiveForeground.isValid() && (inactiveForegroundColor != inactiveForeground)) {
+        inactiveForegroundColor = inactiveForeground;
+        changed = true;
+        Q_EMIT q->inactiveForegroundColorChanged();
+    }
+    if (normal.isValid() && (normalColor != normal)) {
+        normalColor = normal;
+        changed = true;
+        Q_EMIT q->normalColorChanged();
+    }
+    if (hover.isValid() && (hoverColor != hover)) {
+        hoverColor = hover;
+        changed = true;
+        Q_EMIT q->hoverColorChanged();
+    }
+    if (press.isValid() && (pressColor != press)) {
+        pressColor = press;
+        changed = true;
+        Q_EMIT q->pressColorChanged();
+    }
+    if (active != isActive) {
+        active = isActive;
+        changed = true;
+        Q_EMIT q->activeChanged();
+    }
+    return changed;
+}
+
 StandardSystemButton::StandardSystemButton(QWidget *parent)
     : QPushButton(parent), d_ptr(new StandardSystemButtonPrivate(this))
 {
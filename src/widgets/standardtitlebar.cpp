@@ -29,9 +29,12 @@
 
 #if FRAMELESSHELPER_CONFIG(system_button)
 #  include "standardsystembutton.h"
+#  include "standardsystembutton_p.h"
 #endif
 #include "framelesswidgetshelper.h"
 #include <FramelessHelper/Core/utils.h>
+#include <FramelessHelper/Core/private/repaintscheduler_p.h>
+#include <FramelessHelper/Core/private/tracing_p.h>
 #include <QtCore/qcoreevent.h>
 #include <QtCore/qtimer.h>
 #include <QtCore/qloggingcategory.h>
@@ -282,8 +285,7 @@ void StandardTitleBarPrivate::updateMaximizeButton()
 
 void StandardTitleBarPrivate::updateTitleBarColor()
 {
-    Q_Q(StandardTitleBar);
-    q->update();
+    scheduleRepaint();
 }
 
 void StandardTitleBarPrivate::updateChromeButtonColor()
@@ -295,27 +297,39 @@ void StandardTitleBarPrivate::updateChromeButtonColor()
     const QColor normal = chromePalette->chromeButtonNormalColor();
     const QColor hover = chromePalette->chromeButtonHoverColor();
     const QColor press = chromePalette->chromeButtonPressColor();
-    minimizeButton->setActiveForegroundColor(activeForeground);
-    minimizeButton->setInactiveForegroundColor(inactiveForeground);
-    minimizeButton->setNormalColor(normal);
-    minimizeButton->setHoverColor(hover);
-    minimizeButton->setPressColor(press);
-    minimizeButton->setActive(active);
-    maximizeButton->setActiveForegroundColor(activeForeground);
-    maximizeButton->setInactiveForegroundColor(inactiveForeground);
-    maximizeButton->setNormalColor(normal);
-    maximizeButton->setHoverColor(hover);
-    maximizeButton->setPressColor(press);
-    maximizeButton->setActive(active);
-    closeButton->setActiveForegroundColor(activeForeground);
-    closeButton->setInactiveForegroundColor(inactiveForeground);
-    closeButton->setNormalColor(chromePalette->closeButtonNormalColor());
-    closeButton->setHoverColor(chromePalette->closeButtonHoverColor());
-    closeButton->setPressColor(chromePalette->closeButtonPressColor());
-    closeButton->setActive(active);
+    // The buttons are children of the title bar, repainting the title bar once
+    // is enough, no need to let every single setter trigger its own repaint.
+    const bool minimizeChanged = StandardSystemButtonPrivate::get(minimizeButton)->setColors(
+        activeForeground, inactiveForeground, normal, hover, press, active);
+    const bool maximizeChanged = StandardSystemButtonPrivate::get(maximizeButton)->setColors(
+        activeForeground, inactiveForeground, normal, hover, press, active);
+    const bool closeChanged = StandardSystemButtonPrivate::get(closeButton)->setColors(
+        activeForeground, inactiveForeground, chromePalette->closeButtonNormalColor(),
+        chromePalette->closeButtonHoverColor(), chromePalette->closeButtonPressColor(), active);
+    if (minimizeChanged || maximizeChanged || closeChanged) {
+        scheduleRepaint();
+    }
 #endif
 }
 
+void StandardTitleBarPrivate::handleChromePaletteChange(const ChromePalette::Changes changes)
+{
+    using Flag = ChromePalette::ChangeFlag;
+    if (!!(changes & Flag::TitleBarColors)) {
+        updateTitleBarColor();
+    }
+    // The system buttons use the title bar foreground colors as well.
+    if (!!(changes & (Flag::ChromeButtonColors | Flag::TitleBarActiveForegroundColor | Flag::TitleBarInactiveForegroundColor))) {
+        updateChromeButtonColor();
+    }
+}
+
+void StandardTitleBarPrivate::scheduleRepaint()
+{
+    Q_Q(StandardTitleBar);
+    RepaintScheduler::instance()->schedule(q, [q](){ q->update(); });
+}
+
 void StandardTitleBarPrivate::retranslateUi()
 {
 #if (!defined(Q_OS_MACOS) && FRAMELESSHELPER_CONFIG(system_button))
@@ -361,10 +375,8 @@ void StandardTitleBarPrivate::initialize()
     Q_Q(StandardTitleBar);
     window = q->window();
     chromePalette = new ChromePalette(this);
-    connect(chromePalette, &ChromePalette::titleBarColorChanged,
-        this, &StandardTitleBarPrivate::updateTitleBarColor);
-    connect(chromePalette, &ChromePalette::chromeButtonColorChanged,
-        this, &StandardTitleBarPrivate::updateChromeButtonColor);
+    connect(chromePalette, &ChromePalette::changed,
+        this, &StandardTitleBarPrivate::handleChromePaletteChange);
     connect(window, &QWidget::windowIconChanged, this, [q](const QIcon &icon){
         Q_UNUSED(icon);
         q->update();
@@ -534,6 +546,7 @@ ChromePalette *StandardTitleBar::chromePalette() const
 
 void StandardTitleBar::paintEvent(QPaintEvent *event)
 {
+    const Trace::Span span("StandardTitleBar::paintEvent");
     Q_ASSERT(event);
     if (!event) {
         return;
@@ -0,0 +1,134 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021-2023 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <QtTest/qtest.h>
+#include <QtWidgets/qgridlayout.h>
+#include <QtWidgets/qlabel.h>
+#include <QtWidgets/qwidget.h>
+#include <FramelessHelper/Widgets/framelesswidgetshelper.h>
+#include <FramelessHelper/Widgets/private/framelesswidgetshelper_p.h>
+
+FRAMELESSHELPER_USE_NAMESPACE
+
+// A few thousand children, like a large form or a settings page.
+static constexpr const int kChildCount = 3000;
+// The widgets that really depend on the DPR and opt in to the extra work.
+static constexpr const int kRegisteredCount = 10;
+
+// What every child got after a DPR change before the registered lists existed:
+// three resizes and three moves, each of them running the layouts again.
+static inline void legacyForceRepaint(QWidget * const widget)
+{
+    widget->update();
+    const QSize originalSize = widget->size();
+    static constexpr const auto margins = QMargins{10, 10, 10, 10};
+    widget->resize(originalSize.shrunkBy(margins));
+    widget->resize(originalSize.grownBy(margins));
+    widget->resize(originalSize);
+    const QPoint originalPosition = widget->pos();
+    static constexpr const auto offset = QPoint{10, 10};
+    widget->move(originalPosition - offset);
+    widget->move(originalPosition + offset);
+    widget->move(originalPosition);
+    widget->update();
+}
+
+static inline void legacyRepaintAllChildren(QWidget * const window)
+{
+    legacyForceRepaint(window);
+    const QList<QWidget *> widgets = window->findChildren<QWidget *>();
+    for (auto &&widget : std::as_const(widgets)) {
+        legacyForceRepaint(widget);
+    }
+}
+
+class DprRepaintTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void repaintAllChildren_data();
+    void repaintAllChildren();
+
+private:
+    QWidget *m_window = nullptr;
+    FramelessWidgetsHelper *m_helper = nullptr;
+};
+
+void DprRepaintTest::initTestCase()
+{
+    m_window = new QWidget;
+    const auto layout = new QGridLayout(m_window);
+    for (int i = 0; i != kChildCount; ++i) {
+        layout->addWidget(new QLabel(QString::number(i), m_window), (i / 50), (i % 50));
+    }
+    // Not attached to the platform window: only the repaint path is measured here.
+    m_helper = new FramelessWidgetsHelper(m_window);
+    FramelessWidgetsHelperPrivate::get(m_helper)->window = m_window;
+    const QList<QLabel *> labels = m_window->findChildren<QLabel *>();
+    QVERIFY(labels.size() == kChildCount);
+    for (int i = 0; i != kRegisteredCount; ++i) {
+        m_helper->setRepolishOnDprChange(labels.at(i), true);
+        m_helper->setForceRepaintOnDprChange(labels.at(kChildCount - 1 - i), true);
+    }
+    m_window->show();
+    QVERIFY(QTest::qWaitForWindowExposed(m_window));
+}
+
+void DprRepaintTest::cleanupTestCase()
+{
+    delete m_window;
+    m_window = nullptr;
+    m_helper = nullptr;
+}
+
+void DprRepaintTest::repaintAllChildren_data()
+{
+    QTest::addColumn<bool>("legacy");
+    QTest::newRow("every child") << true;
+    QTest::newRow("registered only") << false;
+}
+
+void DprRepaintTest::repaintAllChildren()
+{
+    QFETCH(bool, legacy);
+    const FramelessWidgetsHelperPrivate * const helper = FramelessWidgetsHelperPrivate::get(m_helper);
+    const QSize size = m_window->size();
+    QBENCHMARK {
+        if (legacy) {
+            legacyRepaintAllChildren(m_window);
+        } else {
+            helper->repaintAllChildren();
+        }
+        // The layout requests and paint events the above has queued up.
+        QCoreApplication::processEvents();
+    }
+    QCOMPARE(m_window->size(), size);
+}
+
+QTEST_MAIN(DprRepaintTest)
+
+#include "tst_dprrepaint.moc"
@@ -0,0 +1,309 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021-2023 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <QtTest/qtest.h>
+#include <FramelessHelper/Core/private/hittest_p.h>
+
+FRAMELESSHELPER_USE_NAMESPACE
+
+using namespace Global;
+
+Q_DECLARE_METATYPE(HitTestResult)
+
+class HitTestTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void systemButtons();
+    void nativeFrameBorder();
+    void framelessBorder();
+    void maximizedAndFullScreen();
+    void dontOverrideCursor();
+    void conversions();
+    void resizeBorderBands();
+    void resizeBorderBandsEdges();
+    void resizeBorderBandsSnapshot();
+    void evaluateBenchmark_data();
+    void evaluateBenchmark();
+    void evaluateBandsBenchmark_data();
+    void evaluateBandsBenchmark();
+    void lookupBenchmark_data();
+    void lookupBenchmark();
+};
+
+[[nodiscard]] static inline ResizeBorderBands normalWindowBands()
+{
+    // The same border as normalWindow(), with the corners as wide as its scaled ones.
+    ResizeBorderSettings settings = {};
+    settings.thickness = 8;
+    settings.cornerSize = 16;
+    ResizeBorderBands bands = {};
+    bands.update(settings, QSize(200, 100), 1);
+    return bands;
+}
+
+[[nodiscard]] static inline HitTestSnapshot normalWindow()
+{
+    HitTestSnapshot snapshot = {};
+    snapshot.size = QSize(200, 100);
+    snapshot.resizeBorderThicknessX = 8;
+    snapshot.resizeBorderThicknessY = 8;
+    snapshot.cornerScaleFactor = 2;
+    return snapshot;
+}
+
+void HitTestTest::systemButtons()
+{
+    HitTestSnapshot snapshot = normalWindow();
+    snapshot.insideSystemButton = true;
+    snapshot.systemButton = SystemButtonType::Close;
+    snapshot.systemButtonResizeBorder = 2;
+    QCOMPARE(HitTest::evaluate(snapshot, QPoint(180, 10)), HitTestResult::Close);
+    // The top and the right edges can still resize the window.
+    QCOMPARE(HitTest::evaluate(snapshot, QPoint(180, 1)), HitTestResult::Top);
+    QCOMPARE(HitTest::evaluate(snapshot, QPoint(199, 10)), HitTestResult::Right);
+    QCOMPARE(HitTest::evaluate(snapshot, QPoint(199, 1)), HitTestResult::TopRight);
+    snapshot.systemButton = SystemButtonType::Restore;
+    QCOMPARE(HitTest::evaluate(snapshot, QPoint(180, 10)), HitTestResult::Maximize);
+    snapshot.systemButton = SystemButtonType::WindowIcon;
+    QCOMPARE(HitTest::evaluate(snapshot, QPoint(180, 10)), HitTestResult::SystemMenu);
+}
+
+void HitTestTest::nativeFrameBorder()
+{
+    HitTestSnapshot snapshot = normalWindow();
+    snapshot.frameBorderVisible = true;
+    snapshot.nativeResult = HitTestResult::Left;
+    QCOMPARE(HitTest::evaluate(snapshot, QPoint(0, 50)), HitTestResult::Left);
+    // Values without a portable equivalent are kept as they are.
+    snapshot.nativeResult = HitTestResult::Native;
+    QCOMPARE(HitTest::evaluate(snapshot, QPoint(0, 50)), HitTestResult::Native);
+    snapshot.fixedSize = true;
+    QCOMPARE(HitTest::evaluate(snapshot, QPoint(0, 50)), HitTestResult::Border);
+    // Inside the client area: only the top border is ours.
+    snapshot.fixedSize = false;
+    snapshot.nativeResult = HitTestResult::Client;
+    QCOMPARE(HitTest::evaluate(snapshot, QPoint(100, 2)), HitTestResult::Top);
+    QCOMPARE(HitTest::evaluate(snapshot, QPoint(2, 50)), HitTestResult::Client);
+    snapshot.insideTitleBar = true;
+    QCOMPARE(HitTest::evaluate(snapshot, QPoint(100, 20)), HitTestResult::Caption);
+}
+
+void HitTestTest::framelessBorder()
+{
+    HitTestSnapshot snapshot = normalWindow();
+    QCOMPARE(HitTest::evaluate(snapshot, QPoint(0, 0)), HitTestResult::TopLeft);
+    // The corners are wider along the top and the bottom edges.
+    QCOMPARE(HitTest::evaluate(snapshot, QPoint(12, 0)), HitTestResult::TopLeft);
+    QCOMPARE(HitTest::evaluate(snapshot, QPoint(12, 99)), HitTestResult::BottomLeft);
+    QCOMPARE(HitTest::evaluate(snapshot, QPoint(100, 0)), HitTestResult::Top);
+    QCOMPARE(HitTest::evaluate(snapshot, QPoint(100, 99)), HitTestResult::Bottom);
+    QCOMPARE(HitTest::evaluate(snapshot, QPoint(0, 50)), HitTestResult::Left);
+    QCOMPARE(HitTest::evaluate(snapshot, QPoint(199, 50)), HitTestResult::Right);
+    QCOMPARE(HitTest::evaluate(snapshot, QPoint(12, 50)), HitTestResult::Client);
+    QCOMPARE(HitTest::evaluate(snapshot, QPoint(199, 99)), HitTestResult::BottomRight);
+    snapshot.insideTitleBar = true;
+    QCOMPARE(HitTest::evaluate(snapshot, QPoint(100, 20)), HitTestResult::Caption);
+    snapshot.fixedSize = true;
+    QCOMPARE(HitTest::evaluate(snapshot, QPoint(0, 0)), HitTestResult::Caption);
+}
+
+void HitTestTest::maximizedAndFullScreen()
+{
+    HitTestSnapshot snapshot = normalWindow();
+    snapshot.maximized = true;
+    QCOMPARE(HitTest::evaluate(snapshot, QPoint(0, 0)), HitTestResult::Client);
+    snapshot.insideTitleBar = true;
+    QCOMPARE(HitTest::evaluate(snapshot, QPoint(0, 0)), HitTestResult::Caption);
+    snapshot.fullScreen = true;
+    QCOMPARE(HitTest::evaluate(snapshot, QPoint(0, 0)), HitTestResult::Client);
+}
+
+void HitTestTest::dontOverrideCursor()
+{
+    HitTestSnapshot snapshot = normalWindow();
+    snapshot.dontOverrideCursor = true;
+    QCOMPARE(HitTest::evaluate(snapshot, QPoint(0, 0)), HitTestResult::Client);
+    QCOMPARE(HitTest::evaluate(snapshot, QPoint(199, 50)), HitTestResult::Client);
+}
+
+void HitTestTest::conversions()
+{
+    QCOMPARE(HitTest::toWindowEdges(HitTestResult::TopLeft), Qt::Edges(Qt::TopEdge | Qt::LeftEdge));
+    QCOMPARE(HitTest::toWindowEdges(HitTestResult::Bottom), Qt::Edges(Qt::BottomEdge));
+    QCOMPARE(HitTest::toWindowEdges(HitTestResult::Caption), Qt::Edges());
+    QCOMPARE(HitTest::toWindowEdges(HitTestResult::Native), Qt::Edges());
+    QCOMPARE(HitTest::toCursorShape(HitTestResult::TopLeft), Qt::SizeFDiagCursor);
+    QCOMPARE(HitTest::toCursorShape(HitTestResult::BottomLeft), Qt::SizeBDiagCursor);
+    QCOMPARE(HitTest::toCursorShape(HitTestResult::Right), Qt::SizeHorCursor);
+    QCOMPARE(HitTest::toCursorShape(HitTestResult::Top), Qt::SizeVerCursor);
+    QCOMPARE(HitTest::toCursorShape(HitTestResult::Border), Qt::ArrowCursor);
+}
+
+void HitTestTest::resizeBorderBands()
+{
+    ResizeBorderSettings settings = {};
+    settings.thickness = 8;
+    settings.cornerSize = 16;
+    ResizeBorderBands bands = {};
+    bands.update(settings, QSize(200, 100), 1.5);
+    QCOMPARE(bands.devicePixelRatio, qreal(1.5));
+    // 300x150 device pixels, a 12 pixel border and 24 pixel corners.
+    QCOMPARE(bands.horizontal, (std::array<int, 4>{ 12, 24, 276, 288 }));
+    QCOMPARE(bands.vertical, (std::array<int, 4>{ 12, 24, 126, 138 }));
+    QCOMPARE(bands.lookup(QPointF(0, 0)), HitTestResult::TopLeft);
+    QCOMPARE(bands.lookup(QPointF(10, 2)), HitTestResult::TopLeft);
+    QCOMPARE(bands.lookup(QPointF(100, 2)), HitTestResult::Top);
+    QCOMPARE(bands.lookup(QPointF(2, 50)), HitTestResult::Left);
+    QCOMPARE(bands.lookup(QPointF(10, 50)), HitTestResult::Client);
+    QCOMPARE(bands.lookup(QPointF(100, 50)), HitTestResult::Client);
+    QCOMPARE(bands.lookup(QPointF(199, 99)), HitTestResult::BottomRight);
+    QCOMPARE(bands.lookup(QPointF(190, 98)), HitTestResult::BottomRight);
+    // Anything outside of the window belongs to the nearest band.
+    QCOMPARE(bands.lookup(QPointF(-5, 50)), HitTestResult::Left);
+    QCOMPARE(bands.lookup(QPointF(250, 50)), HitTestResult::Right);
+}
+
+void HitTestTest::resizeBorderBandsEdges()
+{
+    ResizeBorderSettings settings = {};
+    settings.thickness = 8;
+    settings.cornerSize = 8;
+    settings.edges = (Qt::LeftEdge | Qt::RightEdge);
+    ResizeBorderBands bands = {};
+    bands.update(settings, QSize(200, 100), 1);
+    QCOMPARE(bands.lookup(QPointF(0, 0)), HitTestResult::Left);
+    QCOMPARE(bands.lookup(QPointF(100, 0)), HitTestResult::Client);
+    QCOMPARE(bands.lookup(QPointF(199, 99)), HitTestResult::Right);
+    // Windows smaller than two corners are split in the middle.
+    settings.edges = (Qt::TopEdge | Qt::BottomEdge | Qt::LeftEdge | Qt::RightEdge);
+    bands.update(settings, QSize(10, 10), 1);
+    QCOMPARE(bands.lookup(QPointF(4, 4)), HitTestResult::TopLeft);
+    QCOMPARE(bands.lookup(QPointF(6, 6)), HitTestResult::BottomRight);
+}
+
+void HitTestTest::resizeBorderBandsSnapshot()
+{
+    ResizeBorderSettings settings = {};
+    settings.thickness = 8;
+    settings.cornerSize = 16;
+    settings.edges = (Qt::TopEdge | Qt::BottomEdge | Qt::LeftEdge);
+    ResizeBorderBands bands = {};
+    bands.updateNative(settings, QSize(400, 200), 2);
+    HitTestSnapshot snapshot = {};
+    snapshot.resizeBorder = &bands;
+    // Device pixels: a 16 pixel border and 32 pixel corners, no right edge.
+    QCOMPARE(HitTest::evaluate(snapshot, QPoint(0, 0)), HitTestResult::TopLeft);
+    QCOMPARE(HitTest::evaluate(snapshot, QPoint(30, 2)), HitTestResult::TopLeft);
+    QCOMPARE(HitTest::evaluate(snapshot, QPoint(399, 2)), HitTestResult::Top);
+    QCOMPARE(HitTest::evaluate(snapshot, QPoint(399, 100)), HitTestResult::Client);
+    QCOMPARE(HitTest::evaluate(snapshot, QPoint(200, 199)), HitTestResult::Bottom);
+    QCOMPARE(bands.mapToNative(QPointF(7.9, 0.4)), QPoint(15, 0));
+    snapshot.insideTitleBar = true;
+    QCOMPARE(HitTest::evaluate(snapshot, QPoint(200, 40)), HitTestResult::Caption);
+    snapshot.dontOverrideCursor = true;
+    QCOMPARE(HitTest::evaluate(snapshot, QPoint(0, 100)), HitTestResult::Client);
+    snapshot.dontOverrideCursor = false;
+    // Only the top part of our client area is ours when the native frame is visible.
+    snapshot.frameBorderVisible = true;
+    QCOMPARE(HitTest::evaluate(snapshot, QPoint(30, 2)), HitTestResult::Top);
+    QCOMPARE(HitTest::evaluate(snapshot, QPoint(0, 100)), HitTestResult::Caption);
+    snapshot.frameBorderVisible = false;
+    snapshot.maximized = true;
+    QCOMPARE(HitTest::evaluate(snapshot, QPoint(0, 0)), HitTestResult::Caption);
+    snapshot.insideTitleBar = false;
+    snapshot.maximized = false;
+    snapshot.fixedSize = true;
+    QCOMPARE(HitTest::evaluate(snapshot, QPoint(0, 0)), HitTestResult::Client);
+}
+
+void HitTestTest::evaluateBenchmark_data()
+{
+    QTest::addColumn<QPoint>("pos");
+    QTest::addColumn<bool>("insideTitleBar");
+    QTest::addColumn<HitTestResult>("expected");
+    QTest::newRow("edge") << QPoint(0, 50) << false << HitTestResult::Left;
+    QTest::newRow("corner") << QPoint(12, 0) << false << HitTestResult::TopLeft;
+    QTest::newRow("title bar") << QPoint(100, 20) << true << HitTestResult::Caption;
+    QTest::newRow("client") << QPoint(100, 60) << false << HitTestResult::Client;
+}
+
+void HitTestTest::evaluateBenchmark()
+{
+    QFETCH(QPoint, pos);
+    QFETCH(bool, insideTitleBar);
+    QFETCH(HitTestResult, expected);
+    HitTestSnapshot snapshot = normalWindow();
+    snapshot.insideTitleBar = insideTitleBar;
+    HitTestResult result = HitTestResult::Nowhere;
+    QBENCHMARK {
+        result = HitTest::evaluate(snapshot, pos);
+    }
+    QCOMPARE(result, expected);
+}
+
+void HitTestTest::evaluateBandsBenchmark_data()
+{
+    evaluateBenchmark_data();
+}
+
+void HitTestTest::evaluateBandsBenchmark()
+{
+    QFETCH(QPoint, pos);
+    QFETCH(bool, insideTitleBar);
+    QFETCH(HitTestResult, expected);
+    const ResizeBorderBands bands = normalWindowBands();
+    HitTestSnapshot snapshot = {};
+    snapshot.resizeBorder = &bands;
+    snapshot.insideTitleBar = insideTitleBar;
+    HitTestResult result = HitTestResult::Nowhere;
+    QBENCHMARK {
+        result = HitTest::evaluate(snapshot, pos);
+    }
+    QCOMPARE(result, expected);
+}
+
+void HitTestTest::lookupBenchmark_data()
+{
+    evaluateBenchmark_data();
+}
+
+void HitTestTest::lookupBenchmark()
+{
+    QFETCH(QPoint, pos);
+    QFETCH(HitTestResult, expected);
+    const ResizeBorderBands bands = normalWindowBands();
+    const QPointF logicalPos = pos;
+    HitTestResult result = HitTestResult::Nowhere;
+    QBENCHMARK {
+        result = bands.lookup(logicalPos);
+    }
+    // The bands only know about the resize border.
+    QCOMPARE(result, ((expected == HitTestResult::Caption) ? HitTestResult::Client : expected));
+}
+
+QTEST_APPLESS_MAIN(HitTestTest)
+
+#include "tst_hittest.moc"
@@ -0,0 +1,174 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021-2023 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <QtTest/qtest.h>
+#include <QtCore/qdir.h>
+#include <QtCore/qfile.h>
+#include <QtGui/qcolor.h>
+#include <FramelessHelper/Core/private/linuxtheme_p.h>
+
+FRAMELESSHELPER_USE_NAMESPACE
+
+class LinuxThemeTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void gtkThemeEnv();
+    void gtkSettingsIni();
+    void kdeGlobals();
+    void kdeGlobalsColorScheme();
+    void dconfUser();
+    void portalAppearance();
+    void fillFrom();
+};
+
+void LinuxThemeTest::gtkThemeEnv()
+{
+    QVERIFY(!LinuxTheme::parseGtkThemeEnv({}).dark.has_value());
+    QCOMPARE(LinuxTheme::parseGtkThemeEnv(FRAMELESSHELPER_STRING_LITERAL("Adwaita:dark")).dark, std::optional<bool>(true));
+    QCOMPARE(LinuxTheme::parseGtkThemeEnv(FRAMELESSHELPER_STRING_LITERAL("Adwaita")).dark, std::optional<bool>(false));
+}
+
+void LinuxThemeTest::gtkSettingsIni()
+{
+    // The explicit preference wins over the theme name.
+    LinuxTheme::ThemeHints hints = LinuxTheme::parseGtkSettingsIni(
+        "[Settings]\n"
+        "gtk-theme-name=Adwaita\n"
+        "gtk-application-prefer-dark-theme=1\n");
+    QCOMPARE(hints.dark, std::optional<bool>(true));
+    // Without one, a dark theme is still dark.
+    hints = LinuxTheme::parseGtkSettingsIni(
+        "[Settings]\n"
+        "gtk-theme-name=Arc-Dark\n"
+        "gtk-application-prefer-dark-theme=false\n");
+    QCOMPARE(hints.dark, std::optional<bool>(true));
+    hints = LinuxTheme::parseGtkSettingsIni(
+        "# Written by nwg-look\n"
+        "[Settings]\n"
+        "gtk-application-prefer-dark-theme = false\n");
+    QCOMPARE(hints.dark, std::optional<bool>(false));
+    // Keys outside of the [Settings] group don't count.
+    hints = LinuxTheme::parseGtkSettingsIni(
+        "[Other]\n"
+        "gtk-application-prefer-dark-theme=true\n");
+    QVERIFY(!hints.dark.has_value());
+    // GTK settings know nothing about accent colors.
+    QVERIFY(!hints.accentColor.has_value());
+    QVERIFY(!hints.titleBarColorized.has_value());
+    QVERIFY(!LinuxTheme::parseGtkSettingsIni({}).dark.has_value());
+}
+
+void LinuxThemeTest::kdeGlobals()
+{
+    const LinuxTheme::ThemeHints hints = LinuxTheme::parseKdeGlobals(
+        "[Colors:Selection]\n"
+        "BackgroundNormal=61,174,233\n"
+        "\n"
+        "[Colors:Window]\n"
+        "BackgroundNormal=32,35,38\n"
+        "\n"
+        "[General]\n"
+        "ColorScheme=BreezeLight\n"
+        "AccentColor[$e]=#ff8000\n"
+        "TitlebarIsAccentColored=true\n");
+    // The window color decides, not the name of the scheme.
+    QCOMPARE(hints.dark, std::optional<bool>(true));
+    QVERIFY(hints.accentColor.has_value());
+    QCOMPARE(hints.accentColor.value(), QColor(255, 128, 0));
+    QCOMPARE(hints.titleBarColorized, std::optional<bool>(true));
+    QVERIFY(hints.isComplete());
+}
+
+void LinuxThemeTest::kdeGlobalsColorScheme()
+{
+    const LinuxTheme::ThemeHints hints = LinuxTheme::parseKdeGlobals(
+        "[General]\n"
+        "ColorScheme=BreezeDark\n"
+        "AccentColor=300,0,0\n"
+        "\n"
+        "[Colors:Selection]\n"
+        "BackgroundNormal=61,174,233,255\n");
+    QCOMPARE(hints.dark, std::optional<bool>(true));
+    // Out of range components are ignored, the selection color takes over.
+    QVERIFY(hints.accentColor.has_value());
+    QCOMPARE(hints.accentColor.value(), QColor(61, 174, 233));
+    QVERIFY(!hints.titleBarColorized.has_value());
+    QVERIFY(!hints.isComplete());
+    QVERIFY(!LinuxTheme::parseKdeGlobals({}).dark.has_value());
+}
+
+void LinuxThemeTest::dconfUser()
+{
+    // The same database the wallpaper tests use: color-scheme is 'prefer-dark'.
+    QFile file(QDir(QUtf8String(FRAMELESSHELPER_TEST_DATA_DIR)).filePath(FRAMELESSHELPER_STRING_LITERAL("dconf-user")));
+    QVERIFY(file.open(QFile::ReadOnly));
+    const LinuxTheme::ThemeHints hints = LinuxTheme::parseDconfUser(file.readAll());
+    QCOMPARE(hints.dark, std::optional<bool>(true));
+    QVERIFY(!hints.accentColor.has_value());
+    QVERIFY(!hints.titleBarColorized.has_value());
+    // Not a database at all.
+    QVERIFY(!LinuxTheme::parseDconfUser({}).dark.has_value());
+    QVERIFY(!LinuxTheme::parseDconfUser(FRAMELESSHELPER_BYTEARRAY_LITERAL("[org/gnome/desktop/interface]\ncolor-scheme='prefer-dark'\n")).dark.has_value());
+}
+
+void LinuxThemeTest::portalAppearance()
+{
+    const std::array<qreal, 3> orange = { 1.0, 0.5, 0.0 };
+    LinuxTheme::ThemeHints hints = LinuxTheme::parsePortalAppearance(1, orange);
+    QCOMPARE(hints.dark, std::optional<bool>(true));
+    QVERIFY(hints.accentColor.has_value());
+    QCOMPARE(hints.accentColor->rgb(), QColor::fromRgbF(1.0, 0.5, 0.0).rgb());
+    hints = LinuxTheme::parsePortalAppearance(2, std::nullopt);
+    QCOMPARE(hints.dark, std::optional<bool>(false));
+    QVERIFY(!hints.accentColor.has_value());
+    // No preference, and an accent color outside of [0, 1] means "not set".
+    const std::array<qreal, 3> unset = { -1.0, -1.0, -1.0 };
+    hints = LinuxTheme::parsePortalAppearance(0, unset);
+    QVERIFY(!hints.dark.has_value());
+    QVERIFY(!hints.accentColor.has_value());
+    hints = LinuxTheme::parsePortalAppearance(std::nullopt, std::nullopt);
+    QVERIFY(!hints.dark.has_value());
+    QVERIFY(!hints.titleBarColorized.has_value());
+}
+
+void LinuxThemeTest::fillFrom()
+{
+    LinuxTheme::ThemeHints hints = LinuxTheme::parsePortalAppearance(2, std::nullopt);
+    hints.fillFrom(LinuxTheme::parseKdeGlobals(
+        "[General]\n"
+        "ColorScheme=BreezeDark\n"
+        "AccentColor=61,174,233\n"
+        "TitlebarIsAccentColored=false\n"));
+    // The values already known are kept.
+    QCOMPARE(hints.dark, std::optional<bool>(false));
+    QCOMPARE(hints.accentColor.value(), QColor(61, 174, 233));
+    QCOMPARE(hints.titleBarColorized, std::optional<bool>(false));
+    QVERIFY(hints.isComplete());
+}
+
+QTEST_APPLESS_MAIN(LinuxThemeTest)
+
+#include "tst_linuxtheme.moc"
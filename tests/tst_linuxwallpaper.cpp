@@ -0,0 +1,275 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021-2023 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <QtTest/qtest.h>
+#include <QtCore/qdir.h>
+#include <QtCore/qfile.h>
+#include <FramelessHelper/Core/private/linuxwallpaper_p.h>
+
+FRAMELESSHELPER_USE_NAMESPACE
+
+using namespace Global;
+
+static constexpr const char kBackgroundDir[] = "/org/gnome/desktop/background/";
+static constexpr const char kInterfaceDir[] = "/org/gnome/desktop/interface/";
+
+class LinuxWallpaperTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void dconfDatabase();
+    void dconfDatabaseCorrupted();
+    void dconfKeyfile();
+    void gsettingsOverride();
+    void gsettingsSchema();
+    void wallpaperFromGSettings();
+    void plasmaAppletsrc();
+    void xfceDesktopXml();
+    void swayConfig();
+    void fehbg();
+};
+
+[[nodiscard]] static inline QByteArray readTestData(const char *fileName)
+{
+    QFile file(QDir(QUtf8String(FRAMELESSHELPER_TEST_DATA_DIR)).filePath(QUtf8String(fileName)));
+    if (!file.open(QFile::ReadOnly)) {
+        return {};
+    }
+    return file.readAll();
+}
+
+void LinuxWallpaperTest::dconfDatabase()
+{
+    // A little-endian GVDB file in the same layout dconf writes ~/.config/dconf/user in.
+    const QByteArray data = readTestData("dconf-user");
+    QVERIFY(!data.isEmpty());
+    const LinuxWallpaper::StringMap background = LinuxWallpaper::parseDconfDatabase(data, QUtf8String(kBackgroundDir));
+    // Only the string values directly inside of the directory, the booleans and the
+    // keys of the sub-directories are left out.
+    QCOMPARE(background.size(), 3);
+    QCOMPARE(background.value(FRAMELESSHELPER_STRING_LITERAL("picture-uri")),
+             FRAMELESSHELPER_STRING_LITERAL("file:///usr/share/backgrounds/light.jpg"));
+    QCOMPARE(background.value(FRAMELESSHELPER_STRING_LITERAL("picture-uri-dark")),
+             FRAMELESSHELPER_STRING_LITERAL("file:///usr/share/backgrounds/dark%20mode.jpg"));
+    QCOMPARE(background.value(FRAMELESSHELPER_STRING_LITERAL("picture-options")), FRAMELESSHELPER_STRING_LITERAL("scaled"));
+    const LinuxWallpaper::StringMap interface = LinuxWallpaper::parseDconfDatabase(data, QUtf8String(kInterfaceDir));
+    QCOMPARE(interface.value(FRAMELESSHELPER_STRING_LITERAL("color-scheme")), FRAMELESSHELPER_STRING_LITERAL("prefer-dark"));
+    QVERIFY(LinuxWallpaper::parseDconfDatabase(data, FRAMELESSHELPER_STRING_LITERAL("/org/mate/desktop/background/")).isEmpty());
+}
+
+void LinuxWallpaperTest::dconfDatabaseCorrupted()
+{
+    const QByteArray data = readTestData("dconf-user");
+    QVERIFY(!data.isEmpty());
+    const QString dir = QUtf8String(kBackgroundDir);
+    QVERIFY(LinuxWallpaper::parseDconfDatabase({}, dir).isEmpty());
+    QVERIFY(LinuxWallpaper::parseDconfDatabase(FRAMELESSHELPER_BYTEARRAY_LITERAL("[org/gnome/desktop/background]"), dir).isEmpty());
+    // Every truncation has to be survived, whatever is left of the file.
+    for (int size = 0; size < data.size(); ++size) {
+        std::ignore = LinuxWallpaper::parseDconfDatabase(data.left(size), dir);
+    }
+    // Same for garbage in the pointers.
+    for (int offset = 16; offset < data.size(); offset += 7) {
+        QByteArray broken = data;
+        broken[offset] = char(0xFF);
+        std::ignore = LinuxWallpaper::parseDconfDatabase(broken, dir);
+    }
+}
+
+void LinuxWallpaperTest::dconfKeyfile()
+{
+    static constexpr const char kData[] =
+        "[org/gnome/desktop/background]\n"
+        "picture-uri='file:///usr/share/backgrounds/local.png'\n"
+        "picture-options=\"spanned\"\n"
+        "primary-color=@s '#000000'\n"
+        "\n"
+        "[org/gnome/desktop/interface]\n"
+        "picture-uri='wrong group'\n";
+    const LinuxWallpaper::StringMap values = LinuxWallpaper::parseDconfKeyfile(kData, QUtf8String(kBackgroundDir));
+    QCOMPARE(values.size(), 3);
+    QCOMPARE(values.value(FRAMELESSHELPER_STRING_LITERAL("picture-uri")),
+             FRAMELESSHELPER_STRING_LITERAL("file:///usr/share/backgrounds/local.png"));
+    QCOMPARE(values.value(FRAMELESSHELPER_STRING_LITERAL("picture-options")), FRAMELESSHELPER_STRING_LITERAL("spanned"));
+    QCOMPARE(values.value(FRAMELESSHELPER_STRING_LITERAL("primary-color")), FRAMELESSHELPER_STRING_LITERAL("#000000"));
+}
+
+void LinuxWallpaperTest::gsettingsOverride()
+{
+    static constexpr const char kData[] =
+        "[org.gnome.desktop.background]\n"
+        "picture-uri='file:///usr/share/backgrounds/vendor.png'\n"
+        "picture-options='zoom'\n"
+        "\n"
+        "[org.gnome.desktop.background:ubuntu]\n"
+        "picture-uri='file:///usr/share/backgrounds/ubuntu.png'\n";
+    const QString schema = FRAMELESSHELPER_STRING_LITERAL("org.gnome.desktop.background");
+    LinuxWallpaper::StringMap values = LinuxWallpaper::parseGSettingsOverride(kData, schema);
+    QCOMPARE(values.value(FRAMELESSHELPER_STRING_LITERAL("picture-uri")),
+             FRAMELESSHELPER_STRING_LITERAL("file:///usr/share/backgrounds/vendor.png"));
+    values = LinuxWallpaper::parseGSettingsOverride(kData, schema, { FRAMELESSHELPER_STRING_LITERAL("ubuntu"), FRAMELESSHELPER_STRING_LITERAL("gnome") });
+    QCOMPARE(values.value(FRAMELESSHELPER_STRING_LITERAL("picture-uri")),
+             FRAMELESSHELPER_STRING_LITERAL("file:///usr/share/backgrounds/ubuntu.png"));
+    QCOMPARE(values.value(FRAMELESSHELPER_STRING_LITERAL("picture-options")), FRAMELESSHELPER_STRING_LITERAL("zoom"));
+}
+
+void LinuxWallpaperTest::gsettingsSchema()
+{
+    static constexpr const char kData[] =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<schemalist>\n"
+        "  <schema id=\"org.gnome.desktop.screensaver\" path=\"/org/gnome/desktop/screensaver/\">\n"
+        "    <key name=\"picture-uri\" type=\"s\"><default>'file:///wrong.png'</default></key>\n"
+        "  </schema>\n"
+        "  <schema id=\"org.gnome.desktop.background\" path=\"/org/gnome/desktop/background/\">\n"
+        "    <key name=\"picture-uri\" type=\"s\">\n"
+        "      <default>'file:///usr/share/backgrounds/gnome/adwaita-l.jxl'</default>\n"
+        "      <summary>Picture URI</summary>\n"
+        "    </key>\n"
+        "    <key name=\"picture-options\" enum=\"org.gnome.desktop.GDesktopBackgroundStyle\">\n"
+        "      <default>'zoom'</default>\n"
+        "    </key>\n"
+        "  </schema>\n"
+        "</schemalist>\n";
+    const LinuxWallpaper::StringMap values = LinuxWallpaper::parseGSettingsSchema(kData, FRAMELESSHELPER_STRING_LITERAL("org.gnome.desktop.background"));
+    QCOMPARE(values.size(), 2);
+    QCOMPARE(values.value(FRAMELESSHELPER_STRING_LITERAL("picture-uri")),
+             FRAMELESSHELPER_STRING_LITERAL("file:///usr/share/backgrounds/gnome/adwaita-l.jxl"));
+    QCOMPARE(values.value(FRAMELESSHELPER_STRING_LITERAL("picture-options")), FRAMELESSHELPER_STRING_LITERAL("zoom"));
+}
+
+void LinuxWallpaperTest::wallpaperFromGSettings()
+{
+    const LinuxWallpaper::StringMap values = LinuxWallpaper::parseDconfDatabase(readTestData("dconf-user"), QUtf8String(kBackgroundDir));
+    LinuxWallpaper::Wallpaper wallpaper = LinuxWallpaper::wallpaperFromGSettings(values, false);
+    QVERIFY(wallpaper.valid);
+    QCOMPARE(wallpaper.filePath, FRAMELESSHELPER_STRING_LITERAL("/usr/share/backgrounds/light.jpg"));
+    QCOMPARE(wallpaper.aspectStyle, WallpaperAspectStyle::Fit);
+    wallpaper = LinuxWallpaper::wallpaperFromGSettings(values, true);
+    QCOMPARE(wallpaper.filePath, FRAMELESSHELPER_STRING_LITERAL("/usr/share/backgrounds/dark mode.jpg"));
+    // MATE stores a plain path.
+    wallpaper = LinuxWallpaper::wallpaperFromGSettings({ { FRAMELESSHELPER_STRING_LITERAL("picture-filename"), FRAMELESSHELPER_STRING_LITERAL("/usr/share/mate.png") } }, false);
+    QVERIFY(wallpaper.valid);
+    QCOMPARE(wallpaper.filePath, FRAMELESSHELPER_STRING_LITERAL("/usr/share/mate.png"));
+    QCOMPARE(wallpaper.aspectStyle, WallpaperAspectStyle::Fill);
+    // Solid colors are not wallpapers.
+    LinuxWallpaper::StringMap none = values;
+    none.insert(FRAMELESSHELPER_STRING_LITERAL("picture-options"), FRAMELESSHELPER_STRING_LITERAL("none"));
+    QVERIFY(!LinuxWallpaper::wallpaperFromGSettings(none, false).valid);
+    QVERIFY(!LinuxWallpaper::wallpaperFromGSettings({}, false).valid);
+}
+
+void LinuxWallpaperTest::plasmaAppletsrc()
+{
+    static constexpr const char kData[] =
+        "[Containments][1]\n"
+        "wallpaperplugin=org.kde.color\n"
+        "\n"
+        "[Containments][1][Wallpaper][org.kde.color][General]\n"
+        "Color=0,0,0\n"
+        "\n"
+        "[Containments][2]\n"
+        "plugin=org.kde.panel\n"
+        "\n"
+        "[Containments][3][Wallpaper][org.kde.image][General]\n"
+        "FillMode=1\n"
+        "Image[$e]=file:///home/user/Pictures/plasma.png\n"
+        "\n"
+        "[Containments][3]\n"
+        "wallpaperplugin=org.kde.image\n";
+    const LinuxWallpaper::Wallpaper wallpaper = LinuxWallpaper::parsePlasmaAppletsrc(kData);
+    QVERIFY(wallpaper.valid);
+    QCOMPARE(wallpaper.filePath, FRAMELESSHELPER_STRING_LITERAL("/home/user/Pictures/plasma.png"));
+    QCOMPARE(wallpaper.aspectStyle, WallpaperAspectStyle::Fit);
+    QVERIFY(!LinuxWallpaper::parsePlasmaAppletsrc("[Containments][1]\nwallpaperplugin=org.kde.image\n").valid);
+}
+
+void LinuxWallpaperTest::xfceDesktopXml()
+{
+    static constexpr const char kData[] =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<channel name=\"xfce4-desktop\" version=\"1.0\">\n"
+        "  <property name=\"backdrop\" type=\"empty\">\n"
+        "    <property name=\"screen0\" type=\"empty\">\n"
+        "      <property name=\"monitorHDMI-1\" type=\"empty\">\n"
+        "        <property name=\"workspace0\" type=\"empty\">\n"
+        "          <property name=\"image-style\" type=\"int\" value=\"0\"/>\n"
+        "          <property name=\"last-image\" type=\"string\" value=\"/usr/share/backgrounds/none.jpg\"/>\n"
+        "        </property>\n"
+        "      </property>\n"
+        "      <property name=\"monitoreDP-1\" type=\"empty\">\n"
+        "        <property name=\"workspace0\" type=\"empty\">\n"
+        "          <property name=\"image-style\" type=\"int\" value=\"2\"/>\n"
+        "          <property name=\"last-image\" type=\"string\" value=\"/usr/share/backgrounds/xfce/xfce-blue.jpg\"/>\n"
+        "        </property>\n"
+        "      </property>\n"
+        "    </property>\n"
+        "  </property>\n"
+        "</channel>\n";
+    const LinuxWallpaper::Wallpaper wallpaper = LinuxWallpaper::parseXfceDesktopXml(kData);
+    QVERIFY(wallpaper.valid);
+    QCOMPARE(wallpaper.filePath, FRAMELESSHELPER_STRING_LITERAL("/usr/share/backgrounds/xfce/xfce-blue.jpg"));
+    QCOMPARE(wallpaper.aspectStyle, WallpaperAspectStyle::Tile);
+    QVERIFY(!LinuxWallpaper::parseXfceDesktopXml("<channel").valid);
+}
+
+void LinuxWallpaperTest::swayConfig()
+{
+    static constexpr const char kVariable[] =
+        "# Wallpaper\n"
+        "set $wallpaper ~/Pictures/sway.png\n"
+        "output * bg $wallpaper fit\n";
+    LinuxWallpaper::Wallpaper wallpaper = LinuxWallpaper::parseSwayConfig(kVariable);
+    QVERIFY(wallpaper.valid);
+    QCOMPARE(wallpaper.filePath, QDir::homePath() + FRAMELESSHELPER_STRING_LITERAL("/Pictures/sway.png"));
+    QCOMPARE(wallpaper.aspectStyle, WallpaperAspectStyle::Fit);
+    static constexpr const char kBlock[] =
+        "output HDMI-A-1 bg #000000 solid_color\n"
+        "output eDP-1 {\n"
+        "    mode 1920x1080\n"
+        "    bg \"/usr/share/backgrounds/with space.png\" center\n"
+        "}\n";
+    wallpaper = LinuxWallpaper::parseSwayConfig(kBlock);
+    QVERIFY(wallpaper.valid);
+    QCOMPARE(wallpaper.filePath, FRAMELESSHELPER_STRING_LITERAL("/usr/share/backgrounds/with space.png"));
+    QCOMPARE(wallpaper.aspectStyle, WallpaperAspectStyle::Center);
+    QVERIFY(!LinuxWallpaper::parseSwayConfig("output * bg #000000 solid_color\n").valid);
+}
+
+void LinuxWallpaperTest::fehbg()
+{
+    static constexpr const char kData[] =
+        "#!/bin/sh\n"
+        "feh --no-fehbg --bg-scale '/home/user/Pictures/feh one.jpg' '/home/user/Pictures/feh two.jpg'\n";
+    const LinuxWallpaper::Wallpaper wallpaper = LinuxWallpaper::parseFehbg(kData);
+    QVERIFY(wallpaper.valid);
+    QCOMPARE(wallpaper.filePath, FRAMELESSHELPER_STRING_LITERAL("/home/user/Pictures/feh one.jpg"));
+    QCOMPARE(wallpaper.aspectStyle, WallpaperAspectStyle::Stretch);
+    QVERIFY(!LinuxWallpaper::parseFehbg("#!/bin/sh\nfeh --no-fehbg\n").valid);
+}
+
+QTEST_APPLESS_MAIN(LinuxWallpaperTest)
+
+#include "tst_linuxwallpaper.moc"
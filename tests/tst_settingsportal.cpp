@@ -0,0 +1,206 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021-2023 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <QtTest/qtest.h>
+#include <QtTest/qsignalspy.h>
+#include <QtCore/qprocess.h>
+#include <QtCore/qstandardpaths.h>
+#include <QtDBus/qdbusargument.h>
+#include <QtDBus/qdbusconnection.h>
+#include <QtDBus/qdbusextratypes.h>
+#include <QtDBus/qdbusmessage.h>
+#include <QtDBus/qdbusmetatype.h>
+#include <FramelessHelper/Core/private/linuxtheme_p.h>
+#include <FramelessHelper/Core/private/settingsportal_p.h>
+
+FRAMELESSHELPER_USE_NAMESPACE
+
+static constexpr const char kPortalConnection[] = "portal";
+static constexpr const char kPortalService[] = "org.freedesktop.portal.Desktop";
+static constexpr const char kPortalPath[] = "/org/freedesktop/portal/desktop";
+static constexpr const char kPortalInterface[] = "org.freedesktop.portal.Settings";
+static constexpr const char kAppearanceNamespace[] = "org.freedesktop.appearance";
+
+// The (ddd) structure the portal uses for the accent color.
+struct AccentColor
+{
+    double red = 0;
+    double green = 0;
+    double blue = 0;
+};
+Q_DECLARE_METATYPE(AccentColor)
+
+QDBusArgument &operator<<(QDBusArgument &argument, const AccentColor &color)
+{
+    argument.beginStructure();
+    argument << color.red << color.green << color.blue;
+    argument.endStructure();
+    return argument;
+}
+
+const QDBusArgument &operator>>(const QDBusArgument &argument, AccentColor &color)
+{
+    argument.beginStructure();
+    argument >> color.red >> color.green >> color.blue;
+    argument.endStructure();
+    return argument;
+}
+
+// Stands in for xdg-desktop-portal, only the appearance namespace is served.
+class FakeSettingsPortal : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.freedesktop.portal.Settings")
+
+public:
+    explicit FakeSettingsPortal(QObject *parent = nullptr) : QObject(parent) {}
+    ~FakeSettingsPortal() override = default;
+
+    QVariantMap appearance = {};
+
+public Q_SLOTS:
+    QMap<QString, QVariantMap> ReadAll(const QStringList &namespaces)
+    {
+        Q_UNUSED(namespaces);
+        return { { QString::fromUtf8(kAppearanceNamespace), appearance } };
+    }
+};
+
+// SettingsPortal talks to the session bus, which is a private dbus-daemon here.
+class SettingsPortalTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanupTestCase();
+    void readAll();
+    void settingChanged();
+
+private:
+    void emitSettingChanged(const char *nameSpace, const char *key, const QVariant &value);
+
+private:
+    QProcess m_daemon{};
+    FakeSettingsPortal m_portal{};
+};
+
+void SettingsPortalTest::initTestCase()
+{
+    const QString daemon = QStandardPaths::findExecutable(QStringLiteral("dbus-daemon"));
+    if (daemon.isEmpty()) {
+        QSKIP("dbus-daemon is not available.");
+    }
+    m_daemon.start(daemon, { QStringLiteral("--session"), QStringLiteral("--nofork"), QStringLiteral("--print-address") });
+    QVERIFY(m_daemon.waitForStarted());
+    QVERIFY(m_daemon.waitForReadyRead(5000));
+    const QByteArray address = m_daemon.readLine().trimmed();
+    QVERIFY(!address.isEmpty());
+    // Must happen before anything asks for the session bus.
+    qputenv("DBUS_SESSION_BUS_ADDRESS", address);
+    qDBusRegisterMetaType<AccentColor>();
+    qDBusRegisterMetaType<QMap<QString, QVariantMap>>();
+    QDBusConnection bus = QDBusConnection::connectToBus(QString::fromUtf8(address), QString::fromUtf8(kPortalConnection));
+    QVERIFY(bus.isConnected());
+    QVERIFY(bus.registerObject(QString::fromUtf8(kPortalPath), &m_portal, QDBusConnection::ExportAllSlots));
+    QVERIFY(bus.registerService(QString::fromUtf8(kPortalService)));
+}
+
+void SettingsPortalTest::init()
+{
+    LinuxTheme::setPortalHints({});
+    m_portal.appearance = {};
+}
+
+void SettingsPortalTest::cleanupTestCase()
+{
+    QDBusConnection::disconnectFromBus(QString::fromUtf8(kPortalConnection));
+    m_daemon.kill();
+    std::ignore = m_daemon.waitForFinished();
+}
+
+void SettingsPortalTest::emitSettingChanged(const char *nameSpace, const char *key, const QVariant &value)
+{
+    QDBusMessage message = QDBusMessage::createSignal(QString::fromUtf8(kPortalPath),
+        QString::fromUtf8(kPortalInterface), QStringLiteral("SettingChanged"));
+    message << QString::fromUtf8(nameSpace) << QString::fromUtf8(key) << QVariant::fromValue(QDBusVariant(value));
+    QVERIFY(QDBusConnection(QString::fromUtf8(kPortalConnection)).send(message));
+}
+
+void SettingsPortalTest::readAll()
+{
+    m_portal.appearance.insert(QStringLiteral("color-scheme"), quint32(1));
+    m_portal.appearance.insert(QStringLiteral("accent-color"), QVariant::fromValue(AccentColor{ 0.2, 0.4, 0.6 }));
+    SettingsPortal portal;
+    QSignalSpy spy(&portal, &SettingsPortal::updated);
+    portal.start();
+    // Nothing blocks, the answer arrives through the event loop.
+    QCOMPARE(spy.count(), 0);
+    QVERIFY(spy.wait());
+    QCOMPARE(spy.count(), 1);
+    const LinuxTheme::ThemeHints hints = LinuxTheme::portalHints();
+    QVERIFY(hints.dark.has_value());
+    QVERIFY(hints.dark.value());
+    QVERIFY(hints.accentColor.has_value());
+    QCOMPARE(hints.accentColor.value(), QColor::fromRgbF(0.2, 0.4, 0.6));
+    // Not known to the portal.
+    QVERIFY(!hints.titleBarColorized.has_value());
+}
+
+void SettingsPortalTest::settingChanged()
+{
+    m_portal.appearance.insert(QStringLiteral("color-scheme"), quint32(1));
+    SettingsPortal portal;
+    QSignalSpy spy(&portal, &SettingsPortal::updated);
+    portal.start();
+    QVERIFY(spy.wait());
+    QVERIFY(LinuxTheme::portalHints().dark.value_or(false));
+    QVERIFY(!LinuxTheme::portalHints().accentColor.has_value());
+
+    // Signals arrive in order: once the last one is in, the ones before it have
+    // been handled (or ignored) as well.
+    emitSettingChanged("org.gnome.desktop.interface", "color-scheme", quint32(2));
+    emitSettingChanged(kAppearanceNamespace, "contrast", quint32(1));
+    emitSettingChanged(kAppearanceNamespace, "color-scheme", quint32(2));
+    QVERIFY(spy.wait());
+    QCOMPARE(spy.count(), 2);
+    QVERIFY(!LinuxTheme::portalHints().dark.value_or(true));
+
+    emitSettingChanged(kAppearanceNamespace, "accent-color", QVariant::fromValue(AccentColor{ 1, 0, 0 }));
+    QVERIFY(spy.wait());
+    QCOMPARE(spy.count(), 3);
+    const LinuxTheme::ThemeHints hints = LinuxTheme::portalHints();
+    QVERIFY(!hints.dark.value_or(true));
+    QCOMPARE(hints.accentColor.value_or(QColor()), QColor(Qt::red));
+
+    // Out of range means the accent color is not set.
+    emitSettingChanged(kAppearanceNamespace, "accent-color", QVariant::fromValue(AccentColor{ -1, -1, -1 }));
+    QVERIFY(spy.wait());
+    QVERIFY(!LinuxTheme::portalHints().accentColor.has_value());
+}
+
+QTEST_GUILESS_MAIN(SettingsPortalTest)
+
+#include "tst_settingsportal.moc"
@@ -0,0 +1,254 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021-2023 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <QtTest/qtest.h>
+#include <FramelessHelper/Core/private/x11backend_p.h>
+#include <FramelessHelper/Core/private/framelessstatistics_p.h>
+#include <array>
+
+FRAMELESSHELPER_USE_NAMESPACE
+
+static constexpr const xcb_window_t kRootWindow = 1;
+static constexpr const xcb_window_t kWindow = 42;
+
+class X11BackendTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void init();
+    void operationCounts();
+    void batchedAtoms();
+    void propertyRoundTrip();
+    void propertyOffsets();
+    void typeMismatch();
+    void deletedProperty();
+    void globalStatistics();
+
+private:
+    [[nodiscard]] bool hasCount(const X11::Operation operation, const quint64 requests, const quint64 roundTrips) const;
+
+private:
+    X11::RecordingBackend m_backend{ kRootWindow };
+};
+
+bool X11BackendTest::hasCount(const X11::Operation operation, const quint64 requests, const quint64 roundTrips) const
+{
+    const X11::OperationCount count = m_backend.count(operation);
+    return ((count.requests == requests) && (count.roundTrips == roundTrips));
+}
+
+void X11BackendTest::init()
+{
+    m_backend.clear();
+    m_backend.resetCounts();
+}
+
+void X11BackendTest::operationCounts()
+{
+    const xcb_atom_t atom = m_backend.internAtom("_NET_WM_STATE");
+    QVERIFY(atom != XCB_NONE);
+    // The same name gives the same atom, but it's still a request to the server.
+    QCOMPARE(m_backend.internAtom("_NET_WM_STATE"), atom);
+    const quint32 value = 1;
+    m_backend.changeProperty(kWindow, atom, XCB_ATOM_ATOM, 32, &value, 1);
+    std::ignore = m_backend.getProperty(kWindow, atom, XCB_ATOM_ATOM, 1);
+    m_backend.deleteProperty(kWindow, atom);
+    xcb_client_message_event_t event = {};
+    event.response_type = XCB_CLIENT_MESSAGE;
+    event.format = 32;
+    event.window = kWindow;
+    event.type = atom;
+    event.data.data32[0] = 2;
+    m_backend.sendClientMessage(kRootWindow, event);
+    m_backend.ungrabPointer();
+    m_backend.flush();
+    m_backend.flush();
+
+    QVERIFY(hasCount(X11::Operation::InternAtom, 2, 2));
+    QVERIFY(hasCount(X11::Operation::ChangeProperty, 1, 0));
+    QVERIFY(hasCount(X11::Operation::GetProperty, 1, 1));
+    QVERIFY(hasCount(X11::Operation::ListProperties, 0, 0));
+    QVERIFY(hasCount(X11::Operation::DeleteProperty, 1, 0));
+    QVERIFY(hasCount(X11::Operation::SendEvent, 1, 0));
+    QVERIFY(hasCount(X11::Operation::UngrabPointer, 1, 0));
+    QVERIFY(hasCount(X11::Operation::Flush, 2, 0));
+
+    const QList<X11::RecordingBackend::Message> messages = m_backend.messages();
+    QVERIFY(messages.size() == 1);
+    QCOMPARE(messages.constFirst().destination, kRootWindow);
+    QCOMPARE(messages.constFirst().event.type, atom);
+    QCOMPARE(messages.constFirst().event.data.data32[0], quint32(2));
+    QCOMPARE(m_backend.pointerUngrabs(), quint32(1));
+    QCOMPARE(m_backend.flushes(), quint32(2));
+
+    m_backend.resetCounts();
+    const X11::OperationCounts counts = m_backend.counts();
+    for (auto &&count : counts) {
+        QCOMPARE(count.requests, quint64(0));
+        QCOMPARE(count.roundTrips, quint64(0));
+    }
+    // The recorded state survives.
+    QCOMPARE(m_backend.flushes(), quint32(2));
+}
+
+void X11BackendTest::batchedAtoms()
+{
+    static constexpr const std::array<const char *, 3> kNames = { "_NET_SUPPORTED", "_NET_WM_NAME", "UTF8_STRING" };
+    const xcb_atom_t supported = m_backend.internAtom(kNames.at(0));
+    const quint32 value = 0;
+    m_backend.changeProperty(kWindow, supported, XCB_ATOM_ATOM, 32, &value, 1);
+    m_backend.resetCounts();
+
+    const X11::AtomsAndProperties result = m_backend.internAtomsAndListProperties(kNames.data(), int(kNames.size()), kWindow);
+    QVERIFY(result.atoms.size() == kNames.size());
+    QCOMPARE(result.atoms.at(0), supported);
+    QVERIFY(result.atoms.at(1) != XCB_NONE);
+    QVERIFY(result.atoms.at(2) != XCB_NONE);
+    QVERIFY(result.atoms.at(1) != result.atoms.at(2));
+    QVERIFY(result.properties.size() == 1);
+    QCOMPARE(result.properties.front(), supported);
+    // One request per atom plus the property list, and a single round trip for all of them.
+    QVERIFY(hasCount(X11::Operation::InternAtom, kNames.size(), 1));
+    QVERIFY(hasCount(X11::Operation::ListProperties, 1, 0));
+
+    const X11::AtomsAndProperties atomsOnly = m_backend.internAtomsAndListProperties(kNames.data(), int(kNames.size()), XCB_WINDOW_NONE);
+    QVERIFY(atomsOnly.atoms == result.atoms);
+    QVERIFY(atomsOnly.properties.empty());
+    QVERIFY(hasCount(X11::Operation::InternAtom, kNames.size() * 2, 2));
+    QVERIFY(hasCount(X11::Operation::ListProperties, 1, 0));
+}
+
+void X11BackendTest::propertyRoundTrip()
+{
+    const xcb_atom_t prop = m_backend.internAtom("_NET_WM_NAME");
+    const xcb_atom_t utf8 = m_backend.internAtom("UTF8_STRING");
+    static constexpr const char kTitle[] = "FramelessHelper";
+    m_backend.changeProperty(kWindow, prop, utf8, 8, kTitle, quint32(std::size(kTitle) - 1));
+
+    const std::optional<X11::RecordingBackend::Property> stored = m_backend.property(kWindow, prop);
+    QVERIFY(stored.has_value());
+    QCOMPARE(stored->type, utf8);
+    QCOMPARE(stored->format, quint8(8));
+    QCOMPARE(stored->data, QByteArray(kTitle));
+
+    // The length is in 32-bit units.
+    const X11::PropertyReply reply = m_backend.getProperty(kWindow, prop, utf8, 32);
+    QVERIFY(reply.isValid());
+    QCOMPARE(reply.type(), utf8);
+    QCOMPARE(reply.format(), quint8(8));
+    QCOMPARE(reply.bytesAfter(), quint32(0));
+    QCOMPARE(reply.toByteArray(), QByteArray(kTitle));
+    QVERIFY(reply.values<quint8>(utf8).size() == int(std::size(kTitle) - 1));
+    // Wrong format.
+    QVERIFY(reply.values<quint32>().isEmpty());
+
+    // A short read reports what's left.
+    const X11::PropertyReply partial = m_backend.getProperty(kWindow, prop, utf8, 1);
+    QCOMPARE(partial.toByteArray(), QByteArray("Fram"));
+    QCOMPARE(partial.bytesAfter(), quint32(std::size(kTitle) - 1 - 4));
+}
+
+void X11BackendTest::propertyOffsets()
+{
+    const xcb_atom_t prop = m_backend.internAtom("_NET_FRAME_EXTENTS");
+    static constexpr const std::array<quint32, 4> kExtents = { 1, 2, 3, 4 };
+    m_backend.changeProperty(kWindow, prop, XCB_ATOM_CARDINAL, 32, kExtents.data(), quint32(kExtents.size()));
+
+    X11::PropertyFuture future = m_backend.requestProperty(kWindow, prop, XCB_ATOM_CARDINAL, 1, 2);
+    // Nothing to wait for without a server.
+    QVERIFY(!future.isPending());
+    const X11::PropertyReply reply = future.get();
+    const X11::PropertyValues<quint32> values = reply.values<quint32>(XCB_ATOM_CARDINAL);
+    QCOMPARE(values.size(), 2);
+    QCOMPARE(values.at(0), quint32(2));
+    QCOMPARE(values.at(1), quint32(3));
+    QCOMPARE(reply.bytesAfter(), quint32(4));
+
+    // Past the end: no data, nothing left.
+    const X11::PropertyReply tail = m_backend.requestProperty(kWindow, prop, XCB_ATOM_CARDINAL, 8, 1).get();
+    QVERIFY(tail.isValid());
+    QVERIFY(tail.values<quint32>().isEmpty());
+    QCOMPARE(tail.bytesAfter(), quint32(0));
+}
+
+void X11BackendTest::typeMismatch()
+{
+    const xcb_atom_t prop = m_backend.internAtom("_NET_WM_DESKTOP");
+    const quint32 desktop = 3;
+    m_backend.changeProperty(kWindow, prop, XCB_ATOM_CARDINAL, 32, &desktop, 1);
+
+    // Like the server: the actual type and size, but no value.
+    const X11::PropertyReply reply = m_backend.getProperty(kWindow, prop, XCB_ATOM_WINDOW, 1);
+    QVERIFY(reply.isValid());
+    QCOMPARE(reply.type(), xcb_atom_t(XCB_ATOM_CARDINAL));
+    QCOMPARE(reply.format(), quint8(32));
+    QCOMPARE(reply.bytesAfter(), quint32(sizeof(desktop)));
+    QVERIFY(reply.values<quint32>().isEmpty());
+
+    // XCB_NONE takes any type.
+    const X11::PropertyReply any = m_backend.getProperty(kWindow, prop, XCB_NONE, 1);
+    QCOMPARE(any.values<quint32>().size(), 1);
+    QCOMPARE(any.values<quint32>().at(0), desktop);
+    QVERIFY(any.values<quint32>(XCB_ATOM_WINDOW).isEmpty());
+    QVERIFY(hasCount(X11::Operation::GetProperty, 2, 2));
+}
+
+void X11BackendTest::deletedProperty()
+{
+    const xcb_atom_t prop = m_backend.internAtom("_MOTIF_WM_HINTS");
+    const std::array<quint32, 5> hints = { 2, 0, 0, 0, 0 };
+    m_backend.changeProperty(kWindow, prop, prop, 32, hints.data(), quint32(hints.size()));
+    QVERIFY(m_backend.property(kWindow, prop).has_value());
+    m_backend.deleteProperty(kWindow, prop);
+    QVERIFY(!m_backend.property(kWindow, prop).has_value());
+
+    const X11::PropertyReply reply = m_backend.getProperty(kWindow, prop, prop, 5);
+    QVERIFY(reply.isValid());
+    QCOMPARE(reply.type(), xcb_atom_t(XCB_NONE));
+    QVERIFY(reply.values<quint32>().isEmpty());
+    // Properties are per window.
+    m_backend.changeProperty(kWindow, prop, prop, 32, hints.data(), quint32(hints.size()));
+    QVERIFY(!m_backend.property(kWindow + 1, prop).has_value());
+}
+
+void X11BackendTest::globalStatistics()
+{
+    const Global::Statistics before = Stats::snapshot();
+    const xcb_atom_t prop = m_backend.internAtom("_NET_WM_PID");
+    const quint32 pid = 1234;
+    m_backend.changeProperty(kWindow, prop, XCB_ATOM_CARDINAL, 32, &pid, 1);
+    std::ignore = m_backend.getProperty(kWindow, prop, XCB_ATOM_CARDINAL, 1);
+    m_backend.flush();
+    QVERIFY(hasCount(X11::Operation::InternAtom, 1, 1));
+    QVERIFY(hasCount(X11::Operation::Flush, 1, 0));
+    // The simulated traffic stays out of the numbers about the real connection.
+    const Global::Statistics after = Stats::snapshot();
+    QCOMPARE(after.x11RoundTrips, before.x11RoundTrips);
+    QCOMPARE(after.x11Flushes, before.x11Flushes);
+}
+
+QTEST_APPLESS_MAIN(X11BackendTest)
+
+#include "tst_x11backend.moc"
@@ -0,0 +1,148 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021-2023 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <QtTest/qtest.h>
+#include <FramelessHelper/Core/private/x11backend_p.h>
+#include <FramelessHelper/Core/private/x11capabilities_p.h>
+#include <vector>
+
+FRAMELESSHELPER_USE_NAMESPACE
+
+static constexpr const xcb_window_t kRootWindow = 1;
+static constexpr const xcb_window_t kWindowManagerWindow = 42;
+
+class X11CapabilitiesTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void init();
+    void emptyServer();
+    void pipelinedProbe();
+    void largeSupportedList();
+    void currentBackend();
+
+private:
+    [[nodiscard]] xcb_atom_t atom(const X11::Atom which);
+    void setupWindowManager(const std::vector<xcb_atom_t> &supported);
+
+private:
+    X11::RecordingBackend m_backend{ kRootWindow };
+};
+
+xcb_atom_t X11CapabilitiesTest::atom(const X11::Atom which)
+{
+    return m_backend.internAtom(X11::kAtomNames.at(static_cast<int>(which)));
+}
+
+void X11CapabilitiesTest::setupWindowManager(const std::vector<xcb_atom_t> &supported)
+{
+    m_backend.changeProperty(kRootWindow, atom(X11::Atom::NetSupported), XCB_ATOM_ATOM, 32,
+        supported.data(), quint32(supported.size()));
+    m_backend.changeProperty(kRootWindow, atom(X11::Atom::NetSupportingWmCheck), XCB_ATOM_WINDOW, 32,
+        &kWindowManagerWindow, 1);
+    static constexpr const char kName[] = "KWin";
+    m_backend.changeProperty(kWindowManagerWindow, atom(X11::Atom::NetWmName), atom(X11::Atom::Utf8String), 8,
+        kName, quint32(qstrlen(kName)));
+    m_backend.resetCounts();
+}
+
+void X11CapabilitiesTest::init()
+{
+    m_backend.clear();
+    m_backend.resetCounts();
+}
+
+void X11CapabilitiesTest::emptyServer()
+{
+    const X11::Capabilities caps = X11::probeCapabilities(m_backend);
+    QVERIFY(caps.valid);
+    QCOMPARE(caps.rootWindow, kRootWindow);
+    QVERIFY(caps.windowManagerName.isEmpty());
+    QVERIFY(caps.netSupported.isEmpty());
+    QVERIFY(caps.rootWindowProperties.isEmpty());
+    for (auto &&value : caps.atoms) {
+        QVERIFY(value != XCB_NONE);
+    }
+    // The atoms and the property list, then the two root window properties.
+    QCOMPARE(caps.roundTrips, quint32(2));
+}
+
+void X11CapabilitiesTest::pipelinedProbe()
+{
+    const xcb_atom_t moveResize = atom(X11::Atom::NetWmMoveResize);
+    const xcb_atom_t showWindowMenu = atom(X11::Atom::GtkShowWindowMenu);
+    setupWindowManager({ showWindowMenu, moveResize });
+    const X11::Capabilities caps = X11::probeCapabilities(m_backend);
+    QVERIFY(caps.valid);
+    QCOMPARE(caps.windowManagerName, FRAMELESSHELPER_STRING_LITERAL("KWin"));
+    QVERIFY(caps.isSupportedByWindowManager(moveResize));
+    QVERIFY(caps.isSupportedByWindowManager(showWindowMenu));
+    QVERIFY(!caps.isSupportedByWindowManager(caps.atom(X11::Atom::KdeNetWmBlurBehindRegion)));
+    QVERIFY(caps.hasRootWindowProperty(caps.atom(X11::Atom::NetSupported)));
+    QVERIFY(caps.hasRootWindowProperty(caps.atom(X11::Atom::NetSupportingWmCheck)));
+    QVERIFY(!caps.hasRootWindowProperty(caps.atom(X11::Atom::NetWmName)));
+    QCOMPARE(caps.roundTrips, quint32(3));
+    // All the atoms are interned with a single round trip.
+    const X11::OperationCount atoms = m_backend.count(X11::Operation::InternAtom);
+    QCOMPARE(atoms.requests, quint64(X11::kAtomCount));
+    QCOMPARE(atoms.roundTrips, quint64(1));
+    QCOMPARE(m_backend.count(X11::Operation::ListProperties).requests, quint64(1));
+    QCOMPARE(m_backend.count(X11::Operation::GetProperty).requests, quint64(3));
+}
+
+void X11CapabilitiesTest::largeSupportedList()
+{
+    // More than fits into one page of _NET_SUPPORTED.
+    std::vector<xcb_atom_t> supported = {};
+    for (xcb_atom_t i = 0; i != 5000; ++i) {
+        supported.push_back(0x10000 + i);
+    }
+    setupWindowManager(supported);
+    const X11::Capabilities caps = X11::probeCapabilities(m_backend);
+    QVERIFY(caps.netSupported.size() == 5000);
+    QVERIFY(caps.isSupportedByWindowManager(0x10000));
+    QVERIFY(caps.isSupportedByWindowManager(0x10000 + 4999));
+    QCOMPARE(caps.roundTrips, quint32(4));
+    QCOMPARE(m_backend.count(X11::Operation::GetProperty).requests, quint64(4));
+}
+
+void X11CapabilitiesTest::currentBackend()
+{
+    // Everything, including the probe, goes through the installed backend, see tst_x11windowsetup.cpp.
+    auto backend = std::make_unique<X11::RecordingBackend>(kRootWindow);
+    X11::RecordingBackend * const recording = backend.get();
+    std::ignore = X11::setBackend(std::move(backend));
+    const X11::CapabilitiesPtr caps = X11::capabilities();
+    QVERIFY(caps->valid);
+    QCOMPARE(caps->rootWindow, kRootWindow);
+    QCOMPARE(recording->count(X11::Operation::InternAtom).roundTrips, quint64(1));
+    // Cached until the backend changes.
+    QCOMPARE(X11::capabilities(), caps);
+    std::ignore = X11::setBackend(nullptr);
+}
+
+QTEST_APPLESS_MAIN(X11CapabilitiesTest)
+
+#include "tst_x11capabilities.moc"
@@ -0,0 +1,225 @@
+/*
+ * MIT License
+ *
+ * Copyright (C) 2021-2023 by wangwenx190 (Yuhang Zhao)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <QtTest/qtest.h>
+#include <QtGui/qwindow.h>
+#include <FramelessHelper/Core/utils.h>
+#include <FramelessHelper/Core/private/x11backend_p.h>
+#include <FramelessHelper/Core/private/x11capabilities_p.h>
+#include <iterator>
+
+FRAMELESSHELPER_USE_NAMESPACE
+
+static constexpr const xcb_window_t kRootWindow = 1;
+static constexpr const xcb_window_t kWindowManagerWindow = 2;
+static constexpr const WId kWindow = 0x400001;
+
+// The window setup paths of utils_linux.cpp, run against the recording backend: the
+// numbers below are the requests a real X server would get.
+class X11WindowSetupTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanupTestCase();
+    void batchedProperties();
+    void readAfterWrite();
+    void systemMenu();
+    void moveResize();
+    void blurRegion();
+
+private:
+    [[nodiscard]] xcb_atom_t atom(const X11::Atom which) const;
+    [[nodiscard]] quint64 roundTrips() const;
+
+private:
+    X11::RecordingBackend *m_backend = nullptr;
+    xcb_atom_t m_testAtom = XCB_NONE;
+};
+
+xcb_atom_t X11WindowSetupTest::atom(const X11::Atom which) const
+{
+    return X11::capabilities()->atom(which);
+}
+
+quint64 X11WindowSetupTest::roundTrips() const
+{
+    quint64 result = 0;
+    for (auto &&count : m_backend->counts()) {
+        result += count.roundTrips;
+    }
+    return result;
+}
+
+void X11WindowSetupTest::initTestCase()
+{
+    auto backend = std::make_unique<X11::RecordingBackend>(kRootWindow);
+    m_backend = backend.get();
+    std::ignore = X11::setBackend(std::move(backend));
+    const auto intern = [this](const X11::Atom which) -> xcb_atom_t {
+        return m_backend->internAtom(X11::kAtomNames.at(static_cast<int>(which)));
+    };
+    // A window manager with KWin's blur effect loaded.
+    const xcb_atom_t supported[] = { intern(X11::Atom::GtkShowWindowMenu), intern(X11::Atom::NetWmMoveResize) };
+    m_backend->changeProperty(kRootWindow, intern(X11::Atom::NetSupported), XCB_ATOM_ATOM, 32,
+        supported, quint32(std::size(supported)));
+    m_backend->changeProperty(kRootWindow, intern(X11::Atom::NetSupportingWmCheck), XCB_ATOM_WINDOW, 32,
+        &kWindowManagerWindow, 1);
+    static constexpr const char kName[] = "KWin";
+    m_backend->changeProperty(kWindowManagerWindow, intern(X11::Atom::NetWmName), intern(X11::Atom::Utf8String), 8,
+        kName, quint32(qstrlen(kName)));
+    m_backend->changeProperty(kRootWindow, intern(X11::Atom::KdeNetWmBlurBehindRegion), XCB_ATOM_CARDINAL, 32,
+        nullptr, 0);
+    m_testAtom = m_backend->internAtom("_FRAMELESSHELPER_TEST");
+    QVERIFY(X11::capabilities()->valid);
+}
+
+void X11WindowSetupTest::init()
+{
+    // Let any flush scheduled by the previous test run first.
+    QCoreApplication::processEvents();
+    m_backend->resetCounts();
+}
+
+void X11WindowSetupTest::cleanupTestCase()
+{
+    std::ignore = X11::setBackend(nullptr);
+    m_backend = nullptr;
+}
+
+void X11WindowSetupTest::batchedProperties()
+{
+    for (quint32 i = 0; i != 10; ++i) {
+        Utils::setWindowProperty(kWindow, m_testAtom, XCB_ATOM_CARDINAL, &i, 1, sizeof(quint32) * 8);
+    }
+    // Nothing is sent before the event loop gets to the batcher.
+    QCOMPARE(m_backend->count(X11::Operation::ChangeProperty).requests, quint64(0));
+    QCoreApplication::processEvents();
+    // Only the final value is sent, with a single flush and without waiting for the server.
+    QCOMPARE(m_backend->count(X11::Operation::ChangeProperty).requests, quint64(1));
+    QCOMPARE(m_backend->count(X11::Operation::Flush).requests, quint64(1));
+    QCOMPARE(roundTrips(), quint64(0));
+    const auto property = m_backend->property(kWindow, m_testAtom);
+    QVERIFY(property.has_value());
+    QCOMPARE(property->count, quint32(1));
+    QCOMPARE(*reinterpret_cast<const quint32 *>(property->data.constData()), quint32(9));
+}
+
+void X11WindowSetupTest::readAfterWrite()
+{
+    const quint32 value = 42;
+    Utils::setWindowProperty(kWindow, m_testAtom, XCB_ATOM_CARDINAL, &value, 1, sizeof(quint32) * 8);
+    const QByteArray data = Utils::getWindowProperty(kWindow, m_testAtom, XCB_ATOM_CARDINAL, 1);
+    // The queued write goes out ahead of the read, which sees it.
+    QVERIFY(data.size() == sizeof(quint32));
+    QCOMPARE(*reinterpret_cast<const quint32 *>(data.constData()), value);
+    QCOMPARE(m_backend->count(X11::Operation::ChangeProperty).requests, quint64(1));
+    QCOMPARE(m_backend->count(X11::Operation::GetProperty).roundTrips, quint64(1));
+    QCOMPARE(roundTrips(), quint64(1));
+    // The scheduled flush finds the queue empty.
+    QCoreApplication::processEvents();
+    QCOMPARE(m_backend->count(X11::Operation::ChangeProperty).requests, quint64(1));
+    QCOMPARE(m_backend->count(X11::Operation::Flush).requests, quint64(0));
+}
+
+void X11WindowSetupTest::systemMenu()
+{
+    const quint32 value = 1;
+    Utils::setWindowProperty(kWindow, m_testAtom, XCB_ATOM_CARDINAL, &value, 1, sizeof(quint32) * 8);
+    Utils::openSystemMenu(kWindow, QPoint(100, 200));
+    // The pending write, the ungrab and the message, sent right away with one flush.
+    QCOMPARE(m_backend->count(X11::Operation::ChangeProperty).requests, quint64(1));
+    QCOMPARE(m_backend->count(X11::Operation::UngrabPointer).requests, quint64(1));
+    QCOMPARE(m_backend->count(X11::Operation::SendEvent).requests, quint64(1));
+    QCOMPARE(m_backend->count(X11::Operation::Flush).requests, quint64(1));
+    QCOMPARE(roundTrips(), quint64(0));
+    const X11::RecordingBackend::Message message = m_backend->messages().constLast();
+    QCOMPARE(message.destination, kRootWindow);
+    QCOMPARE(message.event.type, atom(X11::Atom::GtkShowWindowMenu));
+    QCOMPARE(message.event.window, xcb_window_t(kWindow));
+    QCOMPARE(message.event.data.data32[1], quint32(100));
+    QCOMPARE(message.event.data.data32[2], quint32(200));
+    QCoreApplication::processEvents();
+    QCOMPARE(m_backend->count(X11::Operation::Flush).requests, quint64(1));
+}
+
+void X11WindowSetupTest::moveResize()
+{
+    Utils::sendMoveResizeMessage(kWindow, _NET_WM_MOVERESIZE_MOVE, QPoint(10, 20));
+    QCOMPARE(m_backend->count(X11::Operation::UngrabPointer).requests, quint64(1));
+    QCOMPARE(m_backend->count(X11::Operation::SendEvent).requests, quint64(1));
+    QCOMPARE(m_backend->count(X11::Operation::Flush).requests, quint64(1));
+    QCOMPARE(roundTrips(), quint64(0));
+    const X11::RecordingBackend::Message message = m_backend->messages().constLast();
+    QCOMPARE(message.destination, kRootWindow);
+    QCOMPARE(message.event.type, atom(X11::Atom::NetWmMoveResize));
+    QCOMPARE(message.event.data.data32[2], quint32(_NET_WM_MOVERESIZE_MOVE));
+    QCOMPARE(message.event.data.data32[3], quint32(XCB_BUTTON_INDEX_1));
+    // Cancelling doesn't take the pointer away from anyone.
+    Utils::sendMoveResizeMessage(kWindow, _NET_WM_MOVERESIZE_CANCEL, QPoint(10, 20));
+    QCOMPARE(m_backend->count(X11::Operation::UngrabPointer).requests, quint64(1));
+    QCOMPARE(m_backend->count(X11::Operation::SendEvent).requests, quint64(2));
+    QCOMPARE(roundTrips(), quint64(0));
+}
+
+void X11WindowSetupTest::blurRegion()
+{
+    QWindow window;
+    window.resize(200, 100);
+    const WId windowId = window.winId();
+    QVERIFY(windowId);
+    const xcb_atom_t blurAtom = atom(X11::Atom::KdeNetWmBlurBehindRegion);
+    QVERIFY(Utils::setBlurBehindWindowRegion(&window, QRect(0, 0, 50, 50), 0));
+    QVERIFY(Utils::setBlurBehindWindowRegion(&window, QRect(0, 0, 300, 30), 0));
+    QCoreApplication::processEvents();
+    // One write with the final region, clipped to the window.
+    QCOMPARE(m_backend->count(X11::Operation::ChangeProperty).requests, quint64(1));
+    QCOMPARE(m_backend->count(X11::Operation::Flush).requests, quint64(1));
+    QCOMPARE(roundTrips(), quint64(0));
+    const auto property = m_backend->property(windowId, blurAtom);
+    QVERIFY(property.has_value());
+    QCOMPARE(property->count, quint32(4));
+    const auto rect = reinterpret_cast<const quint32 *>(property->data.constData());
+    QCOMPARE(rect[2], quint32(200));
+    QCOMPARE(rect[3], quint32(30));
+    // The same region again sends nothing at all.
+    m_backend->resetCounts();
+    QVERIFY(Utils::setBlurBehindWindowRegion(&window, QRect(0, 0, 300, 30), 0));
+    QCoreApplication::processEvents();
+    QCOMPARE(m_backend->count(X11::Operation::ChangeProperty).requests, quint64(0));
+    QCOMPARE(m_backend->count(X11::Operation::Flush).requests, quint64(0));
+    // An empty region removes the property.
+    QVERIFY(Utils::setBlurBehindWindowRegion(&window, QRegion(), 0));
+    QCoreApplication::processEvents();
+    QCOMPARE(m_backend->count(X11::Operation::DeleteProperty).requests, quint64(1));
+    QCOMPARE(m_backend->count(X11::Operation::Flush).requests, quint64(1));
+    QCOMPARE(roundTrips(), quint64(0));
+    QVERIFY(!m_backend->property(windowId, blurAtom).has_value());
+}
+
+QTEST_MAIN(X11WindowSetupTest)
+
+#include "tst_x11windowsetup.moc"